@@ -0,0 +1,27 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+// Helpers shared by the transition benchmark and the regression benchmark matrix
+
+// Phases that do not resync or settle within this time are cut short, such trials and cases count as not resynced
+constexpr double BENCHMARK_PHASE_TIMEOUT_MILLIS = 10000.0;
+
+// Nearest-rank percentile, default value for no samples
+template <typename T>
+T percentile(std::vector<T> sorted, float fraction)
+{
+  if(sorted.empty())
+  {
+    return T();
+  }
+  std::sort(sorted.begin(), sorted.end());
+  const auto rank = static_cast<std::size_t>(std::ceil(fraction * sorted.size()));
+  return sorted[std::clamp<std::size_t>(rank, 1, sorted.size()) - 1];
+}
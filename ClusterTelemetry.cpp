@@ -0,0 +1,405 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <UdpSocket.h>
+
+#include <ClusterTelemetry.h>
+#include <SyncMetrics.h>
+#include <Timing.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <nvh/nvprint.hpp>
+
+namespace {
+std::atomic<bool> g_collectorStop = false;
+
+BOOL WINAPI collectorCtrlHandler(DWORD)
+{
+  g_collectorStop = true;
+  return TRUE;
+}
+}  // namespace
+
+void FrameTimeHistogram::add(double millis)
+{
+  const auto bin = static_cast<std::uint32_t>(std::max(millis, 0.0) / FRAME_TIME_HISTOGRAM_BIN_MILLIS);
+  ++m_bins[std::min(bin, FRAME_TIME_HISTOGRAM_BINS - 1)];
+}
+
+float FrameTimeHistogram::percentile(float fraction) const
+{
+  std::uint64_t total = 0;
+  for(std::uint32_t count : m_bins)
+  {
+    total += count;
+  }
+  if(total == 0)
+  {
+    return 0.0f;
+  }
+
+  const auto    threshold = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(fraction * total)));
+  std::uint64_t sum       = 0;
+  for(std::uint32_t i = 0; i < FRAME_TIME_HISTOGRAM_BINS; ++i)
+  {
+    sum += m_bins[i];
+    if(sum >= threshold)
+    {
+      return (i + 1) * FRAME_TIME_HISTOGRAM_BIN_MILLIS;
+    }
+  }
+  return FRAME_TIME_HISTOGRAM_BINS * FRAME_TIME_HISTOGRAM_BIN_MILLIS;
+}
+
+std::string defaultNodeName()
+{
+  char  computerName[MAX_COMPUTERNAME_LENGTH + 1] = {};
+  DWORD size                                      = sizeof(computerName);
+  return GetComputerNameA(computerName, &size) ? computerName : "unnamed";
+}
+
+bool TelemetryPublisher::open(std::string const& address, std::string const& nodeName, std::uint32_t intervalMillis)
+{
+  close();
+
+  const std::size_t colon = address.rfind(':');
+  if(colon == std::string::npos)
+  {
+    LOGE("Telemetry address must be given as host:port.\n");
+    return false;
+  }
+  const std::string host = address.substr(0, colon);
+  const std::string port = address.substr(colon + 1);
+
+  if(!startupWinsock())
+  {
+    return false;
+  }
+
+  addrinfo hints    = {};
+  hints.ai_family   = AF_INET;
+  hints.ai_socktype = SOCK_DGRAM;
+  hints.ai_protocol = IPPROTO_UDP;
+  addrinfo* result  = nullptr;
+  if(getaddrinfo(host.c_str(), port.c_str(), &hints, &result) != 0 || result == nullptr)
+  {
+    LOGE("Could not resolve telemetry address '%s'.\n", address.c_str());
+    WSACleanup();
+    return false;
+  }
+  std::memcpy(m_address.data(), result->ai_addr, std::min(m_address.size(), static_cast<size_t>(result->ai_addrlen)));
+  m_addressLength  = static_cast<int>(result->ai_addrlen);
+  SOCKET udpSocket = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+  freeaddrinfo(result);
+  if(udpSocket == INVALID_SOCKET)
+  {
+    LOGE("Could not create telemetry socket, error %d.\n", WSAGetLastError());
+    WSACleanup();
+    return false;
+  }
+  // Allow publishing to a broadcast address so no collector address has to be configured on the nodes
+  BOOL broadcast = TRUE;
+  setsockopt(udpSocket, SOL_SOCKET, SO_BROADCAST, reinterpret_cast<char const*>(&broadcast), sizeof(broadcast));
+  m_socket = udpSocket;
+
+  m_nodeName       = nodeName.empty() ? defaultNodeName() : nodeName;
+  m_intervalMillis = std::max(intervalMillis, 1u);
+  m_packets.reset(TelemetryPacket{});
+
+  m_stop   = false;
+  m_thread = std::thread([this]() { sendLoop(); });
+  return true;
+}
+
+void TelemetryPublisher::close()
+{
+  if(m_thread.joinable())
+  {
+    m_stop = true;
+    m_thread.join();
+  }
+  closeSocket(m_socket);
+}
+
+void TelemetryPublisher::sendLoop()
+{
+  TelemetryPacket packet;
+  std::uint64_t   sequence = 0;
+  while(!m_stop)
+  {
+    // Keep sending the last known state even if the render thread stalls so the collector can tell the difference
+    // between a frozen and a disconnected node
+    m_packets.fetch();
+    packet = m_packets.front();
+    std::strncpy(packet.m_nodeName, m_nodeName.c_str(), sizeof(packet.m_nodeName) - 1);
+    packet.m_sequence = ++sequence;
+    if(sendto(static_cast<SOCKET>(m_socket), reinterpret_cast<char const*>(&packet), sizeof(packet), 0,
+              reinterpret_cast<sockaddr const*>(m_address.data()), m_addressLength)
+       == SOCKET_ERROR)
+    {
+      LOGW("Sending telemetry failed with error %d.\n", WSAGetLastError());
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(m_intervalMillis));
+  }
+}
+
+bool TelemetryCollector::open(std::uint16_t port, float minInSyncRatio, float maxDriftPerSecond)
+{
+  close();
+  if(!openUdpSocket(m_socket))
+  {
+    return false;
+  }
+  const SOCKET udpSocket = static_cast<SOCKET>(m_socket);
+
+  sockaddr_in address     = {};
+  address.sin_family      = AF_INET;
+  address.sin_port        = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  if(bind(udpSocket, reinterpret_cast<sockaddr const*>(&address), sizeof(address)) == SOCKET_ERROR)
+  {
+    LOGE("Could not bind telemetry socket to port %u, error %d.\n", port, WSAGetLastError());
+    closeSocket(m_socket);
+    return false;
+  }
+  // Wake up regularly so nodes that stopped sending are detected and close() does not hang
+  DWORD timeoutMillis = 100;
+  setsockopt(udpSocket, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<char const*>(&timeoutMillis), sizeof(timeoutMillis));
+
+  m_minInSyncRatio    = minInSyncRatio;
+  m_maxDriftPerSecond = maxDriftPerSecond;
+  m_nodes.clear();
+  m_lastEvaluation = Clock::now();
+
+  m_stop   = false;
+  m_thread = std::thread([this]() { receiveLoop(); });
+  return true;
+}
+
+void TelemetryCollector::close()
+{
+  if(m_thread.joinable())
+  {
+    m_stop = true;
+    m_thread.join();
+  }
+  closeSocket(m_socket);
+}
+
+std::vector<ClusterNodeStatus> TelemetryCollector::nodes()
+{
+  std::lock_guard                guard(m_mutex);
+  std::vector<ClusterNodeStatus> result;
+  result.reserve(m_nodes.size());
+  for(auto const& node : m_nodes)
+  {
+    result.push_back(node.second.m_status);
+  }
+  return result;
+}
+
+void TelemetryCollector::receiveLoop()
+{
+  while(!m_stop)
+  {
+    TelemetryPacket packet;
+    const int       received = recv(static_cast<SOCKET>(m_socket), reinterpret_cast<char*>(&packet), sizeof(packet), 0);
+    const auto      now      = Clock::now();
+
+    std::lock_guard guard(m_mutex);
+    if(received == sizeof(packet) && packet.m_magic == TELEMETRY_MAGIC && packet.m_version == TELEMETRY_VERSION)
+    {
+      receive(packet, now);
+    }
+    if(now - m_lastEvaluation >= std::chrono::seconds(1))
+    {
+      evaluate(now);
+      m_lastEvaluation = now;
+    }
+  }
+}
+
+void TelemetryCollector::receive(TelemetryPacket const& packet, Clock::time_point now)
+{
+  std::string name(packet.m_nodeName, strnlen(packet.m_nodeName, sizeof(packet.m_nodeName)));
+  auto        it = m_nodes.find(name);
+  if(it == m_nodes.end() || packet.m_sequence < it->second.m_status.m_last.m_sequence)
+  {
+    // New node or restarted instance
+    if(it == m_nodes.end())
+    {
+      LOGI("Telemetry node '%s' connected.\n", name.c_str());
+    }
+    Node node;
+    node.m_windowStart     = packet;
+    node.m_windowStartTime = now;
+    node.m_status.m_name   = name;
+    it                     = m_nodes.insert_or_assign(name, node).first;
+  }
+  it->second.m_status.m_last   = packet;
+  it->second.m_lastReceiveTime = now;
+}
+
+void TelemetryCollector::evaluate(Clock::time_point now)
+{
+  std::vector<float> presentRates;
+  for(auto& entry : m_nodes)
+  {
+    Node&                  node   = entry.second;
+    ClusterNodeStatus&     status = node.m_status;
+    TelemetryPacket const& first  = node.m_windowStart;
+    TelemetryPacket const& last   = status.m_last;
+
+    status.m_secondsSinceUpdate = std::chrono::duration<float>(now - node.m_lastReceiveTime).count();
+    status.m_stale              = status.m_secondsSinceUpdate > 2.0f;
+
+    const float windowSeconds = std::chrono::duration<float>(node.m_lastReceiveTime - node.m_windowStartTime).count();
+    if(last.m_presentCount < first.m_presentCount)
+    {
+      // Present barrier statistics restart when the barrier is re-joined
+      node.m_windowStart     = last;
+      node.m_windowStartTime = node.m_lastReceiveTime;
+    }
+    else if(windowSeconds >= 0.5f)
+    {
+      const std::uint32_t presents = last.m_presentCount - first.m_presentCount;
+      status.m_presentRate         = presents / windowSeconds;
+      status.m_inSyncRatio =
+          presents != 0 ? static_cast<float>(last.m_presentInSyncCount - first.m_presentInSyncCount) / presents : 0.0f;
+      status.m_flipInSyncRatio =
+          presents != 0 ? static_cast<float>(last.m_flipInSyncCount - first.m_flipInSyncCount) / presents : 0.0f;
+
+      FrameTimeHistogram windowFrameTimes;
+      for(std::uint32_t i = 0; i < FRAME_TIME_HISTOGRAM_BINS; ++i)
+      {
+        windowFrameTimes.m_bins[i] = last.m_frameTimes.m_bins[i] - first.m_frameTimes.m_bins[i];
+      }
+      status.m_frameTimeMedian = windowFrameTimes.percentile(0.5f);
+      status.m_frameTimeP99    = windowFrameTimes.percentile(0.99f);
+
+      node.m_windowStart     = last;
+      node.m_windowStartTime = node.m_lastReceiveTime;
+    }
+    if(!status.m_stale)
+    {
+      presentRates.push_back(status.m_presentRate);
+    }
+  }
+
+  float medianPresentRate = 0.0f;
+  if(!presentRates.empty())
+  {
+    std::nth_element(presentRates.begin(), presentRates.begin() + presentRates.size() / 2, presentRates.end());
+    medianPresentRate = presentRates[presentRates.size() / 2];
+  }
+
+  // Frame markers are read back at different times on every node, so each one is extrapolated to the most recent
+  // marker with the median present rate. The result is only meaningful with synchronized node clocks and frame
+  // counts that started together, like the Quadro Sync frame counter.
+  std::uint64_t referenceTime = 0;
+  for(auto& entry : m_nodes)
+  {
+    ClusterNodeStatus const& status = entry.second.m_status;
+    if(!status.m_stale)
+    {
+      referenceTime = std::max(referenceTime, status.m_last.m_markerSystemTime);
+    }
+  }
+  std::vector<double> markerFrames;
+  auto                extrapolatedMarkerFrame = [&](TelemetryPacket const& packet) {
+    const double seconds = static_cast<std::int64_t>(referenceTime - packet.m_markerSystemTime)
+                           / double(SYSTEM_TIME_FREQUENCY);
+    return packet.m_markerFrame + seconds * medianPresentRate;
+  };
+  for(auto& entry : m_nodes)
+  {
+    ClusterNodeStatus const& status = entry.second.m_status;
+    if(!status.m_stale && status.m_last.m_markerSystemTime != 0)
+    {
+      markerFrames.push_back(extrapolatedMarkerFrame(status.m_last));
+    }
+  }
+  double medianMarkerFrame = 0.0;
+  if(!markerFrames.empty())
+  {
+    std::nth_element(markerFrames.begin(), markerFrames.begin() + markerFrames.size() / 2, markerFrames.end());
+    medianMarkerFrame = markerFrames[markerFrames.size() / 2];
+  }
+
+  for(auto& entry : m_nodes)
+  {
+    ClusterNodeStatus& status       = entry.second.m_status;
+    const bool         wasOutOfSync = status.m_outOfSync;
+    const bool         wasDrifting  = status.m_drifting;
+    const bool         wasSkewed    = status.m_frameSkewed;
+
+    status.m_driftPerSecond = status.m_stale ? 0.0f : status.m_presentRate - medianPresentRate;
+    status.m_outOfSync      = !status.m_stale
+                              && (!status.m_last.m_presentBarrierJoined || status.m_inSyncRatio < m_minInSyncRatio);
+    status.m_drifting       = !status.m_stale && status.m_driftPerSecond < -m_maxDriftPerSecond;
+
+    const bool hasMarker = !status.m_stale && status.m_last.m_markerSystemTime != 0;
+    status.m_frameSkew   =
+        hasMarker ? static_cast<float>(extrapolatedMarkerFrame(status.m_last) - medianMarkerFrame) : 0.0f;
+    status.m_frameSkewed = hasMarker && std::abs(status.m_frameSkew) >= 0.5f;
+
+    if(status.m_outOfSync && !wasOutOfSync)
+    {
+      LOGW("Node '%s' is out of sync: %s, %.1f%% presents in sync.\n", status.m_name.c_str(),
+           presentBarrierSyncModeName(status.m_last.m_syncMode), status.m_inSyncRatio * 100.0f);
+    }
+    else if(!status.m_outOfSync && wasOutOfSync)
+    {
+      LOGI("Node '%s' is back in sync.\n", status.m_name.c_str());
+    }
+    if(status.m_drifting && !wasDrifting)
+    {
+      LOGW("Node '%s' falls behind by %.2f presents per second.\n", status.m_name.c_str(), -status.m_driftPerSecond);
+    }
+    if(status.m_frameSkewed && !wasSkewed)
+    {
+      LOGW("Node '%s' presents frame %+.1f frames from the cluster.\n", status.m_name.c_str(), status.m_frameSkew);
+    }
+    else if(!status.m_frameSkewed && wasSkewed)
+    {
+      LOGI("Node '%s' presents the same frame as the cluster again.\n", status.m_name.c_str());
+    }
+  }
+}
+
+int runTelemetryCollector(std::uint16_t port, float minInSyncRatio, float maxDriftPerSecond)
+{
+  TelemetryCollector collector;
+  if(!collector.open(port, minInSyncRatio, maxDriftPerSecond))
+  {
+    return EXIT_FAILURE;
+  }
+  SetConsoleCtrlHandler(collectorCtrlHandler, TRUE);
+  LOGI("Collecting present barrier telemetry on UDP port %u, press Ctrl+C to stop.\n", port);
+
+  while(!g_collectorStop)
+  {
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    std::vector<ClusterNodeStatus> nodes = collector.nodes();
+    LOGI("%-24s %-12s %10s %8s %9s %8s %8s %8s %9s %8s %s\n", "node", "sync mode", "presents/s", "in sync",
+         "flip sync", "drift/s", "p99 ms", "wake us", "margin us", "skew fr", "status");
+    for(ClusterNodeStatus const& node : nodes)
+    {
+      char const* status = node.m_stale ?
+                               "STALE" :
+                               (node.m_outOfSync ? "OUT OF SYNC" :
+                                                   (node.m_drifting ? "DRIFTING" :
+                                                                      (node.m_frameSkewed ? "FRAME SKEW" : "ok")));
+      LOGI("%-24s %-12s %10.2f %7.1f%% %8.1f%% %8.2f %8.1f %8.0f %9.0f %8.1f %s\n", node.m_name.c_str(),
+           presentBarrierSyncModeName(node.m_last.m_syncMode), node.m_presentRate, node.m_inSyncRatio * 100.0f,
+           node.m_flipInSyncRatio * 100.0f, node.m_driftPerSecond, node.m_frameTimeP99,
+           node.m_last.m_wakeLatencyMaxMicros, node.m_last.m_vblankMarginMinMicros, node.m_frameSkew, status);
+    }
+  }
+
+  collector.close();
+  return EXIT_SUCCESS;
+}
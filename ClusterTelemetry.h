@@ -0,0 +1,148 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <ControlPlane.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Lightweight UDP telemetry between instances running on the nodes of a cluster. Every instance can publish its
+// present barrier statistics, one instance (or a headless collector started with -collector) aggregates them and
+// flags nodes that fall out of sync.
+
+constexpr std::uint32_t TELEMETRY_MAGIC                 = 0x4d544250;  // 'PBTM'
+constexpr std::uint32_t TELEMETRY_VERSION               = 4;
+constexpr std::uint32_t FRAME_TIME_HISTOGRAM_BINS       = 64;
+constexpr float         FRAME_TIME_HISTOGRAM_BIN_MILLIS = 0.5f;
+
+// Fixed-size histogram of frame times, the last bin also counts all frames exceeding the histogram range
+struct FrameTimeHistogram
+{
+  std::uint32_t m_bins[FRAME_TIME_HISTOGRAM_BINS] = {};
+
+  void add(double millis);
+  // Upper bound of the bin below which the given fraction of all samples lies, 0 if there are no samples
+  float percentile(float fraction) const;
+};
+
+// Node state as it is sent over the network, only fixed-size members so it can be sent as is
+struct TelemetryPacket
+{
+  std::uint32_t      m_magic                = TELEMETRY_MAGIC;
+  std::uint32_t      m_version              = TELEMETRY_VERSION;
+  char               m_nodeName[32]         = {};
+  std::uint64_t      m_sequence             = 0;
+  std::uint64_t      m_frameIndex           = 0;
+  std::uint32_t      m_presentBarrierJoined = 0;
+  std::uint32_t      m_syncMode             = 0;
+  std::uint32_t      m_presentCount         = 0;
+  std::uint32_t      m_presentInSyncCount   = 0;
+  std::uint32_t      m_flipInSyncCount      = 0;
+  std::uint32_t      m_refreshCount         = 0;
+  FrameTimeHistogram m_frameTimes;
+  std::uint64_t      m_affinityMask          = 0;  // render thread scheduling as applied
+  std::int32_t       m_threadPriority        = 0;
+  std::uint32_t      m_timerResolutionMillis = 0;
+  char               m_mmcssTask[16]         = {};
+  float              m_wakeLatencyMeanMicros = 0.0f;  // render thread wake-up latency over the last second
+  float              m_wakeLatencyMaxMicros  = 0.0f;
+  float              m_vblankMarginMinMicros = 0.0f;  // present to vblank over the last second, 0 if not probed
+  std::uint32_t      m_markerFrame           = 0;  // last frame marker read back from a back buffer
+  std::uint32_t      m_markerNodeId          = 0;
+  std::uint64_t      m_markerSystemTime      = 0;  // FILETIME of the marker frame's Present, 0 without -framemarker
+};
+
+// Computer name, used as node name unless one is given
+std::string defaultNodeName();
+
+class TelemetryPublisher
+{
+public:
+  ~TelemetryPublisher() { close(); }
+
+  // address is "host:port", an empty node name uses the computer name
+  bool open(std::string const& address, std::string const& nodeName, std::uint32_t intervalMillis);
+  void close();
+  bool isOpen() const { return m_thread.joinable(); }
+
+  // Render thread only, never blocks; the most recent state is sent with the next interval
+  void update(TelemetryPacket const& packet) { m_packets.publish(packet); }
+
+private:
+  TripleBuffer<TelemetryPacket> m_packets;
+  std::thread                   m_thread;
+  std::atomic<bool>             m_stop           = false;
+  std::uintptr_t                m_socket         = ~std::uintptr_t(0);
+  std::array<char, 128>         m_address        = {};  // sockaddr_storage of the collector
+  int                           m_addressLength  = 0;
+  std::uint32_t                 m_intervalMillis = 100;
+  std::string                   m_nodeName;
+
+  void sendLoop();
+};
+
+struct ClusterNodeStatus
+{
+  std::string     m_name;
+  TelemetryPacket m_last;
+  float           m_secondsSinceUpdate = 0.0f;
+  float           m_presentRate        = 0.0f;  // presents per second over the last evaluation window
+  float           m_inSyncRatio        = 1.0f;  // PresentInSyncCount / PresentCount over the last window
+  float           m_flipInSyncRatio    = 1.0f;  // FlipInSyncCount / PresentCount over the last window
+  float           m_driftPerSecond     = 0.0f;  // present rate relative to the cluster median
+  float           m_frameTimeMedian    = 0.0f;
+  float           m_frameTimeP99       = 0.0f;
+  float           m_frameSkew          = 0.0f;  // frame marker relative to the cluster median, in frames
+  bool            m_stale              = false;
+  bool            m_outOfSync          = false;
+  bool            m_drifting           = false;
+  bool            m_frameSkewed        = false;
+};
+
+class TelemetryCollector
+{
+public:
+  ~TelemetryCollector() { close(); }
+
+  bool open(std::uint16_t port, float minInSyncRatio, float maxDriftPerSecond);
+  void close();
+  bool isOpen() const { return m_thread.joinable(); }
+
+  // Copy of the most recent evaluation, sorted by node name
+  std::vector<ClusterNodeStatus> nodes();
+
+private:
+  using Clock = std::chrono::steady_clock;
+  struct Node
+  {
+    TelemetryPacket   m_windowStart;
+    Clock::time_point m_windowStartTime;
+    Clock::time_point m_lastReceiveTime;
+    ClusterNodeStatus m_status;
+  };
+
+  std::thread                 m_thread;
+  std::atomic<bool>           m_stop              = false;
+  std::uintptr_t              m_socket            = ~std::uintptr_t(0);
+  float                       m_minInSyncRatio    = 0.99f;
+  float                       m_maxDriftPerSecond = 0.5f;
+  std::mutex                  m_mutex;
+  std::map<std::string, Node> m_nodes;
+  Clock::time_point           m_lastEvaluation;
+
+  void receiveLoop();
+  void receive(TelemetryPacket const& packet, Clock::time_point now);
+  void evaluate(Clock::time_point now);
+};
+
+// Headless collector mode of the executable, runs until the console is closed or Ctrl+C is pressed
+int runTelemetryCollector(std::uint16_t port, float minInSyncRatio, float maxDriftPerSecond);
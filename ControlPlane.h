@@ -0,0 +1,99 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Lock-free single-producer/single-consumer primitives used to hand data from the window (GLFW) thread to the render
+// thread without ever blocking the render loop.
+
+// Triple buffer for publishing complete snapshots of a trivially copyable value. The producer always writes into a
+// private back buffer and swaps it with the shared middle buffer, the consumer swaps the middle buffer with its front
+// buffer whenever a new snapshot was published. Neither side ever waits for the other one.
+template <typename T>
+class TripleBuffer
+{
+public:
+  void reset(T const& value)
+  {
+    m_buffers[0] = value;
+    m_buffers[1] = value;
+    m_buffers[2] = value;
+    m_backIndex  = 0;
+    m_middle.store(1, std::memory_order_release);
+    m_frontIndex = 2;
+  }
+
+  // Producer side: publishes a new snapshot which replaces any snapshot the consumer did not pick up yet
+  void publish(T const& value)
+  {
+    m_buffers[m_backIndex] = value;
+    m_backIndex            = m_middle.exchange(m_backIndex | DIRTY_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+  }
+
+  // Consumer side: makes the most recently published snapshot available through front(), returns false if nothing
+  // new was published since the last call
+  bool fetch()
+  {
+    if((m_middle.load(std::memory_order_relaxed) & DIRTY_BIT) == 0)
+    {
+      return false;
+    }
+    m_frontIndex = m_middle.exchange(m_frontIndex, std::memory_order_acq_rel) & INDEX_MASK;
+    return true;
+  }
+
+  T const& front() const { return m_buffers[m_frontIndex]; }
+
+private:
+  static constexpr std::uint32_t INDEX_MASK = 0x3;
+  static constexpr std::uint32_t DIRTY_BIT  = 0x4;
+
+  T                          m_buffers[3] = {};
+  std::uint32_t              m_backIndex  = 0;
+  std::atomic<std::uint32_t> m_middle     = 1;
+  std::uint32_t              m_frontIndex = 2;
+};
+
+// Bounded ring buffer queue. push() fails instead of blocking when the queue is full.
+template <typename T, std::size_t Capacity>
+class SpscQueue
+{
+public:
+  // Producer side
+  bool push(T const& value)
+  {
+    const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+    const std::size_t next = (tail + 1) % Capacity;
+    if(next == m_head.load(std::memory_order_acquire))
+    {
+      return false;
+    }
+    m_items[tail] = value;
+    m_tail.store(next, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side
+  bool pop(T& value)
+  {
+    const std::size_t head = m_head.load(std::memory_order_relaxed);
+    if(head == m_tail.load(std::memory_order_acquire))
+    {
+      return false;
+    }
+    value = m_items[head];
+    m_head.store((head + 1) % Capacity, std::memory_order_release);
+    return true;
+  }
+
+private:
+  static_assert(Capacity > 1, "SpscQueue needs a capacity of at least two");
+
+  T                        m_items[Capacity] = {};
+  std::atomic<std::size_t> m_head            = 0;
+  std::atomic<std::size_t> m_tail            = 0;
+};
@@ -0,0 +1,224 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <FenceWaiter.h>
+#include <Timing.h>
+
+#include <algorithm>
+#include <cmath>
+#include <nvdx12/error_dx12.hpp>
+#include <nvh/nvprint.hpp>
+
+bool parseFenceWaitStrategy(std::string const& name, FenceWaitStrategy& strategy)
+{
+  if(name == "e" || name == "event")
+  {
+    strategy = FenceWaitStrategy::EVENT;
+  }
+  else if(name == "s" || name == "spin")
+  {
+    strategy = FenceWaitStrategy::SPIN;
+  }
+  else if(name == "h" || name == "hybrid")
+  {
+    strategy = FenceWaitStrategy::HYBRID;
+  }
+  else
+  {
+    return false;
+  }
+  return true;
+}
+
+char const* fenceWaitStrategyName(FenceWaitStrategy strategy)
+{
+  switch(strategy)
+  {
+    case FenceWaitStrategy::EVENT:
+      return "event";
+    case FenceWaitStrategy::SPIN:
+      return "spin";
+    case FenceWaitStrategy::HYBRID:
+      return "hybrid";
+    default:
+      return "unknown";
+  }
+}
+
+void WakeLatencyHistogram::add(std::int64_t ticks)
+{
+  const std::int64_t micros = ticks * 1000000 / qpcFrequency();
+  std::uint32_t      bin    = 0;
+  while(bin < WAKE_LATENCY_HISTOGRAM_BINS - 1 && (std::int64_t(1) << bin) <= micros)
+  {
+    ++bin;
+  }
+  ++m_bins[bin];
+  ++m_count;
+}
+
+float WakeLatencyHistogram::percentileMicros(float fraction) const
+{
+  if(m_count == 0)
+  {
+    return 0.0f;
+  }
+
+  const auto    threshold = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(fraction * m_count)));
+  std::uint64_t sum       = 0;
+  for(std::uint32_t i = 0; i < WAKE_LATENCY_HISTOGRAM_BINS; ++i)
+  {
+    sum += m_bins[i];
+    if(sum >= threshold)
+    {
+      return static_cast<float>(std::uint32_t(1) << i);
+    }
+  }
+  return static_cast<float>(std::uint32_t(1) << (WAKE_LATENCY_HISTOGRAM_BINS - 1));
+}
+
+bool FenceWaiter::init(FenceWaitStrategy strategy, std::uint32_t spinMicros)
+{
+  deinit();
+  m_strategy  = strategy;
+  m_spinTicks = static_cast<std::int64_t>(spinMicros) * qpcFrequency() / 1000000;
+  m_histogram = {};
+  if(m_strategy != FenceWaitStrategy::HYBRID)
+  {
+    return true;
+  }
+
+  if(spinMicros == 0)
+  {
+    LOGE("Hybrid fence waits require a spin window.\n");
+    return false;
+  }
+  // Regular timers may fire a scheduler quantum late, the spin window should account for it then
+  bool highResolution = false;
+  m_timer             = createPreciseTimer(highResolution);
+  if(m_timer != NULL && !highResolution)
+  {
+    LOGW("High resolution timers are not available, hybrid fence waits may wake up late.\n");
+  }
+  if(m_timer == NULL)
+  {
+    HR_CHECK(HRESULT_FROM_WIN32(GetLastError()));
+    return false;
+  }
+  return true;
+}
+
+void FenceWaiter::deinit()
+{
+  if(m_timer != NULL)
+  {
+    CloseHandle(m_timer);
+    m_timer = NULL;
+  }
+  m_lastCompletion   = 0;
+  m_completionPeriod = 0;
+}
+
+bool FenceWaiter::wait(ID3D12Fence* fence, UINT64 value, HANDLE event, DWORD timeoutMillis)
+{
+  const std::int64_t begin = qpcNow();
+  if(fence->GetCompletedValue() >= value)
+  {
+    m_lastCompletion = 0;
+    return true;
+  }
+  const std::int64_t deadline = begin + static_cast<std::int64_t>(timeoutMillis) * qpcFrequency() / 1000;
+
+  bool completed = false;
+  switch(m_strategy)
+  {
+    case FenceWaitStrategy::SPIN:
+      completed = spin(fence, value, deadline);
+      break;
+    case FenceWaitStrategy::HYBRID:
+    {
+      // The fences are waited for once per frame, so the next completion is expected a frame after the previous one
+      const std::int64_t expected =
+          m_lastCompletion != 0 && m_completionPeriod != 0 ? m_lastCompletion + m_completionPeriod : 0;
+      if(expected - m_spinTicks > begin)
+      {
+        // Sleep until the fence completes or the spin window starts, whichever comes first
+        HR_CHECK(fence->SetEventOnCompletion(value, event));
+        LARGE_INTEGER dueTime;
+        dueTime.QuadPart = -((expected - m_spinTicks - begin) * 10000000 / qpcFrequency());  // relative, 100 ns units
+        if(SetWaitableTimerEx(m_timer, &dueTime, 0, nullptr, nullptr, nullptr, 0))
+        {
+          const HANDLE handles[2] = {event, m_timer};
+          WaitForMultipleObjects(2, handles, FALSE, timeoutMillis);
+          CancelWaitableTimer(m_timer);
+        }
+        completed = fence->GetCompletedValue() >= value;
+      }
+      if(!completed)
+      {
+        const std::int64_t spinEnd = std::max(expected, qpcNow()) + m_spinTicks;
+        completed                  = spin(fence, value, std::min(spinEnd, deadline));
+      }
+      if(!completed)
+      {
+        completed = waitEvent(fence, value, event, deadline);
+      }
+      break;
+    }
+    default:
+      completed = waitEvent(fence, value, event, deadline);
+      break;
+  }
+  if(!completed)
+  {
+    m_lastCompletion = 0;
+    return false;
+  }
+
+  const std::int64_t now = qpcNow();
+  if(m_lastCompletion != 0)
+  {
+    const std::int64_t period = now - m_lastCompletion;
+    m_completionPeriod =
+        m_completionPeriod == 0 ? period : m_completionPeriod + (period - m_completionPeriod) / 16;
+  }
+  m_lastCompletion = now;
+  return true;
+}
+
+bool FenceWaiter::waitEvent(ID3D12Fence* fence, UINT64 value, HANDLE event, std::int64_t deadline)
+{
+  while(fence->GetCompletedValue() < value)
+  {
+    const std::int64_t now = qpcNow();
+    if(now >= deadline)
+    {
+      return false;
+    }
+    HR_CHECK(fence->SetEventOnCompletion(value, event));
+    const DWORD millis = static_cast<DWORD>((deadline - now) * 1000 / qpcFrequency() + 1);
+    switch(WaitForSingleObject(event, millis))
+    {
+      case WAIT_OBJECT_0:
+      case WAIT_TIMEOUT:
+        break;
+      default:
+        HR_CHECK(HRESULT_FROM_WIN32(GetLastError()));
+        return false;
+    }
+  }
+  return true;
+}
+
+bool FenceWaiter::spin(ID3D12Fence* fence, UINT64 value, std::int64_t until)
+{
+  while(fence->GetCompletedValue() < value)
+  {
+    if(qpcNow() >= until)
+    {
+      return false;
+    }
+    YieldProcessor();
+  }
+  return true;
+}
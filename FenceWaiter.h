@@ -0,0 +1,64 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <d3d12.h>
+
+enum class FenceWaitStrategy
+{
+  EVENT,   // SetEventOnCompletion and a blocking wait, the OS scheduler decides when the thread runs again
+  SPIN,    // poll GetCompletedValue, burns a core but sees the completion right away
+  HYBRID,  // block until a spin window before the expected completion, then poll
+};
+
+bool        parseFenceWaitStrategy(std::string const& name, FenceWaitStrategy& strategy);
+char const* fenceWaitStrategyName(FenceWaitStrategy strategy);
+
+constexpr std::uint32_t WAKE_LATENCY_HISTOGRAM_BINS = 16;
+
+// Power of two bins in microseconds: bin 0 counts wake-ups within 1 us, bin i those below 2^i us, the last bin also
+// counts all longer ones. Spin and event waits differ by orders of magnitude, so linear bins would hide one of them.
+struct WakeLatencyHistogram
+{
+  std::uint32_t m_bins[WAKE_LATENCY_HISTOGRAM_BINS] = {};
+  std::uint64_t m_count                             = 0;
+
+  void add(std::int64_t ticks);
+  // Upper bound in microseconds of the bin below which the given fraction of all samples lies, 0 without samples
+  float percentileMicros(float fraction) const;
+};
+
+// Waits for a fence to reach a value with the configured strategy. Every event wait registers the event again and
+// checks the fence after waking up, so stale signals of earlier waits on the same auto-reset event never end a wait
+// early.
+class FenceWaiter
+{
+public:
+  ~FenceWaiter() { deinit(); }
+
+  bool init(FenceWaitStrategy strategy, std::uint32_t spinMicros);
+  void deinit();
+
+  FenceWaitStrategy strategy() const { return m_strategy; }
+
+  // False if the fence did not reach the value within the timeout
+  bool wait(ID3D12Fence* fence, UINT64 value, HANDLE event, DWORD timeoutMillis);
+
+  // The caller measures the latency against the GPU timestamp of the completion
+  WakeLatencyHistogram&       histogram() { return m_histogram; }
+  WakeLatencyHistogram const& histogram() const { return m_histogram; }
+
+private:
+  FenceWaitStrategy    m_strategy         = FenceWaitStrategy::EVENT;
+  HANDLE               m_timer            = NULL;
+  std::int64_t         m_spinTicks        = 0;
+  std::int64_t         m_lastCompletion   = 0;  // when the previous wait saw its fence complete, 0 if it didn't wait
+  std::int64_t         m_completionPeriod = 0;  // smoothed time between the completions of consecutive waits
+  WakeLatencyHistogram m_histogram;
+
+  bool waitEvent(ID3D12Fence* fence, UINT64 value, HANDLE event, std::int64_t deadline);
+  bool spin(ID3D12Fence* fence, UINT64 value, std::int64_t until);
+};
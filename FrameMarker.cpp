@@ -0,0 +1,125 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <FrameMarker.h>
+
+#include <nvdx12/error_dx12.hpp>
+#include <nvh/nvprint.hpp>
+
+namespace {
+// The row through the cell centers is all that is decoded
+constexpr UINT MARKER_ROW = FRAME_MARKER_CELL_SIZE / 2;
+
+std::uint32_t checkWord(std::uint32_t frame, std::uint32_t nodeId)
+{
+  return (frame ^ (frame >> 16) ^ nodeId ^ 0xa5a5) & 0xffff;
+}
+}  // namespace
+
+bool FrameMarker::init(ID3D12Device* device, UINT frameSlots, DXGI_FORMAT backBufferFormat)
+{
+  deinit();
+  if(backBufferFormat != DXGI_FORMAT_R8G8B8A8_UNORM && backBufferFormat != DXGI_FORMAT_B8G8R8A8_UNORM)
+  {
+    LOGE("Frame markers need an 8 bit per channel back buffer.\n");
+    return false;
+  }
+  const UINT alignment = D3D12_TEXTURE_DATA_PITCH_ALIGNMENT;
+  m_format             = backBufferFormat;
+  m_rowPitch           = (FRAME_MARKER_WIDTH * 4 + alignment - 1) & ~(alignment - 1);
+
+  m_slots.resize(frameSlots);
+  CD3DX12_HEAP_PROPERTIES readbackHeapProps(D3D12_HEAP_TYPE_READBACK);
+  CD3DX12_RESOURCE_DESC   readbackDesc = CD3DX12_RESOURCE_DESC::Buffer(m_rowPitch);
+  for(Slot& slot : m_slots)
+  {
+    HR_CHECK(device->CreateCommittedResource(&readbackHeapProps, D3D12_HEAP_FLAG_NONE, &readbackDesc,
+                                             D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&slot.m_readback)));
+    slot.m_readback->SetName(L"frame_marker_readback");
+  }
+  m_mismatches = 0;
+  return true;
+}
+
+void FrameMarker::deinit()
+{
+  m_slots.clear();
+}
+
+MarkerConstants FrameMarker::encode(std::uint32_t frame, std::uint32_t nodeId)
+{
+  MarkerConstants constants;
+  constants.frame        = frame;
+  constants.nodeAndCheck = (nodeId & 0xffff) | (checkWord(frame, nodeId & 0xffff) << 16);
+  constants.cellSize     = FRAME_MARKER_CELL_SIZE;
+  constants.padding      = 0;
+  return constants;
+}
+
+void FrameMarker::copy(ID3D12GraphicsCommandList* commandList, ID3D12Resource* backBuffer, UINT frameSlot,
+                       std::uint32_t frame, std::uint32_t nodeId)
+{
+  Slot& slot = m_slots[frameSlot];
+
+  D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = {};
+  footprint.Footprint.Format                   = m_format;
+  footprint.Footprint.Width                    = FRAME_MARKER_WIDTH;
+  footprint.Footprint.Height                   = 1;
+  footprint.Footprint.Depth                    = 1;
+  footprint.Footprint.RowPitch                 = m_rowPitch;
+  const CD3DX12_TEXTURE_COPY_LOCATION destination(slot.m_readback.Get(), footprint);
+  const CD3DX12_TEXTURE_COPY_LOCATION source(backBuffer, 0);
+  const D3D12_BOX                     box = {0, MARKER_ROW, 0, FRAME_MARKER_WIDTH, MARKER_ROW + 1, 1};
+  commandList->CopyTextureRegion(&destination, 0, 0, 0, &source, &box);
+
+  slot.m_expected.m_frame             = frame;
+  slot.m_expected.m_nodeId            = nodeId & 0xffff;
+  slot.m_expected.m_presentSystemTime = 0;
+  slot.m_copied                       = true;
+}
+
+void FrameMarker::setPresentTime(UINT frameSlot, std::uint64_t systemTime)
+{
+  m_slots[frameSlot].m_expected.m_presentSystemTime = systemTime;
+}
+
+bool FrameMarker::read(UINT frameSlot, FrameMarkerValue& value)
+{
+  Slot& slot = m_slots[frameSlot];
+  if(!slot.m_copied)
+  {
+    return false;
+  }
+
+  D3D12_RANGE readRange{0, FRAME_MARKER_WIDTH * 4};
+  void*       mapped = nullptr;
+  HR_CHECK(slot.m_readback->Map(0, &readRange, &mapped));
+  std::uint8_t const* data = static_cast<std::uint8_t const*>(mapped);
+  // Sample the green channel in the cell centers, it is at the same offset in RGBA and BGRA
+  std::uint64_t bits = 0;
+  for(std::uint32_t bit = 0; bit < FRAME_MARKER_BITS; ++bit)
+  {
+    const std::uint32_t x = bit * FRAME_MARKER_CELL_SIZE + FRAME_MARKER_CELL_SIZE / 2;
+    if(data[x * 4 + 1] >= 128)
+    {
+      bits |= std::uint64_t(1) << bit;
+    }
+  }
+  D3D12_RANGE writtenRange{0, 0};
+  slot.m_readback->Unmap(0, &writtenRange);
+  slot.m_copied = false;
+
+  const std::uint32_t frame        = static_cast<std::uint32_t>(bits);
+  const std::uint32_t nodeAndCheck = static_cast<std::uint32_t>(bits >> 32);
+  value.m_frame                    = frame;
+  value.m_nodeId                   = nodeAndCheck & 0xffff;
+  value.m_presentSystemTime        = slot.m_expected.m_presentSystemTime;
+  value.m_valid                    = (nodeAndCheck >> 16) == checkWord(frame, value.m_nodeId)
+                                     && frame == slot.m_expected.m_frame && value.m_nodeId == slot.m_expected.m_nodeId;
+  if(!value.m_valid && m_mismatches++ == 0)
+  {
+    LOGW("Frame marker of frame %u reads back as frame %u of node %u, the back buffer is not what was rendered.\n",
+         slot.m_expected.m_frame, value.m_frame, value.m_nodeId);
+  }
+  return true;
+}
@@ -0,0 +1,69 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <d3dx12.h>
+#include <wrl/client.h>
+using Microsoft::WRL::ComPtr;
+
+// A machine-readable frame ID in the top left corner of every back buffer: one row of black and white cells with the
+// frame count, a node id and a check word. The pixel row through the cell centers is copied into a readback buffer of
+// the frame slot right before Present and decoded once the slot is reused, so confirming what a node presented never
+// stalls and needs no camera.
+
+constexpr std::uint32_t FRAME_MARKER_BITS      = 64;
+constexpr std::uint32_t FRAME_MARKER_CELL_SIZE = 8;  // in pixels
+constexpr std::uint32_t FRAME_MARKER_WIDTH     = FRAME_MARKER_BITS * FRAME_MARKER_CELL_SIZE;
+
+// Must match the MarkerConstants cbuffer in marker_ps.hlsl
+struct MarkerConstants
+{
+  uint32_t frame;
+  uint32_t nodeAndCheck;  // node id in the low, check word in the high 16 bits
+  uint32_t cellSize;
+  uint32_t padding;
+};
+
+struct FrameMarkerValue
+{
+  std::uint32_t m_frame             = 0;
+  std::uint32_t m_nodeId            = 0;
+  std::uint64_t m_presentSystemTime = 0;      // of the frame's Present, see systemTimeNow()
+  bool          m_valid             = false;  // decoded and equal to what was drawn
+};
+
+class FrameMarker
+{
+public:
+  ~FrameMarker() { deinit(); }
+
+  bool init(ID3D12Device* device, UINT frameSlots, DXGI_FORMAT backBufferFormat);
+  void deinit();
+
+  static MarkerConstants encode(std::uint32_t frame, std::uint32_t nodeId);
+
+  // The back buffer must be in the copy source state, slot 0 of a stereo back buffer is the first eye
+  void copy(ID3D12GraphicsCommandList* commandList, ID3D12Resource* backBuffer, UINT frameSlot, std::uint32_t frame,
+            std::uint32_t nodeId);
+  void setPresentTime(UINT frameSlot, std::uint64_t systemTime);
+
+  // Only valid once the GPU finished the frame last copied into the slot, false if nothing was copied
+  bool          read(UINT frameSlot, FrameMarkerValue& value);
+  std::uint64_t mismatches() const { return m_mismatches; }
+
+private:
+  struct Slot
+  {
+    ComPtr<ID3D12Resource> m_readback;
+    FrameMarkerValue       m_expected;
+    bool                   m_copied = false;
+  };
+
+  std::vector<Slot> m_slots;
+  DXGI_FORMAT       m_format     = DXGI_FORMAT_UNKNOWN;
+  UINT              m_rowPitch   = 0;
+  std::uint64_t     m_mismatches = 0;
+};
@@ -0,0 +1,214 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <FrameRecorder.h>
+#include <Timing.h>
+
+#include <chrono>
+#include <iomanip>
+#include <nvh/nvprint.hpp>
+
+namespace {
+struct BinaryFileHeader
+{
+  char          m_magic[4]     = {'P', 'B', 'F', 'R'};
+  std::uint32_t m_version      = 9;
+  std::uint32_t m_recordSize   = sizeof(FrameRecord);
+  std::uint32_t m_reserved     = 0;
+  std::int64_t  m_qpcFrequency = 0;
+  std::int64_t  m_startTime    = 0;
+};
+}  // namespace
+
+bool rotateFile(std::ofstream& file, std::string const& path, std::ios::openmode mode)
+{
+  file.close();
+  const std::string rotatedPath = path + ".1";
+  if(!MoveFileExA(path.c_str(), rotatedPath.c_str(), MOVEFILE_REPLACE_EXISTING))
+  {
+    LOGW("Could not rename '%s' to '%s', error %lu.\n", path.c_str(), rotatedPath.c_str(), GetLastError());
+  }
+  file.open(path, mode | std::ios::trunc);
+  if(!file.is_open())
+  {
+    LOGE("Could not open '%s' again after rotating it.\n", path.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool FrameRecorder::open(std::string const& path, FrameRecordFormat format, std::uint32_t capacity,
+                         std::uint64_t maxFileBytes)
+{
+  close();
+  if(capacity < 2)
+  {
+    LOGE("Frame recorder capacity must be at least 2 frames.\n");
+    return false;
+  }
+
+  m_file.open(path, format == FrameRecordFormat::BINARY ? std::ios::out | std::ios::binary : std::ios::out);
+  if(!m_file.is_open())
+  {
+    LOGE("Could not open frame record file '%s'.\n", path.c_str());
+    return false;
+  }
+
+  // All memory used while recording is allocated up front
+  m_ring.resize(capacity);
+  m_head         = 0;
+  m_tail         = 0;
+  m_dropped      = 0;
+  m_stop         = false;
+  m_format       = format;
+  m_startTime    = qpcNow();
+  m_path         = path;
+  m_maxFileBytes = maxFileBytes;
+  writeHeader();
+
+  m_writer = std::thread([this]() { writerLoop(); });
+  return true;
+}
+
+void FrameRecorder::close()
+{
+  if(!m_writer.joinable())
+  {
+    return;
+  }
+  m_stop = true;
+  m_writer.join();
+  m_file.close();
+  if(m_dropped != 0)
+  {
+    LOGW("Frame recorder dropped %llu records, consider increasing the record capacity.\n",
+         static_cast<unsigned long long>(m_dropped.load()));
+  }
+}
+
+void FrameRecorder::record(FrameRecord const& frameRecord)
+{
+  if(m_ring.empty())
+  {
+    return;
+  }
+  const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+  const std::size_t next = (tail + 1) % m_ring.size();
+  if(next == m_head.load(std::memory_order_acquire))
+  {
+    ++m_dropped;
+    return;
+  }
+  m_ring[tail] = frameRecord;
+  m_tail.store(next, std::memory_order_release);
+}
+
+void FrameRecorder::writerLoop()
+{
+  for(;;)
+  {
+    // Everything recorded before the stop request is still written
+    const bool  stop = m_stop;
+    std::size_t head = m_head.load(std::memory_order_relaxed);
+    const auto  tail = m_tail.load(std::memory_order_acquire);
+    while(head != tail)
+    {
+      write(m_ring[head]);
+      head = (head + 1) % m_ring.size();
+      m_head.store(head, std::memory_order_release);
+    }
+    m_file.flush();
+    if(m_maxFileBytes != 0 && static_cast<std::uint64_t>(m_file.tellp()) >= m_maxFileBytes)
+    {
+      // Every file starts with its own header, so a rotated file can be read on its own
+      const std::ios::openmode mode =
+          m_format == FrameRecordFormat::BINARY ? std::ios::out | std::ios::binary : std::ios::out;
+      if(!rotateFile(m_file, m_path, mode))
+      {
+        m_maxFileBytes = 0;
+      }
+      else
+      {
+        writeHeader();
+      }
+    }
+    if(stop)
+    {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+}
+
+void FrameRecorder::writeHeader()
+{
+  switch(m_format)
+  {
+    case FrameRecordFormat::BINARY: {
+      BinaryFileHeader header;
+      header.m_qpcFrequency = qpcFrequency();
+      header.m_startTime    = m_startTime;
+      m_file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+      break;
+    }
+    case FrameRecordFormat::CSV:
+      m_file << std::fixed << std::setprecision(1);
+      m_file << "frame,flags,back_buffers,max_frame_latency,latency_wait_begin_us,latency_wait_end_us,frame_begin_us,"
+                "fence_wait_begin_us,fence_wait_end_us,record_begin_us,record_end_us,target_present_us,"
+                "present_begin_us,present_end_us,stats_query_begin_us,stats_query_end_us,sync_mode,present_count,"
+                "present_in_sync_count,flip_in_sync_count,refresh_count,quadro_sync_frame_count,gpu_frame,gpu_begin_us,"
+                "gpu_end_us,gpu_gui_ms,gpu_lines_ms,gpu_indicator_ms,gpu_composite_ms,gpu_load_ms,gpu_load_work,"
+                "vsync_flags,vblank_us,scanline,dxgi_last_present_count,dxgi_present_count,dxgi_present_refresh_count,"
+                "dxgi_sync_refresh_count,dxgi_sync_us,flash_id,flash_event_us,gpu_compute_begin_us,gpu_compute_end_us,"
+                "gpu_compute_pattern_ms,gpu_compute_overlap_ms,marker_frame,marker_node\n";
+      break;
+    case FrameRecordFormat::FRAME_COUNTER:
+      break;
+  }
+}
+
+void FrameRecorder::write(FrameRecord const& frameRecord)
+{
+  switch(m_format)
+  {
+    case FrameRecordFormat::BINARY:
+      m_file.write(reinterpret_cast<char const*>(&frameRecord), sizeof(frameRecord));
+      break;
+    case FrameRecordFormat::CSV: {
+      auto micros = [this](std::int64_t timestamp) {
+        return timestamp == 0 ? 0.0 : qpcToMillis(timestamp - m_startTime) * 1000.0;
+      };
+      NV_PRESENT_BARRIER_FRAME_STATISTICS const& stats = frameRecord.m_presentBarrierStats;
+      VsyncSample const&                         vsync = frameRecord.m_vsync;
+      m_file << frameRecord.m_frameIndex << ',' << frameRecord.m_flags << ',' << frameRecord.m_backBufferCount << ','
+             << frameRecord.m_maxFrameLatency << ',' << micros(frameRecord.m_latencyWaitBegin) << ','
+             << micros(frameRecord.m_latencyWaitEnd) << ',' << micros(frameRecord.m_frameBegin) << ','
+             << micros(frameRecord.m_fenceWaitBegin) << ',' << micros(frameRecord.m_fenceWaitEnd) << ','
+             << micros(frameRecord.m_recordBegin) << ',' << micros(frameRecord.m_recordEnd) << ','
+             << micros(frameRecord.m_targetPresentTime) << ',' << micros(frameRecord.m_presentBegin) << ','
+             << micros(frameRecord.m_presentEnd) << ','
+             << micros(frameRecord.m_statsQueryBegin) << ',' << micros(frameRecord.m_statsQueryEnd) << ','
+             << stats.SyncMode << ',' << stats.PresentCount << ',' << stats.PresentInSyncCount << ','
+             << stats.FlipInSyncCount << ',' << stats.RefreshCount << ',' << frameRecord.m_quadroSyncFrameCount << ','
+             << frameRecord.m_gpuFrameIndex << ',' << micros(frameRecord.m_gpuBegin) << ','
+             << micros(frameRecord.m_gpuEnd) << ',' << std::setprecision(3) << frameRecord.m_gpuGuiMillis << ','
+             << frameRecord.m_gpuLinesMillis << ',' << frameRecord.m_gpuIndicatorMillis << ','
+             << frameRecord.m_gpuCompositeMillis << ',' << frameRecord.m_gpuLoadMillis << std::setprecision(1) << ','
+             << frameRecord.m_gpuLoadWork << ',' << vsync.m_flags << ',' << micros(vsync.m_vblankTime) << ','
+             << vsync.m_scanLine << ',' << vsync.m_lastPresentCount << ',' << vsync.m_presentCount << ','
+             << vsync.m_presentRefreshCount << ',' << vsync.m_syncRefreshCount << ',' << micros(vsync.m_syncQpcTime)
+             << ',' << frameRecord.m_flashId << ',' << micros(frameRecord.m_flashEventTime) << ','
+             << micros(frameRecord.m_gpuComputeBegin) << ',' << micros(frameRecord.m_gpuComputeEnd) << ','
+             << std::setprecision(3) << frameRecord.m_gpuComputePatternMillis << ','
+             << frameRecord.m_gpuComputeOverlapMillis << std::setprecision(1) << ',' << frameRecord.m_markerFrame << ','
+             << frameRecord.m_markerNodeId << '\n';
+      break;
+    }
+    case FrameRecordFormat::FRAME_COUNTER:
+      if(frameRecord.m_flags & FRAME_RECORD_PRESENT_BARRIER_STATS)
+      {
+        m_file << frameRecord.m_presentBarrierStats.PresentCount << '\n';
+      }
+      break;
+  }
+}
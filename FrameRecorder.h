@@ -0,0 +1,118 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nvapi.h>
+
+#include <VsyncProbe.h>
+
+enum FrameRecordFlags : std::uint32_t
+{
+  FRAME_RECORD_PRESENT_BARRIER_STATS = 0x1,   // m_presentBarrierStats is valid
+  FRAME_RECORD_QUADRO_SYNC           = 0x2,   // m_quadroSyncFrameCount was queried from the Quadro Sync device
+  FRAME_RECORD_WAIT_TIMEOUT          = 0x4,   // waiting for the frame's command allocator timed out, nothing presented
+  FRAME_RECORD_GPU_TIMINGS           = 0x8,   // the m_gpu* members are valid
+  FRAME_RECORD_VSYNC                 = 0x10,  // m_vsync was probed, its flags tell which of its members are valid
+  FRAME_RECORD_SAMPLED               = 0x20,  // stats and frame count from the sync sampler, m_statsQuery* is its time
+  FRAME_RECORD_FLASH                 = 0x40,  // the frame flashed the latency marker, m_flash* are valid
+  FRAME_RECORD_GPU_COMPUTE           = 0x80,  // the m_gpuCompute* members are valid, only with -asynccompute
+  FRAME_RECORD_MARKER                = 0x100, // m_marker* were read back from the back buffer and match what was drawn
+  FRAME_RECORD_MARKER_MISMATCH       = 0x200, // m_marker* were read back but differ from what was drawn
+};
+
+// Timing information of a single frame. All timestamps are raw QueryPerformanceCounter values. GPU timings are only
+// available a few frames later, so they belong to the earlier frame m_gpuFrameIndex.
+struct FrameRecord
+{
+  std::uint64_t                       m_frameIndex              = 0;
+  std::int64_t                        m_latencyWaitBegin        = 0;  // frame latency waitable object, if used
+  std::int64_t                        m_latencyWaitEnd          = 0;
+  std::int64_t                        m_frameBegin              = 0;
+  std::int64_t                        m_fenceWaitBegin          = 0;
+  std::int64_t                        m_fenceWaitEnd            = 0;
+  std::int64_t                        m_recordBegin             = 0;
+  std::int64_t                        m_recordEnd               = 0;
+  std::int64_t                        m_targetPresentTime       = 0;  // only with timed or just-in-time frame pacing
+  std::int64_t                        m_presentBegin            = 0;
+  std::int64_t                        m_presentEnd              = 0;
+  std::int64_t                        m_statsQueryBegin         = 0;
+  std::int64_t                        m_statsQueryEnd           = 0;
+  NvU32                               m_quadroSyncFrameCount    = 0;
+  std::uint32_t                       m_flags                   = 0;
+  std::uint32_t                       m_backBufferCount         = 0;
+  std::uint32_t                       m_maxFrameLatency         = 0;  // zero if the DXGI default is used
+  NV_PRESENT_BARRIER_FRAME_STATISTICS m_presentBarrierStats     = {};
+  std::uint64_t                       m_gpuFrameIndex           = 0;
+  std::int64_t                        m_gpuBegin                = 0;
+  std::int64_t                        m_gpuEnd                  = 0;
+  float                               m_gpuGuiMillis            = 0.0f;  // most recent gui recording, not per frame
+  float                               m_gpuLinesMillis          = 0.0f;
+  float                               m_gpuIndicatorMillis      = 0.0f;
+  float                               m_gpuCompositeMillis      = 0.0f;
+  float                               m_gpuLoadMillis           = 0.0f;
+  std::uint32_t                       m_gpuLoadWork             = 0;  // recorded for this frame, not m_gpuFrameIndex
+  VsyncSample                         m_vsync;
+  std::uint64_t                       m_flashId                 = 0;
+  std::int64_t                        m_flashEventTime          = 0;  // key press or network trigger time of the flash
+  std::int64_t                        m_gpuComputeBegin         = 0;  // compute queue part of m_gpuFrameIndex
+  std::int64_t                        m_gpuComputeEnd           = 0;
+  float                               m_gpuComputePatternMillis = 0.0f;
+  float                               m_gpuComputeOverlapMillis = 0.0f;  // of the compute load and the direct queue
+  std::uint32_t                       m_markerFrame             = 0;  // of the frame slot's previous frame, like m_gpu*
+  std::uint32_t                       m_markerNodeId            = 0;
+};
+
+enum class FrameRecordFormat
+{
+  BINARY,         // file header followed by raw FrameRecord structs
+  CSV,            // one line per frame, timestamps in microseconds since the recorder was opened
+  FRAME_COUNTER,  // one present barrier PresentCount per line (legacy -framecounterfile output)
+};
+
+// Closes the file, renames it to <path>.1 (replacing an earlier one) and opens path again, so a file that is rotated
+// at a size limit never takes more than twice the limit on disk
+bool rotateFile(std::ofstream& file, std::string const& path, std::ios::openmode mode);
+
+// Collects frame records in a preallocated ring buffer and writes them to disk from a background thread. Recording
+// from the render thread never allocates, blocks or touches the file; records are dropped when the writer falls
+// behind.
+class FrameRecorder
+{
+public:
+  ~FrameRecorder() { close(); }
+
+  // The file is rotated whenever it exceeds maxFileBytes, 0 lets it grow without limit
+  bool open(std::string const& path, FrameRecordFormat format, std::uint32_t capacity, std::uint64_t maxFileBytes = 0);
+  void close();
+  bool isOpen() const { return m_writer.joinable(); }
+
+  // Render thread only
+  void record(FrameRecord const& frameRecord);
+
+  std::uint64_t droppedRecords() const { return m_dropped; }
+
+private:
+  std::vector<FrameRecord>   m_ring;
+  std::atomic<std::size_t>   m_head    = 0;
+  std::atomic<std::size_t>   m_tail    = 0;
+  std::atomic<std::uint64_t> m_dropped = 0;
+  std::atomic<bool>          m_stop    = false;
+  std::thread                m_writer;
+  std::ofstream              m_file;
+  std::string                m_path;
+  FrameRecordFormat          m_format       = FrameRecordFormat::BINARY;
+  std::int64_t               m_startTime    = 0;
+  std::uint64_t              m_maxFileBytes = 0;
+
+  void writerLoop();
+  void writeHeader();
+  void write(FrameRecord const& frameRecord);
+};
@@ -0,0 +1,200 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <FrameScheduler.h>
+#include <Timing.h>
+
+#include <nvdx12/error_dx12.hpp>
+#include <nvh/nvprint.hpp>
+
+bool parseFramePacing(std::string const& name, FramePacing& pacing)
+{
+  if(name == "s" || name == "sleep")
+  {
+    pacing = FramePacing::SLEEP;
+  }
+  else if(name == "w" || name == "waitable")
+  {
+    pacing = FramePacing::WAITABLE;
+  }
+  else if(name == "t" || name == "timed")
+  {
+    pacing = FramePacing::TIMED;
+  }
+  else if(name == "j" || name == "justintime")
+  {
+    pacing = FramePacing::JUST_IN_TIME;
+  }
+  else
+  {
+    return false;
+  }
+  return true;
+}
+
+bool FrameScheduler::init(FramePacing pacing, std::uint32_t presentPeriodMicros, std::uint32_t maxFrameLatency)
+{
+  deinit();
+  if(pacing == FramePacing::TIMED && presentPeriodMicros == 0)
+  {
+    LOGE("Timed frame pacing requires a present period.\n");
+    return false;
+  }
+  m_pacing          = pacing;
+  m_maxFrameLatency = maxFrameLatency;
+  m_presentPeriod   = static_cast<std::int64_t>(presentPeriodMicros) * qpcFrequency() / 1000000;
+
+  // Regular timers need a longer spin
+  bool highResolution = false;
+  m_timer             = createPreciseTimer(highResolution);
+  m_spinTicks         = highResolution ? qpcFrequency() / 2000 : qpcFrequency() / 500;
+  if(m_timer == NULL)
+  {
+    HR_CHECK(HRESULT_FROM_WIN32(GetLastError()));
+    return false;
+  }
+  return true;
+}
+
+void FrameScheduler::deinit()
+{
+  if(m_frameLatencyEvent != NULL)
+  {
+    CloseHandle(m_frameLatencyEvent);
+    m_frameLatencyEvent = NULL;
+  }
+  if(m_timer != NULL)
+  {
+    CloseHandle(m_timer);
+    m_timer = NULL;
+  }
+  m_nextPresentTime   = 0;
+  m_targetPresentTime = 0;
+  m_frameCost         = 0;
+  m_frameWaited       = false;
+}
+
+UINT FrameScheduler::swapChainFlags() const
+{
+  return m_pacing != FramePacing::SLEEP ? DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT : 0;
+}
+
+void FrameScheduler::setSwapChain(IDXGISwapChain2* swapChain)
+{
+  if(m_frameLatencyEvent != NULL)
+  {
+    CloseHandle(m_frameLatencyEvent);
+    m_frameLatencyEvent = NULL;
+  }
+  m_frameWaited = false;
+  if(m_pacing != FramePacing::SLEEP && swapChain != nullptr)
+  {
+    if(m_maxFrameLatency != 0)
+    {
+      HR_CHECK(swapChain->SetMaximumFrameLatency(m_maxFrameLatency));
+    }
+    m_frameLatencyEvent = swapChain->GetFrameLatencyWaitableObject();
+  }
+}
+
+std::int64_t FrameScheduler::waitForFrame(DWORD timeoutMillis)
+{
+  if(m_frameLatencyEvent == NULL)
+  {
+    return 0;
+  }
+
+  // A frame that waited but was never presented doesn't consume the swap chain's latency count, so it must not be
+  // waited for again
+  if(!m_frameWaited)
+  {
+    if(WaitForSingleObjectEx(m_frameLatencyEvent, timeoutMillis, TRUE) != WAIT_OBJECT_0)
+    {
+      LOGW("Wait for the frame latency waitable object timed out.\n");
+      m_frameStart = 0;
+      return 0;
+    }
+    m_frameWaited = true;
+  }
+  m_frameStart = qpcNow();
+  return m_frameStart;
+}
+
+void FrameScheduler::delay(std::int64_t ticks)
+{
+  if(ticks > 0)
+  {
+    waitUntil(qpcNow() + ticks);
+  }
+}
+
+void FrameScheduler::waitForFrameStart(std::int64_t presentDeadline)
+{
+  if(m_pacing != FramePacing::JUST_IN_TIME || presentDeadline == 0)
+  {
+    return;
+  }
+  waitUntil(presentDeadline - m_frameCost);
+  m_frameStart        = qpcNow();
+  m_targetPresentTime = presentDeadline;
+}
+
+std::int64_t FrameScheduler::waitForPresentTime()
+{
+  if(m_pacing != FramePacing::TIMED)
+  {
+    return m_pacing == FramePacing::JUST_IN_TIME ? m_targetPresentTime : 0;
+  }
+
+  // Start over instead of catching up with a burst of frames when the target was missed by more than a period
+  const std::int64_t now = qpcNow();
+  if(m_nextPresentTime == 0 || now > m_nextPresentTime + m_presentPeriod)
+  {
+    m_nextPresentTime = now;
+  }
+  waitUntil(m_nextPresentTime);
+  m_targetPresentTime = m_nextPresentTime;
+  return m_targetPresentTime;
+}
+
+void FrameScheduler::presented(std::int64_t presentTime)
+{
+  constexpr float SMOOTHING = 0.05f;
+  m_frameWaited             = false;
+  if(m_frameStart != 0)
+  {
+    const float latency = static_cast<float>(qpcToMillis(presentTime - m_frameStart));
+    m_latencyMillis += SMOOTHING * (latency - m_latencyMillis);
+
+    // Follows longer frames right away, so a slow frame is not started too late again, and recovers slowly
+    const std::int64_t cost = presentTime - m_frameStart;
+    m_frameCost             = cost > m_frameCost ? cost : m_frameCost - (m_frameCost - cost) / 64;
+  }
+  if(m_targetPresentTime != 0)
+  {
+    const float error = static_cast<float>(qpcToMillis(presentTime - m_targetPresentTime));
+    m_presentErrorMillis += SMOOTHING * (error - m_presentErrorMillis);
+    m_nextPresentTime   = m_targetPresentTime + m_presentPeriod;
+    m_targetPresentTime = 0;
+  }
+}
+
+void FrameScheduler::waitUntil(std::int64_t time)
+{
+  // Sleep on the timer for most of the time, the timer may fire late by up to m_spinTicks
+  const std::int64_t remaining = time - qpcNow();
+  if(remaining > m_spinTicks)
+  {
+    LARGE_INTEGER dueTime;
+    dueTime.QuadPart = -((remaining - m_spinTicks) * 10000000 / qpcFrequency());  // relative, in 100 ns units
+    if(SetWaitableTimerEx(m_timer, &dueTime, 0, nullptr, nullptr, nullptr, 0))
+    {
+      WaitForSingleObject(m_timer, INFINITE);
+      m_wakeLatency.add(qpcNow() - (time - m_spinTicks));
+    }
+  }
+  while(qpcNow() < time)
+  {
+    YieldProcessor();
+  }
+}
@@ -0,0 +1,77 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <dxgi1_3.h>
+
+#include <ThreadScheduling.h>
+
+enum class FramePacing
+{
+  SLEEP,         // legacy: Sleep() for the sleep interval, frames are only throttled by the allocator fences
+  WAITABLE,      // wait on the swap chain's frame latency waitable object before starting a frame
+  TIMED,         // waitable, plus Present is held back until a target time with sub-millisecond precision
+  JUST_IN_TIME,  // waitable, plus the frame start is delayed so Present is called a margin before the next vblank
+};
+
+bool parseFramePacing(std::string const& name, FramePacing& pacing);
+
+// Paces frames by the swap chain's frame latency waitable object and QueryPerformanceCounter based target present
+// times. Precise waits sleep on a high resolution waitable timer and spin for the remainder.
+class FrameScheduler
+{
+public:
+  ~FrameScheduler() { deinit(); }
+
+  // A maximum frame latency of zero keeps the DXGI default
+  bool init(FramePacing pacing, std::uint32_t presentPeriodMicros, std::uint32_t maxFrameLatency);
+  void deinit();
+
+  FramePacing pacing() const { return m_pacing; }
+  // Flags the swap chain has to be created and resized with
+  UINT swapChainFlags() const;
+  // Has to be called whenever the swap chain was (re-)created
+  void setSwapChain(IDXGISwapChain2* swapChain);
+
+  // Blocks until the swap chain can queue another frame, the returned time is the frame's input sample time. Returns
+  // 0 on timeout or with sleep pacing.
+  std::int64_t waitForFrame(DWORD timeoutMillis);
+  // Sleeps with sub-millisecond precision instead of Sleep()'s scheduler quantum
+  void delay(std::int64_t ticks);
+  // Just-in-time pacing: delays the frame start so Present is expected at the deadline, by the estimated frame cost
+  void waitForFrameStart(std::int64_t presentDeadline);
+  // Timed pacing: blocks until the target present time and returns it. Just-in-time pacing: returns the frame's
+  // deadline. 0 otherwise.
+  std::int64_t waitForPresentTime();
+  void         presented(std::int64_t presentTime);
+
+  // Exponentially smoothed, in milliseconds
+  float latencyMillis() const { return m_latencyMillis; }
+  float presentErrorMillis() const { return m_presentErrorMillis; }
+  // From the frame start to Present, a decaying peak of the recent frames
+  std::int64_t frameCost() const { return m_frameCost; }
+
+  // Lateness of the timer wake-ups of precise waits, the render thread adds its other waits
+  WakeLatency& wakeLatency() { return m_wakeLatency; }
+
+private:
+  FramePacing  m_pacing             = FramePacing::SLEEP;
+  UINT         m_maxFrameLatency    = 0;
+  HANDLE       m_timer              = NULL;
+  HANDLE       m_frameLatencyEvent  = NULL;
+  std::int64_t m_spinTicks          = 0;
+  std::int64_t m_presentPeriod      = 0;
+  std::int64_t m_frameStart         = 0;
+  std::int64_t m_targetPresentTime  = 0;
+  std::int64_t m_nextPresentTime    = 0;
+  std::int64_t m_frameCost          = 0;
+  bool         m_frameWaited        = false;
+  float        m_latencyMillis      = 0.0f;
+  float        m_presentErrorMillis = 0.0f;
+  WakeLatency  m_wakeLatency;
+
+  void waitUntil(std::int64_t time);
+};
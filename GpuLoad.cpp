@@ -0,0 +1,61 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <GpuLoad.h>
+
+#include <algorithm>
+
+bool parseGpuLoadMode(std::string const& name, GpuLoadMode& mode)
+{
+  if(name == "a" || name == "alu")
+  {
+    mode = GpuLoadMode::ALU;
+  }
+  else if(name == "f" || name == "fill")
+  {
+    mode = GpuLoadMode::FILL;
+  }
+  else if(name == "b" || name == "bandwidth")
+  {
+    mode = GpuLoadMode::BANDWIDTH;
+  }
+  else
+  {
+    return false;
+  }
+  return true;
+}
+
+char const* gpuLoadModeName(GpuLoadMode mode)
+{
+  switch(mode)
+  {
+    case GpuLoadMode::ALU:
+      return "ALU";
+    case GpuLoadMode::FILL:
+      return "Fill";
+    case GpuLoadMode::BANDWIDTH:
+      return "Bandwidth";
+    default:
+      return "Unknown";
+  }
+}
+
+void GpuLoadController::reset(float targetMillis, float work)
+{
+  m_targetMillis = targetMillis;
+  m_work         = std::clamp(work, MIN_WORK, MAX_WORK);
+}
+
+void GpuLoadController::update(float measuredMillis)
+{
+  constexpr float GAIN = 0.25f;
+  if(m_targetMillis <= 0.0f)
+  {
+    return;
+  }
+
+  // The cost is roughly proportional to the work, so correct multiplicatively and limit the step per update
+  const float ratio = std::clamp(m_targetMillis / std::max(measuredMillis, 0.01f), 0.5f, 2.0f);
+  m_work            = std::clamp(m_work * (1.0f + GAIN * (ratio - 1.0f)), MIN_WORK, MAX_WORK);
+}
@@ -0,0 +1,38 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Synthetic GPU work to bring the frame cost close to the refresh interval. Must match the modes in load_ps.hlsl.
+enum class GpuLoadMode : std::uint32_t
+{
+  ALU,        // work = loop iterations of dependent math per pixel
+  FILL,       // work = number of blended fullscreen layers
+  BANDWIDTH,  // work = scattered texture loads per pixel from a large texture
+};
+
+bool        parseGpuLoadMode(std::string const& name, GpuLoadMode& mode);
+char const* gpuLoadModeName(GpuLoadMode mode);
+
+// Closed-loop controller scaling the amount of work so the measured GPU time of the load pass holds the target. The
+// measurement arrives a few frames late, so every update only corrects part of the error to avoid oscillation.
+class GpuLoadController
+{
+public:
+  static constexpr float MIN_WORK = 1.0f;
+  static constexpr float MAX_WORK = 65536.0f;
+
+  // A target of zero keeps the work amount fixed
+  void reset(float targetMillis, float work);
+  void update(float measuredMillis);
+
+  float         targetMillis() const { return m_targetMillis; }
+  std::uint32_t work() const { return static_cast<std::uint32_t>(m_work); }
+
+private:
+  float m_targetMillis = 0.0f;
+  float m_work         = MIN_WORK;
+};
@@ -0,0 +1,239 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <GpuTimer.h>
+#include <Timing.h>
+
+#include <algorithm>
+#include <nvdx12/error_dx12.hpp>
+
+bool GpuTimer::init(ID3D12Device* device, ID3D12CommandQueue* queue, UINT frameSlots, UINT guiSlots)
+{
+  deinit();
+
+  // Gui timestamp pairs follow the timestamps of all frames, the signal timestamps of all frames follow them
+  D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
+  queryHeapDesc.Type                  = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+  queryHeapDesc.Count                 = frameSlots * (TIMESTAMPS_PER_FRAME + 1) + guiSlots * 2;
+  HR_CHECK(device->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&m_queryHeap)));
+
+  m_slots.resize(frameSlots);
+  CD3DX12_HEAP_PROPERTIES readbackHeapProps(D3D12_HEAP_TYPE_READBACK);
+  CD3DX12_RESOURCE_DESC   readbackDesc = CD3DX12_RESOURCE_DESC::Buffer((TIMESTAMPS_PER_FRAME + 1) * sizeof(UINT64));
+  for(Slot& slot : m_slots)
+  {
+    HR_CHECK(device->CreateCommittedResource(&readbackHeapProps, D3D12_HEAP_FLAG_NONE, &readbackDesc,
+                                             D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&slot.m_readback)));
+    slot.m_readback->SetName(L"timestamp_readback");
+  }
+  m_guiSlots.resize(guiSlots);
+  CD3DX12_RESOURCE_DESC guiReadbackDesc = CD3DX12_RESOURCE_DESC::Buffer(2 * sizeof(UINT64));
+  for(GuiSlot& slot : m_guiSlots)
+  {
+    HR_CHECK(device->CreateCommittedResource(&readbackHeapProps, D3D12_HEAP_FLAG_NONE, &guiReadbackDesc,
+                                             D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&slot.m_readback)));
+    slot.m_readback->SetName(L"gui_timestamp_readback");
+  }
+
+  m_clock.init(queue);
+  return true;
+}
+
+bool GpuTimer::initCompute(ID3D12Device* device, ID3D12CommandQueue* computeQueue)
+{
+  D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
+  queryHeapDesc.Type                  = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+  queryHeapDesc.Count                 = static_cast<UINT>(m_slots.size()) * COMPUTE_TIMESTAMPS_PER_FRAME;
+  HR_CHECK(device->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&m_computeQueryHeap)));
+
+  CD3DX12_HEAP_PROPERTIES readbackHeapProps(D3D12_HEAP_TYPE_READBACK);
+  CD3DX12_RESOURCE_DESC   readbackDesc = CD3DX12_RESOURCE_DESC::Buffer(COMPUTE_TIMESTAMPS_PER_FRAME * sizeof(UINT64));
+  for(Slot& slot : m_slots)
+  {
+    HR_CHECK(device->CreateCommittedResource(&readbackHeapProps, D3D12_HEAP_FLAG_NONE, &readbackDesc,
+                                             D3D12_RESOURCE_STATE_COPY_DEST, nullptr,
+                                             IID_PPV_ARGS(&slot.m_computeReadback)));
+    slot.m_computeReadback->SetName(L"compute_timestamp_readback");
+  }
+
+  m_computeClock.init(computeQueue);
+  return true;
+}
+
+void GpuTimer::deinit()
+{
+  m_slots.clear();
+  m_guiSlots.clear();
+  m_queryHeap.Reset();
+  m_computeQueryHeap.Reset();
+  m_clock        = {};
+  m_computeClock = {};
+}
+
+void GpuTimer::timestamp(ID3D12GraphicsCommandList* commandList, UINT frameSlot, UINT timestamp)
+{
+  commandList->EndQuery(m_queryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, frameSlot * TIMESTAMPS_PER_FRAME + timestamp);
+}
+
+void GpuTimer::resolve(ID3D12GraphicsCommandList* commandList, UINT frameSlot, UINT eyes, std::uint64_t frameIndex)
+{
+  // Only resolve the timestamps that were actually written this frame
+  Slot& slot = m_slots[frameSlot];
+  commandList->ResolveQueryData(m_queryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, frameSlot * TIMESTAMPS_PER_FRAME,
+                                EYE_BEGIN + eyes * TIMESTAMPS_PER_EYE, slot.m_readback.Get(), 0);
+  slot.m_resolvedEyes = eyes;
+  slot.m_frameIndex   = frameIndex;
+  slot.m_presentTime  = 0;
+  slot.m_signaled     = false;
+}
+
+void GpuTimer::recordSignal(ID3D12GraphicsCommandList* commandList, UINT frameSlot)
+{
+  const UINT index =
+      static_cast<UINT>(m_slots.size()) * TIMESTAMPS_PER_FRAME + static_cast<UINT>(m_guiSlots.size()) * 2 + frameSlot;
+  commandList->EndQuery(m_queryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, index);
+  commandList->ResolveQueryData(m_queryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, index, 1,
+                                m_slots[frameSlot].m_readback.Get(), TIMESTAMPS_PER_FRAME * sizeof(UINT64));
+}
+
+void GpuTimer::computeTimestamp(ID3D12GraphicsCommandList* commandList, UINT frameSlot, ComputeTimestamp timestamp)
+{
+  commandList->EndQuery(m_computeQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP,
+                        frameSlot * COMPUTE_TIMESTAMPS_PER_FRAME + timestamp);
+}
+
+void GpuTimer::resolveCompute(ID3D12GraphicsCommandList* commandList, UINT frameSlot)
+{
+  Slot& slot = m_slots[frameSlot];
+  commandList->ResolveQueryData(m_computeQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP,
+                                frameSlot * COMPUTE_TIMESTAMPS_PER_FRAME, COMPUTE_TIMESTAMPS_PER_FRAME,
+                                slot.m_computeReadback.Get(), 0);
+  slot.m_computeResolved = true;
+}
+
+GpuTimer::Timings const* GpuTimer::read(UINT frameSlot)
+{
+  Slot& slot = m_slots[frameSlot];
+  if(slot.m_resolvedEyes == 0)
+  {
+    return nullptr;
+  }
+
+  // Re-calibrate about once per second to compensate for drift between the CPU and GPU clocks
+  if(qpcNow() - static_cast<std::int64_t>(m_clock.m_cpuCalibration) > qpcFrequency())
+  {
+    m_clock.calibrate();
+    if(m_computeClock.m_queue)
+    {
+      m_computeClock.calibrate();
+    }
+  }
+
+  const UINT  count = slot.m_signaled ? TIMESTAMPS_PER_FRAME + 1 : EYE_BEGIN + slot.m_resolvedEyes * TIMESTAMPS_PER_EYE;
+  D3D12_RANGE readRange{0, count * sizeof(UINT64)};
+  UINT64*     data = nullptr;
+  HR_CHECK(slot.m_readback->Map(0, &readRange, reinterpret_cast<void**>(&data)));
+
+  m_timings               = {};
+  m_timings.m_frameIndex  = slot.m_frameIndex;
+  m_timings.m_begin       = m_clock.toQpc(data[MAIN_BEGIN]);
+  m_timings.m_end         = m_clock.toQpc(data[MAIN_END]);
+  m_timings.m_frameMillis = m_clock.toMillis(data[MAIN_BEGIN], data[MAIN_END]);
+  m_timings.m_loadMillis  = m_clock.toMillis(data[LOAD_BEGIN], data[LOAD_END]);
+  for(UINT eye = 0; eye < slot.m_resolvedEyes; ++eye)
+  {
+    UINT64 const* eyeData = data + eye * TIMESTAMPS_PER_EYE;
+    m_timings.m_linesMillis += m_clock.toMillis(eyeData[EYE_BEGIN], eyeData[EYE_LINES_END]);
+    m_timings.m_indicatorMillis += m_clock.toMillis(eyeData[EYE_LINES_END], eyeData[EYE_INDICATOR_END]);
+    m_timings.m_compositeMillis += m_clock.toMillis(eyeData[EYE_INDICATOR_END], eyeData[EYE_GUI_END]);
+  }
+  if(slot.m_presentTime != 0)
+  {
+    m_timings.m_presentToEndMillis = static_cast<float>(qpcToMillis(m_timings.m_end - slot.m_presentTime));
+  }
+  if(slot.m_signaled)
+  {
+    m_timings.m_signal = m_clock.toQpc(data[TIMESTAMPS_PER_FRAME]);
+  }
+
+  D3D12_RANGE writtenRange{0, 0};
+  slot.m_readback->Unmap(0, &writtenRange);
+  slot.m_resolvedEyes = 0;
+
+  if(slot.m_computeResolved)
+  {
+    D3D12_RANGE computeRange{0, COMPUTE_TIMESTAMPS_PER_FRAME * sizeof(UINT64)};
+    HR_CHECK(slot.m_computeReadback->Map(0, &computeRange, reinterpret_cast<void**>(&data)));
+    m_timings.m_computeBegin         = m_computeClock.toQpc(data[COMPUTE_BEGIN]);
+    m_timings.m_computeEnd           = m_computeClock.toQpc(data[COMPUTE_LOAD_END]);
+    m_timings.m_computePatternMillis = m_computeClock.toMillis(data[COMPUTE_BEGIN], data[COMPUTE_PATTERN_END]);
+    m_timings.m_computeLoadMillis    = m_computeClock.toMillis(data[COMPUTE_LOAD_BEGIN], data[COMPUTE_LOAD_END]);
+    // Both queues are converted to the CPU clock, so their intervals can be compared
+    const std::int64_t overlapBegin = (std::max)(m_computeClock.toQpc(data[COMPUTE_LOAD_BEGIN]), m_timings.m_begin);
+    const std::int64_t overlapEnd   = (std::min)(m_timings.m_computeEnd, m_timings.m_end);
+    if(overlapEnd > overlapBegin)
+    {
+      m_timings.m_computeOverlapMillis = static_cast<float>(qpcToMillis(overlapEnd - overlapBegin));
+    }
+    slot.m_computeReadback->Unmap(0, &writtenRange);
+    slot.m_computeResolved = false;
+  }
+  return &m_timings;
+}
+
+void GpuTimer::guiTimestamp(ID3D12GraphicsCommandList* commandList, UINT guiSlot, bool end)
+{
+  const UINT index = static_cast<UINT>(m_slots.size()) * TIMESTAMPS_PER_FRAME + guiSlot * 2 + (end ? 1 : 0);
+  commandList->EndQuery(m_queryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, index);
+}
+
+void GpuTimer::resolveGui(ID3D12GraphicsCommandList* commandList, UINT guiSlot)
+{
+  GuiSlot&   slot  = m_guiSlots[guiSlot];
+  const UINT index = static_cast<UINT>(m_slots.size()) * TIMESTAMPS_PER_FRAME + guiSlot * 2;
+  commandList->ResolveQueryData(m_queryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, index, 2, slot.m_readback.Get(), 0);
+  slot.m_resolved = true;
+}
+
+float GpuTimer::readGui(UINT guiSlot)
+{
+  GuiSlot& slot = m_guiSlots[guiSlot];
+  if(!slot.m_resolved)
+  {
+    return -1.0f;
+  }
+
+  D3D12_RANGE readRange{0, 2 * sizeof(UINT64)};
+  UINT64*     data = nullptr;
+  HR_CHECK(slot.m_readback->Map(0, &readRange, reinterpret_cast<void**>(&data)));
+  const float millis = m_clock.toMillis(data[0], data[1]);
+  D3D12_RANGE writtenRange{0, 0};
+  slot.m_readback->Unmap(0, &writtenRange);
+  slot.m_resolved = false;
+  return millis;
+}
+
+void GpuTimer::Clock::init(ID3D12CommandQueue* queue)
+{
+  m_queue = queue;
+  HR_CHECK(m_queue->GetTimestampFrequency(&m_gpuFrequency));
+  calibrate();
+}
+
+void GpuTimer::Clock::calibrate()
+{
+  HR_CHECK(m_queue->GetClockCalibration(&m_gpuCalibration, &m_cpuCalibration));
+}
+
+std::int64_t GpuTimer::Clock::toQpc(UINT64 gpuTimestamp) const
+{
+  const double gpuDelta = static_cast<double>(static_cast<std::int64_t>(gpuTimestamp - m_gpuCalibration));
+  return static_cast<std::int64_t>(m_cpuCalibration)
+         + static_cast<std::int64_t>(gpuDelta * qpcFrequency() / static_cast<double>(m_gpuFrequency));
+}
+
+float GpuTimer::Clock::toMillis(UINT64 begin, UINT64 end) const
+{
+  return static_cast<float>(static_cast<double>(static_cast<std::int64_t>(end - begin)) * 1000.0
+                            / static_cast<double>(m_gpuFrequency));
+}
@@ -0,0 +1,134 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <d3dx12.h>
+#include <wrl/client.h>
+using Microsoft::WRL::ComPtr;
+
+// GPU timestamps of the passes of a frame. Every frame slot (one per back buffer) has its own range in the query heap
+// and its own readback buffer, so results are only read once the frame's command allocator is reused and reading
+// never stalls. The gui is recorded independently of the frames, so it has its own timestamp pair per gui slot. With
+// an async compute queue, its part of the frame has its own query heap and clock, resolved into the same frame slot.
+// The timestamp right before the frame fence is signaled is written by a separate command list per frame slot.
+class GpuTimer
+{
+public:
+  enum Timestamp : UINT
+  {
+    MAIN_BEGIN,
+    MAIN_END,
+    LOAD_BEGIN,
+    LOAD_END,
+    // Followed by TIMESTAMPS_PER_EYE timestamps for every rendered eye
+    EYE_BEGIN,
+    EYE_LINES_END,
+    EYE_INDICATOR_END,
+    EYE_GUI_END,
+  };
+  static constexpr UINT TIMESTAMPS_PER_EYE   = 4;
+  static constexpr UINT TIMESTAMPS_PER_FRAME = EYE_BEGIN + 2 * TIMESTAMPS_PER_EYE;
+
+  enum ComputeTimestamp : UINT
+  {
+    COMPUTE_BEGIN,
+    COMPUTE_PATTERN_END,
+    COMPUTE_LOAD_BEGIN,
+    COMPUTE_LOAD_END,
+  };
+  static constexpr UINT COMPUTE_TIMESTAMPS_PER_FRAME = COMPUTE_LOAD_END + 1;
+
+  // Durations in milliseconds, begin and end converted to QueryPerformanceCounter values
+  struct Timings
+  {
+    std::uint64_t m_frameIndex         = 0;
+    std::int64_t  m_begin              = 0;
+    std::int64_t  m_end                = 0;
+    float         m_frameMillis        = 0.0f;
+    float         m_guiMillis          = 0.0f;
+    float         m_loadMillis         = 0.0f;
+    float         m_linesMillis        = 0.0f;
+    float         m_indicatorMillis    = 0.0f;
+    float         m_compositeMillis    = 0.0f;
+    float         m_presentToEndMillis = 0.0f;  // negative if the GPU finished before Present was called
+    std::int64_t  m_signal             = 0;     // right before the frame fence was signaled, 0 if it wasn't
+    // Async compute queue, all zero if the frame had no compute work
+    std::int64_t m_computeBegin         = 0;
+    std::int64_t m_computeEnd           = 0;
+    float        m_computePatternMillis = 0.0f;
+    float        m_computeLoadMillis    = 0.0f;
+    float        m_computeOverlapMillis = 0.0f;  // of the compute load with the frame on the direct queue
+  };
+
+  bool init(ID3D12Device* device, ID3D12CommandQueue* queue, UINT frameSlots, UINT guiSlots);
+  // After init, for frames that also submit work to the compute queue
+  bool initCompute(ID3D12Device* device, ID3D12CommandQueue* computeQueue);
+  void deinit();
+
+  static constexpr UINT eyeTimestamp(UINT eye, Timestamp timestamp) { return timestamp + eye * TIMESTAMPS_PER_EYE; }
+
+  void timestamp(ID3D12GraphicsCommandList* commandList, UINT frameSlot, UINT timestamp);
+  void resolve(ID3D12GraphicsCommandList* commandList, UINT frameSlot, UINT eyes, std::uint64_t frameIndex);
+  void setPresentTime(UINT frameSlot, std::int64_t presentTime) { m_slots[frameSlot].m_presentTime = presentTime; }
+
+  // Records the signal timestamp of the slot and its resolve into a list that is executed every time right before
+  // the frame fence is signaled, followed by signaled()
+  void recordSignal(ID3D12GraphicsCommandList* commandList, UINT frameSlot);
+  void signaled(UINT frameSlot) { m_slots[frameSlot].m_signaled = true; }
+
+  // Recorded into the compute queue's command lists, resolved after the last compute timestamp of the frame
+  void computeTimestamp(ID3D12GraphicsCommandList* commandList, UINT frameSlot, ComputeTimestamp timestamp);
+  void resolveCompute(ID3D12GraphicsCommandList* commandList, UINT frameSlot);
+
+  // Only valid once the GPU finished the frame that was last resolved into the slot, including its compute work,
+  // nullptr if nothing was resolved
+  Timings const* read(UINT frameSlot);
+
+  // Gui slots are only used by the thread recording the gui, read with the same rules as frame slots, negative if
+  // nothing was resolved
+  void  guiTimestamp(ID3D12GraphicsCommandList* commandList, UINT guiSlot, bool end);
+  void  resolveGui(ID3D12GraphicsCommandList* commandList, UINT guiSlot);
+  float readGui(UINT guiSlot);
+
+private:
+  struct Slot
+  {
+    ComPtr<ID3D12Resource> m_readback;
+    ComPtr<ID3D12Resource> m_computeReadback;
+    bool                   m_computeResolved = false;
+    bool                   m_signaled        = false;
+    UINT                   m_resolvedEyes    = 0;
+    std::uint64_t          m_frameIndex      = 0;
+    std::int64_t           m_presentTime     = 0;
+  };
+  struct GuiSlot
+  {
+    ComPtr<ID3D12Resource> m_readback;
+    bool                   m_resolved = false;
+  };
+
+  // Timestamps of every queue are in the units of its own clock
+  struct Clock
+  {
+    ID3D12CommandQueue* m_queue          = nullptr;
+    UINT64              m_gpuFrequency   = 1;
+    UINT64              m_gpuCalibration = 0;
+    UINT64              m_cpuCalibration = 0;
+
+    void         init(ID3D12CommandQueue* queue);
+    void         calibrate();
+    std::int64_t toQpc(UINT64 gpuTimestamp) const;
+    float        toMillis(UINT64 begin, UINT64 end) const;
+  };
+
+  ComPtr<ID3D12QueryHeap> m_queryHeap;
+  ComPtr<ID3D12QueryHeap> m_computeQueryHeap;
+  std::vector<Slot>       m_slots;
+  std::vector<GuiSlot>    m_guiSlots;
+  Timings                 m_timings;
+  Clock                   m_clock;
+  Clock                   m_computeClock;
+};
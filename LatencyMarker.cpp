@@ -0,0 +1,208 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <UdpSocket.h>
+
+#include <ClusterTelemetry.h>
+#include <LatencyMarker.h>
+#include <Timing.h>
+
+#include <algorithm>
+#include <cstring>
+#include <nvh/nvprint.hpp>
+
+namespace {
+constexpr std::int64_t MAX_TRIGGER_TIME_DELTA = 10 * SYSTEM_TIME_FREQUENCY;  // triggers further away are rejected
+}  // namespace
+
+bool LatencyMarker::open(std::string const& broadcastAddress, std::uint16_t listenPort, std::uint32_t leadMillis)
+{
+  close();
+  m_pending.clear();
+  m_pending.reserve(16);
+  m_leadSystemTime = static_cast<std::uint64_t>(leadMillis) * (SYSTEM_TIME_FREQUENCY / 1000);
+  m_sender         = defaultNodeName();
+
+  if(!broadcastAddress.empty())
+  {
+    const std::size_t colon = broadcastAddress.rfind(':');
+    if(colon == std::string::npos)
+    {
+      LOGE("Flash broadcast address must be given as host:port.\n");
+      return false;
+    }
+    const std::string host = broadcastAddress.substr(0, colon);
+    const std::string port = broadcastAddress.substr(colon + 1);
+    if(!openUdpSocket(m_sendSocket))
+    {
+      return false;
+    }
+    addrinfo hints    = {};
+    hints.ai_family   = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_protocol = IPPROTO_UDP;
+    addrinfo* result  = nullptr;
+    if(getaddrinfo(host.c_str(), port.c_str(), &hints, &result) != 0 || result == nullptr)
+    {
+      LOGE("Could not resolve flash broadcast address '%s'.\n", broadcastAddress.c_str());
+      closeSocket(m_sendSocket);
+      return false;
+    }
+    const char* address = reinterpret_cast<const char*>(result->ai_addr);
+    m_broadcastAddress.assign(address, address + result->ai_addrlen);
+    freeaddrinfo(result);
+    BOOL broadcast = TRUE;
+    setsockopt(static_cast<SOCKET>(m_sendSocket), SOL_SOCKET, SO_BROADCAST, reinterpret_cast<char const*>(&broadcast),
+               sizeof(broadcast));
+  }
+
+  if(listenPort != 0)
+  {
+    if(!openUdpSocket(m_receiveSocket))
+    {
+      close();
+      return false;
+    }
+    // Every window of a node listens on the same port, each of them receives its own copy of a broadcast
+    const SOCKET udpSocket = static_cast<SOCKET>(m_receiveSocket);
+    BOOL         reuse     = TRUE;
+    setsockopt(udpSocket, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<char const*>(&reuse), sizeof(reuse));
+    sockaddr_in address     = {};
+    address.sin_family      = AF_INET;
+    address.sin_port        = htons(listenPort);
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    if(bind(udpSocket, reinterpret_cast<sockaddr const*>(&address), sizeof(address)) == SOCKET_ERROR)
+    {
+      LOGE("Could not bind flash trigger socket to port %u, error %d.\n", listenPort, WSAGetLastError());
+      close();
+      return false;
+    }
+    // Wake up regularly so close() does not hang
+    DWORD timeoutMillis = 100;
+    setsockopt(udpSocket, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<char const*>(&timeoutMillis),
+               sizeof(timeoutMillis));
+
+    m_stop   = false;
+    m_thread = std::thread([this]() { receiveLoop(); });
+  }
+  m_open = true;
+  return true;
+}
+
+void LatencyMarker::close()
+{
+  if(m_thread.joinable())
+  {
+    m_stop = true;
+    m_thread.join();
+  }
+  closeSocket(m_receiveSocket);
+  closeSocket(m_sendSocket);
+  m_broadcastAddress.clear();
+  m_open = false;
+}
+
+void LatencyMarker::trigger(std::int64_t eventTime)
+{
+  if(!m_open)
+  {
+    return;
+  }
+
+  Flash flash;
+  flash.m_eventTime   = eventTime;
+  flash.m_receiveTime = eventTime;
+  if(m_sendSocket != INVALID_SOCKET)
+  {
+    // All nodes flash at the same system time, far enough ahead for the trigger to arrive everywhere
+    FlashTrigger trigger;
+    trigger.m_id              = m_nextId++;
+    trigger.m_flashSystemTime = systemTimeNow() + m_leadSystemTime;
+    std::strncpy(trigger.m_sender, m_sender.c_str(), sizeof(trigger.m_sender) - 1);
+    if(sendto(static_cast<SOCKET>(m_sendSocket), reinterpret_cast<char const*>(&trigger), sizeof(trigger), 0,
+              reinterpret_cast<sockaddr const*>(m_broadcastAddress.data()), static_cast<int>(m_broadcastAddress.size()))
+       == SOCKET_ERROR)
+    {
+      LOGW("Sending the flash trigger failed with error %d.\n", WSAGetLastError());
+    }
+    LOGI("Flash %llu triggered, all nodes flash in %.1f ms.\n", static_cast<unsigned long long>(trigger.m_id),
+         m_leadSystemTime / double(SYSTEM_TIME_FREQUENCY / 1000));
+    if(m_receiveSocket != INVALID_SOCKET)
+    {
+      // The listener receives the broadcast like every other node
+      return;
+    }
+    flash.m_id = trigger.m_id;
+    flash.m_eventTime += static_cast<std::int64_t>(m_leadSystemTime) * qpcFrequency() / SYSTEM_TIME_FREQUENCY;
+  }
+  else if(m_receiveSocket != INVALID_SOCKET)
+  {
+    // Listening nodes only flash for network triggers, so all windows of a node flash together
+    return;
+  }
+  else
+  {
+    flash.m_id = m_nextId++;
+  }
+  m_pending.push_back(flash);
+}
+
+bool LatencyMarker::due(std::int64_t recordTime, Flash& flash)
+{
+  Flash received;
+  while(m_received.pop(received))
+  {
+    m_pending.push_back(received);
+  }
+  auto earliest = std::min_element(m_pending.begin(), m_pending.end(), [](Flash const& a, Flash const& b) {
+    return a.m_eventTime < b.m_eventTime;
+  });
+  if(earliest == m_pending.end() || earliest->m_eventTime > recordTime)
+  {
+    return false;
+  }
+  flash = *earliest;
+  m_pending.erase(earliest);
+  return true;
+}
+
+void LatencyMarker::receiveLoop()
+{
+  while(!m_stop)
+  {
+    FlashTrigger trigger;
+    const int    received =
+        recv(static_cast<SOCKET>(m_receiveSocket), reinterpret_cast<char*>(&trigger), sizeof(trigger), 0);
+    if(received != sizeof(trigger) || trigger.m_magic != FLASH_TRIGGER_MAGIC
+       || trigger.m_version != FLASH_TRIGGER_VERSION)
+    {
+      continue;
+    }
+
+    // Both clocks are read back to back, the conversion error is the time between the two reads
+    const std::int64_t  receiveTime = qpcNow();
+    const std::uint64_t systemTime  = systemTimeNow();
+    const std::int64_t  delta       = static_cast<std::int64_t>(trigger.m_flashSystemTime - systemTime);
+    if(delta < -MAX_TRIGGER_TIME_DELTA || delta > MAX_TRIGGER_TIME_DELTA)
+    {
+      LOGW("Flash %llu from %.32s is %.1f s away, the node clocks are not synchronized.\n",
+           static_cast<unsigned long long>(trigger.m_id), trigger.m_sender, delta / double(SYSTEM_TIME_FREQUENCY));
+      continue;
+    }
+    Flash flash;
+    flash.m_id          = trigger.m_id;
+    flash.m_eventTime   = receiveTime + delta * qpcFrequency() / SYSTEM_TIME_FREQUENCY;
+    flash.m_receiveTime = receiveTime;
+    flash.m_network     = true;
+    if(delta < 0)
+    {
+      LOGW("Flash %llu from %.32s arrived %.1f ms late, consider a longer -flashlead.\n",
+           static_cast<unsigned long long>(trigger.m_id), trigger.m_sender,
+           -delta / double(SYSTEM_TIME_FREQUENCY / 1000));
+    }
+    if(!m_received.push(flash))
+    {
+      LOGW("Too many pending flashes, flash %llu dropped.\n", static_cast<unsigned long long>(trigger.m_id));
+    }
+  }
+}
@@ -0,0 +1,71 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <ControlPlane.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Input-to-photon measurements: a key press or a network trigger makes the first frame recorded after the event flash
+// a high-contrast patch. A photodiode or a high-speed camera sees the flash, the log and the frame records have the
+// event, record, present and vblank times to correlate it with.
+
+constexpr std::uint32_t FLASH_TRIGGER_MAGIC   = 0x4c464250;  // 'PBFL'
+constexpr std::uint32_t FLASH_TRIGGER_VERSION = 1;
+
+// As it is sent over the network. The flash time is a UTC system time in 100 ns units (FILETIME), so cluster-wide
+// flashes need node clocks that are synchronized, e.g. with PTP; their offset adds to the measured photon skew.
+struct FlashTrigger
+{
+  std::uint32_t m_magic           = FLASH_TRIGGER_MAGIC;
+  std::uint32_t m_version         = FLASH_TRIGGER_VERSION;
+  std::uint64_t m_id              = 0;  // per sender, identifies the flash in the logs of all nodes
+  std::uint64_t m_flashSystemTime = 0;
+  char          m_sender[32]      = {};
+};
+
+// A flash that is due on this node, timestamps are raw QueryPerformanceCounter values
+struct Flash
+{
+  std::uint64_t m_id          = 0;
+  std::int64_t  m_eventTime   = 0;  // key press, or the flash time of a network trigger
+  std::int64_t  m_receiveTime = 0;  // arrival of a network trigger, the event time of local flashes
+  bool          m_network     = false;
+};
+
+class LatencyMarker
+{
+public:
+  ~LatencyMarker() { close(); }
+
+  // Both parameters are optional. A broadcast address ("host:port") makes key presses flash all listening nodes
+  // leadMillis after the press, a listen port receives such triggers. Without either, flashes are local only.
+  bool open(std::string const& broadcastAddress, std::uint16_t listenPort, std::uint32_t leadMillis);
+  void close();
+  bool isOpen() const { return m_open; }
+
+  // Render thread: a key was pressed at the given time
+  void trigger(std::int64_t eventTime);
+  // Render thread: the earliest flash that is due for a frame recorded at the given time, never blocks
+  bool due(std::int64_t recordTime, Flash& flash);
+
+private:
+  SpscQueue<Flash, 16> m_received;  // listener thread to render thread
+  std::vector<Flash>   m_pending;   // render thread only
+  std::thread          m_thread;
+  std::atomic<bool>    m_stop             = false;
+  bool                 m_open             = false;
+  std::uintptr_t       m_sendSocket       = ~std::uintptr_t(0);
+  std::uintptr_t       m_receiveSocket    = ~std::uintptr_t(0);
+  std::vector<char>    m_broadcastAddress;  // sockaddr of the broadcast address
+  std::uint64_t        m_leadSystemTime   = 0;  // in 100 ns units
+  std::uint64_t        m_nextId           = 1;
+  std::string          m_sender;
+
+  void receiveLoop();
+};
@@ -0,0 +1,52 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <LinePattern.h>
+
+bool parseLinePattern(std::string const& name, LinePattern& pattern)
+{
+  if(name == "l" || name == "lines")
+  {
+    pattern = LinePattern::LINES;
+  }
+  else if(name == "g" || name == "grid")
+  {
+    pattern = LinePattern::GRID;
+  }
+  else if(name == "d" || name == "diagonal")
+  {
+    pattern = LinePattern::DIAGONAL;
+  }
+  else if(name == "c" || name == "checkerboard")
+  {
+    pattern = LinePattern::CHECKERBOARD;
+  }
+  else if(name == "m" || name == "markers")
+  {
+    pattern = LinePattern::MARKERS;
+  }
+  else
+  {
+    return false;
+  }
+  return true;
+}
+
+char const* linePatternName(LinePattern pattern)
+{
+  switch(pattern)
+  {
+    case LinePattern::LINES:
+      return "Lines";
+    case LinePattern::GRID:
+      return "Grid";
+    case LinePattern::DIAGONAL:
+      return "Diagonal";
+    case LinePattern::CHECKERBOARD:
+      return "Checkerboard";
+    case LinePattern::MARKERS:
+      return "Markers";
+    default:
+      return "Unknown";
+  }
+}
@@ -0,0 +1,20 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// What the window shows behind the indicator bar. Must match the patterns in pattern_cs.hlsl.
+enum class LinePattern : std::uint32_t
+{
+  LINES,         // the scrolling lines, one instanced draw per orientation
+  GRID,          // thousands of scrolling lines, this and the following patterns are generated by a compute pass
+  DIAGONAL,      // diagonal lines sweeping across the screen
+  CHECKERBOARD,  // cells flipping every frame
+  MARKERS,       // a column of markers moving one cell per frame, placed differently on every display
+};
+
+bool        parseLinePattern(std::string const& name, LinePattern& pattern);
+char const* linePatternName(LinePattern pattern);
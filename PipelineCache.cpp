@@ -0,0 +1,190 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <PipelineCache.h>
+
+#include <cstdio>
+#include <fstream>
+#include <nvh/nvprint.hpp>
+
+void PipelineCache::init(ID3D12Device*      device,
+                         IDXGIAdapter*      adapter,
+                         std::string const& directory,
+                         std::string const& writerSuffix)
+{
+  deinit();
+  if(directory.empty())
+  {
+    return;
+  }
+
+  D3D12_FEATURE_DATA_SHADER_CACHE shaderCache = {};
+  if(FAILED(device->CheckFeatureSupport(D3D12_FEATURE_SHADER_CACHE, &shaderCache, sizeof(shaderCache)))
+     || (shaderCache.SupportFlags & D3D12_SHADER_CACHE_SUPPORT_LIBRARY) == 0
+     || FAILED(device->QueryInterface(IID_PPV_ARGS(&m_device))))
+  {
+    LOGI("Pipeline libraries are not supported, pipelines are compiled on every start.\n");
+    return;
+  }
+
+  // The user mode driver version, as shown in the device manager
+  LARGE_INTEGER driverVersion = {};
+  if(adapter == nullptr || FAILED(adapter->CheckInterfaceSupport(__uuidof(IDXGIDevice), &driverVersion)))
+  {
+    driverVersion.QuadPart = 0;
+  }
+  const LUID luid = device->GetAdapterLuid();
+  char       fileName[96];
+  std::snprintf(fileName, sizeof(fileName), "pipelines_%08lx%08lx_%u.%u.%u.%u.bin",
+                static_cast<unsigned long>(luid.HighPart), luid.LowPart, HIWORD(driverVersion.HighPart),
+                LOWORD(driverVersion.HighPart), HIWORD(driverVersion.LowPart), LOWORD(driverVersion.LowPart));
+  CreateDirectoryA(directory.c_str(), nullptr);
+  m_path     = directory + "/" + fileName;
+  m_tempPath = m_path + ".tmp" + writerSuffix;
+
+  std::ifstream file(m_path, std::ios::in | std::ios::binary | std::ios::ate);
+  if(file)
+  {
+    m_libraryData.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    if(!file.read(m_libraryData.data(), m_libraryData.size()))
+    {
+      m_libraryData.clear();
+    }
+  }
+  if(!m_libraryData.empty() && createLibrary(m_libraryData.data(), m_libraryData.size()))
+  {
+    LOGI("Loaded pipeline library %s.\n", m_path.c_str());
+    return;
+  }
+  m_libraryData.clear();
+  if(!createLibrary(nullptr, 0))
+  {
+    LOGW("Could not create a pipeline library, pipelines are compiled on every start.\n");
+    m_device.Reset();
+  }
+}
+
+void PipelineCache::deinit()
+{
+  store();
+  m_pipelines.clear();
+  m_library.Reset();
+  m_libraryData.clear();
+  m_device.Reset();
+  m_path.clear();
+  m_tempPath.clear();
+  m_modified = false;
+  m_loaded   = 0;
+  m_compiled = 0;
+}
+
+HRESULT PipelineCache::createPipelineState(ID3D12Device2*                          device,
+                                           wchar_t const*                          name,
+                                           D3D12_PIPELINE_STATE_STREAM_DESC const& desc,
+                                           ComPtr<ID3D12PipelineState>&            pipeline)
+{
+  if(m_library)
+  {
+    std::lock_guard guard(m_mutex);
+    if(SUCCEEDED(m_library->LoadPipeline(name, &desc, IID_PPV_ARGS(&pipeline))))
+    {
+      m_pipelines.emplace_back(name, pipeline);
+      ++m_loaded;
+      return S_OK;
+    }
+  }
+
+  // Compiling is the expensive part, so it is done outside of the lock
+  HRESULT hr = device->CreatePipelineState(&desc, IID_PPV_ARGS(&pipeline));
+  if(FAILED(hr))
+  {
+    return hr;
+  }
+  ++m_compiled;
+
+  if(m_library)
+  {
+    std::lock_guard guard(m_mutex);
+    m_pipelines.emplace_back(name, pipeline);
+    hr = m_library->StorePipeline(name, pipeline.Get());
+    if(hr == E_INVALIDARG)
+    {
+      // Stored with another description, e.g. by a build with other shaders. Entries can't be replaced.
+      replaceStaleLibrary();
+    }
+    else if(FAILED(hr))
+    {
+      LOGW("Could not store pipeline %ls in the pipeline library (0x%08x).\n", name, static_cast<unsigned>(hr));
+    }
+    m_modified = true;
+  }
+  return S_OK;
+}
+
+bool PipelineCache::store()
+{
+  std::lock_guard guard(m_mutex);
+  if(!m_library || !m_modified)
+  {
+    return true;
+  }
+  m_modified = false;
+
+  std::vector<char> data(m_library->GetSerializedSize());
+  if(FAILED(m_library->Serialize(data.data(), data.size())))
+  {
+    LOGW("Could not serialize the pipeline library.\n");
+    return false;
+  }
+  // Written under another name and moved in place, so an interrupted write or another window storing the same
+  // library never leaves a truncated file behind
+  {
+    std::ofstream file(m_tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+    if(!file.write(data.data(), data.size()))
+    {
+      LOGW("Could not write the pipeline library to %s.\n", m_tempPath.c_str());
+      return false;
+    }
+  }
+  if(!MoveFileExA(m_tempPath.c_str(), m_path.c_str(), MOVEFILE_REPLACE_EXISTING))
+  {
+    LOGW("Could not replace the pipeline library %s, error %u.\n", m_path.c_str(), GetLastError());
+    DeleteFileA(m_tempPath.c_str());
+    return false;
+  }
+  LOGI("Stored %zu pipelines in %s.\n", m_pipelines.size(), m_path.c_str());
+  return true;
+}
+
+bool PipelineCache::createLibrary(void const* data, size_t size)
+{
+  ComPtr<ID3D12PipelineLibrary1> library;
+  HRESULT                        hr = m_device->CreatePipelineLibrary(data, size, IID_PPV_ARGS(&library));
+  if(FAILED(hr))
+  {
+    // D3D12_ERROR_DRIVER_VERSION_MISMATCH or D3D12_ERROR_ADAPTER_NOT_FOUND if created by another driver or adapter
+    if(size != 0)
+    {
+      LOGI("Pipeline library %s can't be used (0x%08x), pipelines are compiled again.\n", m_path.c_str(),
+           static_cast<unsigned>(hr));
+    }
+    return false;
+  }
+  m_library = library;
+  return true;
+}
+
+void PipelineCache::replaceStaleLibrary()
+{
+  // The data of the old library stays referenced until deinit, pipelines loaded from it are still in use
+  m_library.Reset();
+  if(!createLibrary(nullptr, 0))
+  {
+    return;
+  }
+  for(auto const& [name, pipeline] : m_pipelines)
+  {
+    m_library->StorePipeline(name.c_str(), pipeline.Get());
+  }
+}
@@ -0,0 +1,59 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include <d3dx12.h>
+#include <dxgi1_4.h>
+#include <wrl/client.h>
+using Microsoft::WRL::ComPtr;
+
+// Pipeline states stored in an ID3D12PipelineLibrary that is serialized to disk. The file name contains the adapter
+// LUID and the user mode driver version, so every adapter and driver gets its own file. The LUID is only stable until
+// the next reboot, after that the first start compiles all pipelines again. Pipelines may be created from several
+// threads, the library itself is only accessed under a lock.
+class PipelineCache
+{
+public:
+  ~PipelineCache() { deinit(); }
+
+  // Without a directory, or if the OS or driver don't support pipeline libraries, pipelines are always compiled. The
+  // suffix keeps the temporary files of several writers of the same cache apart.
+  void init(ID3D12Device* device, IDXGIAdapter* adapter, std::string const& directory, std::string const& writerSuffix);
+  // Stores the library first
+  void deinit();
+
+  // Loads the pipeline from the library if it was stored under this name with the same description, compiles and
+  // stores it otherwise
+  HRESULT createPipelineState(ID3D12Device2* device, wchar_t const* name, D3D12_PIPELINE_STATE_STREAM_DESC const& desc,
+                              ComPtr<ID3D12PipelineState>& pipeline);
+  // Writes the library back to disk if pipelines were added since the last store
+  bool store();
+
+  bool          enabled() const { return m_library != nullptr; }
+  std::uint32_t loadedCount() const { return m_loaded; }
+  std::uint32_t compiledCount() const { return m_compiled; }
+
+private:
+  std::mutex                     m_mutex;
+  ComPtr<ID3D12Device1>          m_device;
+  ComPtr<ID3D12PipelineLibrary1> m_library;
+  std::vector<char>              m_libraryData;  // referenced by the library for its whole lifetime
+  std::string                    m_path;
+  std::string                    m_tempPath;
+  bool                           m_modified = false;
+  std::atomic<std::uint32_t>     m_loaded   = 0;
+  std::atomic<std::uint32_t>     m_compiled = 0;
+
+  // Everything created this run, to re-store them when a stale library has to be replaced
+  std::vector<std::pair<std::wstring, ComPtr<ID3D12PipelineState>>> m_pipelines;
+
+  bool createLibrary(void const* data, size_t size);
+  void replaceStaleLibrary();
+};
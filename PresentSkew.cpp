@@ -0,0 +1,67 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <PresentSkew.h>
+#include <Timing.h>
+
+#include <algorithm>
+#include <cstdlib>
+
+void PresentSkewMonitor::init(std::uint32_t windows)
+{
+  m_windows = std::min(windows, MAX_WINDOWS);
+  for(std::uint32_t i = 0; i < MAX_WINDOWS; ++i)
+  {
+    m_adapters[i]     = 0;
+    m_syncModes[i]    = 0;
+    m_lastPresents[i] = 0;
+  }
+  m_previousReference = 0;
+  m_skewMillis        = 0.0f;
+  m_peakSkewMillis    = 0.0f;
+}
+
+void PresentSkewMonitor::presented(std::uint32_t window, std::int64_t presentTime)
+{
+  if(window >= m_windows)
+  {
+    return;
+  }
+  m_lastPresents[window].store(presentTime, std::memory_order_relaxed);
+  if(window != 0)
+  {
+    return;
+  }
+
+  const std::int64_t period = presentTime - m_previousReference;
+  const bool         valid  = m_previousReference != 0 && period > 0;
+  m_previousReference       = presentTime;
+  if(!valid)
+  {
+    return;
+  }
+
+  // Other windows may have presented for this refresh already or not yet, so wrap the distance into half a period
+  std::int64_t maxSkew = 0;
+  for(std::uint32_t i = 1; i < m_windows; ++i)
+  {
+    const std::int64_t lastPresent = m_lastPresents[i].load(std::memory_order_relaxed);
+    if(lastPresent == 0)
+    {
+      continue;
+    }
+    std::int64_t skew = ((lastPresent - presentTime) % period + period) % period;
+    if(skew > period / 2)
+    {
+      skew -= period;
+    }
+    maxSkew = std::max(maxSkew, std::abs(skew));
+  }
+
+  const float skewMillis = static_cast<float>(qpcToMillis(maxSkew));
+  m_skewMillis           = skewMillis;
+  if(skewMillis > m_peakSkewMillis)
+  {
+    m_peakSkewMillis = skewMillis;
+  }
+}
@@ -0,0 +1,42 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Present call skew and present barrier sync modes of the windows of a single process, possibly on different adapters.
+// Every render thread reports when it called Present, the render thread of the first window evaluates the skew of all
+// other windows relative to its own presents. Windows presenting once per refresh are compared against the closest
+// present of the first window.
+class PresentSkewMonitor
+{
+public:
+  static constexpr std::uint32_t MAX_WINDOWS = 16;
+
+  void          init(std::uint32_t windows);
+  void          setAdapter(std::uint32_t window, std::uint32_t adapter) { m_adapters[window] = adapter; }
+  std::uint32_t windows() const { return m_windows; }
+  std::uint32_t adapter(std::uint32_t window) const { return m_adapters[window]; }
+
+  // Any render thread, never blocks
+  void presented(std::uint32_t window, std::int64_t presentTime);
+  void setSyncMode(std::uint32_t window, std::uint32_t syncMode) { m_syncModes[window] = syncMode; }
+
+  // Last present barrier sync mode reported by the window, PRESENT_BARRIER_NOT_JOINED if none
+  std::uint32_t syncMode(std::uint32_t window) const { return m_syncModes[window]; }
+
+  // Largest skew of any window at the last present of the first window, and the peak since init
+  float skewMillis() const { return m_skewMillis; }
+  float peakSkewMillis() const { return m_peakSkewMillis; }
+
+private:
+  std::uint32_t              m_windows                   = 0;
+  std::uint32_t              m_adapters[MAX_WINDOWS]     = {};  // set before any render thread starts
+  std::atomic<std::uint32_t> m_syncModes[MAX_WINDOWS]    = {};
+  std::atomic<std::int64_t>  m_lastPresents[MAX_WINDOWS] = {};
+  std::int64_t               m_previousReference         = 0;  // only used by the first window's render thread
+  std::atomic<float>         m_skewMillis                = 0.0f;
+  std::atomic<float>         m_peakSkewMillis            = 0.0f;
+};
@@ -0,0 +1,458 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <Benchmark.h>
+#include <RegressionBenchmark.h>
+#include <SyncMetrics.h>
+#include <Timing.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <nvh/nvprint.hpp>
+
+namespace {
+// A metric regresses if it is worse than the baseline by more than the relative threshold and the absolute slack,
+// the slack keeps the noise of values close to zero from counting as a regression
+struct Metric
+{
+  char const* m_key;
+  double BenchmarkResult::*m_value;
+  bool   m_higherIsWorse;
+  bool   m_relative;  // the threshold applies, otherwise only the slack
+  double m_slack;
+};
+const Metric METRICS[] = {
+    {"cpu_frame_ms", &BenchmarkResult::m_cpuFrameMillis, true, true, 0.05},
+    {"cpu_frame_p99_ms", &BenchmarkResult::m_cpuFrameP99Millis, true, true, 0.1},
+    {"gpu_ms", &BenchmarkResult::m_gpuMillis, true, true, 0.05},
+    {"present_margin_ms", &BenchmarkResult::m_presentMarginMillis, false, true, 0.1},
+    {"in_sync_ratio", &BenchmarkResult::m_inSyncRatio, false, false, 0.01},
+    {"resync_ms", &BenchmarkResult::m_resyncMillis, true, true, 50.0},
+};
+
+char const* windowModeName(BenchmarkWindowMode mode)
+{
+  switch(mode)
+  {
+    case BenchmarkWindowMode::WINDOWED:
+      return "windowed";
+    case BenchmarkWindowMode::BORDERLESS:
+      return "borderless";
+    case BenchmarkWindowMode::FULLSCREEN:
+      return "fullscreen";
+    default:
+      return "unknown";
+  }
+}
+
+// Value of "key": in a report line, negative if it is missing or null
+double findValue(std::string const& line, std::string const& key)
+{
+  const std::string pattern = "\"" + key + "\": ";
+  const std::size_t begin   = line.find(pattern);
+  if(begin == std::string::npos)
+  {
+    return -1.0;
+  }
+  char const*  text  = line.c_str() + begin + pattern.size();
+  char*        end   = nullptr;
+  const double value = std::strtod(text, &end);
+  return end != text ? value : -1.0;
+}
+}  // namespace
+
+std::string BenchmarkCase::name() const
+{
+  std::ostringstream name;
+  name << windowModeName(m_windowMode) << (m_stereo ? "/stereo" : "/mono") << (m_vsync ? "/vsync" : "/novsync")
+       << "/sleep" << m_sleepMillis << "/load" << std::fixed << std::setprecision(1) << m_gpuLoadMillis;
+  return name.str();
+}
+
+bool parseBenchmarkWindowModes(std::string const& letters, std::vector<BenchmarkWindowMode>& modes)
+{
+  modes.clear();
+  for(char letter : letters)
+  {
+    switch(letter)
+    {
+      case 'w':
+        modes.push_back(BenchmarkWindowMode::WINDOWED);
+        break;
+      case 'b':
+        modes.push_back(BenchmarkWindowMode::BORDERLESS);
+        break;
+      case 'f':
+        modes.push_back(BenchmarkWindowMode::FULLSCREEN);
+        break;
+      default:
+        return false;
+    }
+  }
+  return !modes.empty();
+}
+
+bool parseBenchmarkList(std::string const& text, std::vector<float>& values)
+{
+  values.clear();
+  std::istringstream stream(text);
+  std::string        item;
+  while(std::getline(stream, item, ','))
+  {
+    char*       end   = nullptr;
+    const float value = std::strtof(item.c_str(), &end);
+    if(item.empty() || *end != '\0' || !(value >= 0.0f))
+    {
+      return false;
+    }
+    values.push_back(value);
+  }
+  return !values.empty();
+}
+
+bool RegressionBenchmark::init(BenchmarkMatrix const& matrix, std::uint32_t measureFrames, std::uint32_t settleFrames,
+                               std::string const& reportPath, std::string const& baselinePath, float threshold)
+{
+  if(matrix.m_windowModes.empty() || matrix.m_sleepMillis.empty() || matrix.m_gpuLoadMillis.empty()
+     || measureFrames < 2 || reportPath.empty() || threshold < 0.0f)
+  {
+    return false;
+  }
+
+  // Window modes change least often, they are the slowest transitions
+  m_cases.clear();
+  for(BenchmarkWindowMode windowMode : matrix.m_windowModes)
+  {
+    for(bool stereo : {false, true})
+    {
+      if(stereo && !matrix.m_stereo)
+      {
+        continue;
+      }
+      for(bool vsync : {true, false})
+      {
+        for(std::uint32_t sleepMillis : matrix.m_sleepMillis)
+        {
+          for(float gpuLoadMillis : matrix.m_gpuLoadMillis)
+          {
+            m_cases.push_back({windowMode, stereo, vsync, sleepMillis, gpuLoadMillis});
+          }
+        }
+      }
+    }
+  }
+  m_results.assign(m_cases.size(), BenchmarkResult());
+  for(std::size_t i = 0; i < m_cases.size(); ++i)
+  {
+    m_results[i].m_name = m_cases[i].name();
+  }
+  m_frameMillis.clear();
+  m_frameMillis.reserve(measureFrames);
+
+  m_measureFrames = measureFrames;
+  m_settleFrames  = std::max<std::uint32_t>(settleFrames, 1);
+  m_reportPath    = reportPath;
+  m_baselinePath  = baselinePath;
+  m_threshold     = threshold;
+  m_regressions   = 0;
+  m_case          = 0;
+  m_running       = true;
+  m_finished      = false;
+  enterPhase(Phase::START);
+  LOGI("Benchmark: %zu cases of %u frames.\n", m_cases.size(), m_measureFrames);
+  return true;
+}
+
+bool RegressionBenchmark::usesGpuLoad() const
+{
+  return std::any_of(m_cases.begin(), m_cases.end(),
+                     [](BenchmarkCase const& benchmarkCase) { return benchmarkCase.m_gpuLoadMillis > 0.0f; });
+}
+
+std::optional<BenchmarkCase> RegressionBenchmark::update(FrameRecord const& record, NvU32 syncMode, bool transitionIdle)
+{
+  if(!m_running)
+  {
+    return {};
+  }
+
+  if(syncMode != m_lastSyncMode || !transitionIdle)
+  {
+    m_stableFrames = 0;
+    m_lastSyncMode = syncMode;
+  }
+  else
+  {
+    ++m_stableFrames;
+  }
+  const double phaseMillis = qpcToMillis(qpcNow() - m_phaseStart);
+  const bool   settled     = m_stableFrames >= m_settleFrames || phaseMillis > BENCHMARK_PHASE_TIMEOUT_MILLIS;
+
+  switch(m_phase)
+  {
+    case Phase::START:
+      if(!settled)
+      {
+        return {};
+      }
+      m_priorSyncMode = syncMode;
+      enterPhase(Phase::RESYNC);
+      return m_cases[m_case];
+    case Phase::RESYNC:
+    {
+      const bool resynced =
+          transitionIdle && presentBarrierSyncLevel(syncMode) >= presentBarrierSyncLevel(m_priorSyncMode);
+      if(!resynced && phaseMillis <= BENCHMARK_PHASE_TIMEOUT_MILLIS)
+      {
+        return {};
+      }
+      BenchmarkResult& result = m_results[m_case];
+      result.m_resynced       = resynced;
+      result.m_resyncMillis   = resynced ? phaseMillis : -1.0;
+      if(!resynced)
+      {
+        LOGW("Benchmark: %s did not return to %s.\n", result.m_name.c_str(),
+             presentBarrierSyncModeName(m_priorSyncMode));
+      }
+      enterPhase(Phase::SETTLE);
+      return {};
+    }
+    case Phase::SETTLE:
+      if(settled)
+      {
+        enterPhase(Phase::MEASURE);
+      }
+      return {};
+    case Phase::MEASURE:
+      measure(record);
+      if(m_measuredFrames < m_measureFrames)
+      {
+        return {};
+      }
+      finishCase();
+      if(++m_case == m_cases.size())
+      {
+        finish();
+        return {};
+      }
+      enterPhase(Phase::RESYNC);
+      return m_cases[m_case];
+  }
+  return {};
+}
+
+void RegressionBenchmark::enterPhase(Phase phase)
+{
+  m_phase        = phase;
+  m_phaseStart   = qpcNow();
+  m_stableFrames = 0;
+  if(phase == Phase::MEASURE)
+  {
+    m_frameMillis.clear();
+    m_measuredFrames  = 0;
+    m_gpuMillisSum    = 0.0;
+    m_gpuSamples      = 0;
+    m_marginMillisSum = 0.0;
+    m_marginSamples   = 0;
+    m_lastPresent     = 0;
+    m_statsValid      = false;
+  }
+}
+
+void RegressionBenchmark::measure(FrameRecord const& record)
+{
+  ++m_measuredFrames;
+  if(record.m_flags & FRAME_RECORD_WAIT_TIMEOUT)
+  {
+    m_lastPresent = 0;
+    return;
+  }
+
+  if(m_lastPresent != 0 && m_frameMillis.size() < m_frameMillis.capacity())
+  {
+    m_frameMillis.push_back(qpcToMillis(record.m_presentBegin - m_lastPresent));
+  }
+  m_lastPresent = record.m_presentBegin;
+  if(record.m_flags & FRAME_RECORD_GPU_TIMINGS)
+  {
+    m_gpuMillisSum += qpcToMillis(record.m_gpuEnd - record.m_gpuBegin);
+    ++m_gpuSamples;
+  }
+  if((record.m_flags & FRAME_RECORD_VSYNC) && (record.m_vsync.m_flags & VSYNC_SAMPLE_VBLANK))
+  {
+    m_marginMillisSum += qpcToMillis(record.m_vsync.m_vblankTime - record.m_presentBegin);
+    ++m_marginSamples;
+  }
+  if(record.m_flags & FRAME_RECORD_PRESENT_BARRIER_STATS)
+  {
+    if(!m_statsValid)
+    {
+      m_firstStats = record.m_presentBarrierStats;
+      m_statsValid = true;
+    }
+    m_lastStats = record.m_presentBarrierStats;
+  }
+}
+
+void RegressionBenchmark::finishCase()
+{
+  BenchmarkResult& result = m_results[m_case];
+  if(!m_frameMillis.empty())
+  {
+    double sum = 0.0;
+    for(double millis : m_frameMillis)
+    {
+      sum += millis;
+    }
+    result.m_cpuFrameMillis    = sum / m_frameMillis.size();
+    result.m_cpuFrameP99Millis = percentile(m_frameMillis, 0.99f);
+  }
+  if(m_gpuSamples != 0)
+  {
+    result.m_gpuMillis = m_gpuMillisSum / m_gpuSamples;
+  }
+  if(m_marginSamples != 0)
+  {
+    result.m_presentMarginMillis = m_marginMillisSum / m_marginSamples;
+  }
+  // The counters restart when the present barrier is joined again, such intervals have no ratio
+  if(m_statsValid && m_lastStats.PresentCount > m_firstStats.PresentCount)
+  {
+    const NvU32 presents = m_lastStats.PresentCount - m_firstStats.PresentCount;
+    const NvU32 inSync   = m_lastStats.PresentInSyncCount - m_firstStats.PresentInSyncCount;
+    result.m_inSyncRatio = std::min(static_cast<double>(inSync) / presents, 1.0);
+  }
+
+  LOGI("Benchmark: %s frame %.2f ms, p99 %.2f ms, GPU %.2f ms, margin %.2f ms, in sync %.3f\n", result.m_name.c_str(),
+       result.m_cpuFrameMillis, result.m_cpuFrameP99Millis, result.m_gpuMillis, result.m_presentMarginMillis,
+       result.m_inSyncRatio);
+}
+
+void RegressionBenchmark::finish()
+{
+  m_running  = false;
+  m_finished = true;
+  if(!m_baselinePath.empty())
+  {
+    compareBaseline();
+  }
+  if(writeReport())
+  {
+    LOGI("Benchmark report written to %s.\n", m_reportPath.c_str());
+  }
+  else
+  {
+    LOGE("Could not write the benchmark report to %s.\n", m_reportPath.c_str());
+  }
+}
+
+void RegressionBenchmark::compareBaseline()
+{
+  std::ifstream file(m_baselinePath);
+  if(!file)
+  {
+    LOGE("Could not read the benchmark baseline %s.\n", m_baselinePath.c_str());
+    return;
+  }
+
+  // Reports have one case per line, see writeReport()
+  std::map<std::string, std::string> baseline;
+  std::string                        line;
+  const std::string                  namePattern = "\"name\": \"";
+  while(std::getline(file, line))
+  {
+    const std::size_t begin = line.find(namePattern);
+    const std::size_t end   = begin != std::string::npos ? line.find('"', begin + namePattern.size()) : begin;
+    if(end != std::string::npos)
+    {
+      baseline[line.substr(begin + namePattern.size(), end - begin - namePattern.size())] = line;
+    }
+  }
+
+  for(BenchmarkResult& result : m_results)
+  {
+    auto it = baseline.find(result.m_name);
+    if(it == baseline.end())
+    {
+      LOGW("Benchmark: %s is not in the baseline.\n", result.m_name.c_str());
+      continue;
+    }
+    if(!result.m_resynced && it->second.find("\"resynced\": true") != std::string::npos)
+    {
+      result.m_regressions = "resynced";
+    }
+    for(Metric const& metric : METRICS)
+    {
+      const double value         = result.*metric.m_value;
+      const double baselineValue = findValue(it->second, metric.m_key);
+      if(value < 0.0 || baselineValue < 0.0)
+      {
+        continue;
+      }
+      const double worse = metric.m_higherIsWorse ? value - baselineValue : baselineValue - value;
+      const double limit = std::max(metric.m_relative ? m_threshold * baselineValue : 0.0, metric.m_slack);
+      if(worse > limit)
+      {
+        result.m_regressions += result.m_regressions.empty() ? metric.m_key : std::string("|") + metric.m_key;
+        LOGW("Benchmark: %s %s regressed from %.3f to %.3f.\n", result.m_name.c_str(), metric.m_key, baselineValue,
+             value);
+      }
+    }
+    if(!result.m_regressions.empty())
+    {
+      ++m_regressions;
+    }
+  }
+  if(m_regressions != 0)
+  {
+    LOGE("Benchmark: %u of %zu cases regressed against %s.\n", m_regressions, m_results.size(),
+         m_baselinePath.c_str());
+  }
+  else
+  {
+    LOGI("Benchmark: no regressions against %s.\n", m_baselinePath.c_str());
+  }
+}
+
+bool RegressionBenchmark::writeReport() const
+{
+  std::ofstream file(m_reportPath, std::ios::out | std::ios::trunc);
+  if(!file)
+  {
+    return false;
+  }
+
+  // One case per line, so a report can be read back as the baseline of a later run without a JSON parser
+  auto writeValue = [&file](double value) {
+    if(value < 0.0)
+    {
+      file << "null";
+    }
+    else
+    {
+      file << value;
+    }
+  };
+  file << std::fixed << std::setprecision(3);
+  file << "{\n  \"measureFrames\": " << m_measureFrames << ",\n  \"settleFrames\": " << m_settleFrames
+       << ",\n  \"threshold\": " << m_threshold << ",\n  \"regressions\": " << m_regressions << ",\n  \"cases\": [";
+  char const* separator = "";
+  for(BenchmarkResult const& result : m_results)
+  {
+    file << separator << "\n    {\"name\": \"" << result.m_name << "\", \"resynced\": "
+         << (result.m_resynced ? "true" : "false");
+    for(Metric const& metric : METRICS)
+    {
+      file << ", \"" << metric.m_key << "\": ";
+      writeValue(result.*metric.m_value);
+    }
+    file << ", \"regressions\": \"" << result.m_regressions << "\"}";
+    separator = ",";
+  }
+  file << "\n  ]\n}\n";
+  return static_cast<bool>(file);
+}
@@ -0,0 +1,132 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <nvapi.h>
+
+#include <FrameRecorder.h>
+
+// Exit code of a benchmark run with a regression against the baseline, see Validation.h for the others
+constexpr int BENCHMARK_REGRESSION = 4;
+
+enum class BenchmarkWindowMode : std::uint32_t
+{
+  WINDOWED,
+  BORDERLESS,
+  FULLSCREEN,
+};
+
+// One configuration of the benchmark matrix
+struct BenchmarkCase
+{
+  BenchmarkWindowMode m_windowMode    = BenchmarkWindowMode::WINDOWED;
+  bool                m_stereo        = false;
+  bool                m_vsync         = true;
+  std::uint32_t       m_sleepMillis   = 0;
+  float               m_gpuLoadMillis = 0.0f;  // target of the synthetic load, 0 for the minimum amount of work
+
+  // e.g. "borderless/mono/vsync/sleep0/load2.0", identifies the case in the report and the baseline
+  std::string name() const;
+};
+
+// Every combination is a case, vsync is always measured on and off
+struct BenchmarkMatrix
+{
+  std::vector<BenchmarkWindowMode> m_windowModes;
+  bool                             m_stereo = false;  // mono and stereo, needs a stereo capable display
+  std::vector<std::uint32_t>       m_sleepMillis;
+  std::vector<float>               m_gpuLoadMillis;
+};
+
+// A string of window mode letters: (w)indowed, (b)orderless, (f)ullscreen
+bool parseBenchmarkWindowModes(std::string const& letters, std::vector<BenchmarkWindowMode>& modes);
+// A comma-separated list of non-negative numbers, e.g. "0,2.5,4"
+bool parseBenchmarkList(std::string const& text, std::vector<float>& values);
+
+// Metrics of one case, negative for metrics that were not available
+struct BenchmarkResult
+{
+  std::string m_name;
+  double      m_cpuFrameMillis      = -1.0;  // mean time between presents
+  double      m_cpuFrameP99Millis   = -1.0;
+  double      m_gpuMillis           = -1.0;
+  double      m_presentMarginMillis = -1.0;  // mean present to vblank margin, from the vsync probe
+  double      m_inSyncRatio         = -1.0;  // presents in sync of all presents while measuring
+  double      m_resyncMillis        = -1.0;  // from applying the case until the sync mode was back
+  bool        m_resynced            = false;
+  std::string m_regressions;  // metrics that regressed against the baseline, separated by '|'
+};
+
+// Fixed matrix of window modes, stereo, vsync, sleep intervals and GPU load levels for qualifying driver and NvAPI
+// updates. Every case is applied, given time to resync and settle, and measured for a number of frames. The results
+// are written as JSON and compared against a baseline report of an earlier run. Runs on the render thread, which
+// applies the returned cases.
+class RegressionBenchmark
+{
+public:
+  // An empty baseline path only writes the report, the threshold is relative, e.g. 0.1 for 10%
+  bool init(BenchmarkMatrix const& matrix, std::uint32_t measureFrames, std::uint32_t settleFrames,
+            std::string const& reportPath, std::string const& baselinePath, float threshold);
+  bool isRunning() const { return m_running; }
+  bool isFinished() const { return m_finished; }
+  int  exitCode() const { return m_regressions != 0 ? BENCHMARK_REGRESSION : 0; }
+
+  // True if any case uses the synthetic GPU load, its pipelines have to be created then
+  bool usesGpuLoad() const;
+
+  // Once per presented frame with its complete record, returns the case to apply with the next frame if there is one
+  std::optional<BenchmarkCase> update(FrameRecord const& record, NvU32 syncMode, bool transitionIdle);
+
+private:
+  enum class Phase
+  {
+    START,    // before the first case, establishes the sync mode every case has to get back to
+    RESYNC,   // a case was applied, until the transition finished and the sync mode is back
+    SETTLE,   // until the sync mode was stable for the settle frames
+    MEASURE,  // the measured frames
+  };
+
+  std::vector<BenchmarkCase>   m_cases;
+  std::vector<BenchmarkResult> m_results;
+  std::uint32_t                m_measureFrames = 300;
+  std::uint32_t                m_settleFrames  = 120;
+  std::string                  m_reportPath;
+  std::string                  m_baselinePath;
+  float                        m_threshold   = 0.1f;
+  std::uint32_t                m_regressions = 0;
+  bool                         m_running     = false;
+  bool                         m_finished    = false;
+
+  Phase         m_phase         = Phase::START;
+  std::size_t   m_case          = 0;
+  std::int64_t  m_phaseStart    = 0;
+  std::uint32_t m_stableFrames  = 0;
+  NvU32         m_lastSyncMode  = PRESENT_BARRIER_NOT_JOINED;
+  NvU32         m_priorSyncMode = PRESENT_BARRIER_NOT_JOINED;
+
+  // Samples of the case being measured, m_frameMillis is reserved by init()
+  std::vector<double>                 m_frameMillis;
+  std::uint32_t                       m_measuredFrames  = 0;
+  double                              m_gpuMillisSum    = 0.0;
+  std::uint32_t                       m_gpuSamples      = 0;
+  double                              m_marginMillisSum = 0.0;
+  std::uint32_t                       m_marginSamples   = 0;
+  std::int64_t                        m_lastPresent     = 0;
+  bool                                m_statsValid      = false;
+  NV_PRESENT_BARRIER_FRAME_STATISTICS m_firstStats      = {};
+  NV_PRESENT_BARRIER_FRAME_STATISTICS m_lastStats       = {};
+
+  void enterPhase(Phase phase);
+  void measure(FrameRecord const& record);
+  void finishCase();
+  void finish();
+  // Reads the baseline before the report is written, both may be the same file
+  void compareBaseline();
+  bool writeReport() const;
+};
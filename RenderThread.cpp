@@ -1,12 +1,20 @@
 // Copyright 2020-2021 NVIDIA Corporation
 // SPDX-License-Identifier: Apache-2.0
 
+#include <LinePattern.h>
 #include <RenderThread.h>
+#include <Shaders.h>
+#include <Timing.h>
 #include <imgui.h>
 #include <backends/imgui_impl_dx12.h>
 #include <backends/imgui_impl_glfw.h>
 #include <nvdx12/error_dx12.hpp>
 
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
 #ifndef NDEBUG
 #define CHECK_NV(status)                                                                                               \
   do                                                                                                                   \
@@ -26,15 +34,106 @@
 
 #define BACK_BUFFER_FORMAT DXGI_FORMAT_R8G8B8A8_UNORM
 
+// Root parameters of root_signature.hlsli
+static constexpr UINT ROOT_CONSTANTS   = 0;
+static constexpr UINT ROOT_TEXTURES    = 1;
+static constexpr UINT ROOT_PATTERN_UAV = 2;
+static constexpr UINT ROOT_PATTERN_SRV = 3;
+// Upload ring range of every frame, constants of all passes and eyes take a few KB
+static constexpr UINT64 UPLOAD_RING_SLOT_BYTES = 64 * 1024;
+// Threads per group of pattern_cs.hlsl and the size of its PatternElement
+static constexpr UINT PATTERN_GROUP_SIZE   = 64;
+static constexpr UINT PATTERN_ELEMENT_SIZE = 32;
+// Threads per group in x and y of load_cs.hlsl, and the number of floats it writes
+static constexpr UINT LOAD_GROUP_SIZE   = 8;
+static constexpr UINT LOAD_RESULT_COUNT = 64;
+
+// Transitions poll the frame fence in short waits so pausing and interrupting stay responsive
+static constexpr DWORD TRANSITION_POLL_MILLIS = 1;
+// Transitions that do not reach SYNC_SYSTEM within this time count as not resynced
+static constexpr double TRANSITION_RESYNC_TIMEOUT_MILLIS = 10000.0;
+
+// FNV-1a over everything that ends up in the gui texture
+static std::uint64_t hashDrawData(ImDrawData const& drawData)
+{
+  std::uint64_t hash = 14695981039346656037ull;
+  auto          add  = [&hash](void const* data, size_t size) {
+    for(size_t i = 0; i < size; ++i)
+    {
+      hash = (hash ^ static_cast<unsigned char const*>(data)[i]) * 1099511628211ull;
+    }
+  };
+  add(&drawData.DisplaySize, sizeof(drawData.DisplaySize));
+  for(int i = 0; i < drawData.CmdListsCount; ++i)
+  {
+    ImDrawList const* drawList = drawData.CmdLists[i];
+    add(drawList->VtxBuffer.Data, drawList->VtxBuffer.size_in_bytes());
+    add(drawList->IdxBuffer.Data, drawList->IdxBuffer.size_in_bytes());
+    for(ImDrawCmd const& cmd : drawList->CmdBuffer)
+    {
+      add(&cmd.ClipRect, sizeof(cmd.ClipRect));
+      add(&cmd.TextureId, sizeof(cmd.TextureId));
+      add(&cmd.ElemCount, sizeof(cmd.ElemCount));
+    }
+  }
+  return hash;
+}
+
+// Union of the clip rectangles of all draw commands, limited to the given bounds
+static D3D12_RECT drawDataBounds(ImDrawData const& drawData, D3D12_RECT const& bounds)
+{
+  float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+  for(int i = 0; i < drawData.CmdListsCount; ++i)
+  {
+    for(ImDrawCmd const& cmd : drawData.CmdLists[i]->CmdBuffer)
+    {
+      minX = std::min(minX, cmd.ClipRect.x - drawData.DisplayPos.x);
+      minY = std::min(minY, cmd.ClipRect.y - drawData.DisplayPos.y);
+      maxX = std::max(maxX, cmd.ClipRect.z - drawData.DisplayPos.x);
+      maxY = std::max(maxY, cmd.ClipRect.w - drawData.DisplayPos.y);
+    }
+  }
+  if(minX >= maxX || minY >= maxY)
+  {
+    return {};
+  }
+  D3D12_RECT rect;
+  rect.left   = std::max(bounds.left, static_cast<LONG>(std::floor(minX)));
+  rect.top    = std::max(bounds.top, static_cast<LONG>(std::floor(minY)));
+  rect.right  = std::min(bounds.right, static_cast<LONG>(std::ceil(maxX)));
+  rect.bottom = std::min(bounds.bottom, static_cast<LONG>(std::ceil(maxY)));
+  return rect.left < rect.right && rect.top < rect.bottom ? rect : D3D12_RECT{};
+}
+
+static bool isEmpty(D3D12_RECT const& rect)
+{
+  return rect.left >= rect.right || rect.top >= rect.bottom;
+}
+
 RenderThread::RenderThread() {}
 
-bool RenderThread::start(Configuration const& initialConfig, WindowCallback* windowCallback)
+bool RenderThread::start(Configuration const& initialConfig, WindowCallback* windowCallback,
+                         nvdx12::Context* sharedContext, PresentSkewMonitor* presentSkew)
 {
   m_config         = initialConfig;
   m_windowCallback = windowCallback;
+  m_context        = sharedContext ? sharedContext : &m_ownedContext;
+  m_presentSkew    = presentSkew;
+
+  // The sync interval may have been set through setVsync() already
+  m_pendingSettings.m_sleepIntervalInMilliseconds = m_config.m_sleepIntervalInMilliseconds;
+  m_pendingSettings.m_quadroSync                  = m_config.m_quadroSync;
+  m_syncInterval                                  = m_pendingSettings.m_syncInterval;
+  m_frameSettings.reset(m_pendingSettings);
 
   std::unique_lock lock(m_mutex);
   m_thread = std::thread([this]() {
+    // Keep the render thread on the processors closest to its adapter
+    GROUP_AFFINITY numaAffinity = {};
+    if(m_config.m_numaNode >= 0 && GetNumaNodeProcessorMaskEx(static_cast<USHORT>(m_config.m_numaNode), &numaAffinity))
+    {
+      SetThreadGroupAffinity(GetCurrentThread(), &numaAffinity, nullptr);
+    }
     {
       std::unique_lock lock(m_mutex);
       if(!init(m_config.m_winSize[0], m_config.m_winSize[1]))
@@ -47,8 +146,11 @@ bool RenderThread::start(Configuration const& initialConfig, WindowCallback* win
     while(!isInterrupted())
     {
       waitIfPaused();
-      renderFrame();
-      swapBuffers();
+      if(advanceTransition())
+      {
+        renderFrame();
+        swapBuffers();
+      }
     }
     sync();
     end();
@@ -70,6 +172,7 @@ void RenderThread::setStatus(Status newStatus)
 void RenderThread::interruptAndJoin()
 {
   {
+    // The render thread holds the mutex during display mode transitions, so m_displayMode is stable here
     std::lock_guard guard(m_mutex);
     setStatus(Status::INTERRUPTED);
     if(m_displayMode == DisplayMode::FULLSCREEN)
@@ -82,7 +185,6 @@ void RenderThread::interruptAndJoin()
 
 bool RenderThread::isInterrupted()
 {
-  std::lock_guard guard(m_mutex);
   return m_status == Status::INTERRUPTED;
 }
 
@@ -104,15 +206,315 @@ void RenderThread::togglePaused()
 
 void RenderThread::waitIfPaused()
 {
-  std::unique_lock lock(m_mutex);
+  // Status changes happen under the mutex, so checking without it first cannot miss a wake-up
   if(m_status == Status::PAUSED)
   {
+    std::unique_lock lock(m_mutex);
     m_conVar.wait(lock, [this]() { return m_status != Status::PAUSED; });
   }
 }
 
+bool RenderThread::pushCommand(Command command)
+{
+  if(!m_commands.push(command))
+  {
+    LOGW("Render thread command queue is full, request dropped.\n");
+    return false;
+  }
+  return true;
+}
+
+void RenderThread::publishSettings()
+{
+  m_frameSettings.publish(m_pendingSettings);
+}
+
+void RenderThread::fetchSettings()
+{
+  if(m_frameSettings.fetch())
+  {
+    FrameSettings const& settings          = m_frameSettings.front();
+    m_config.m_sleepIntervalInMilliseconds = settings.m_sleepIntervalInMilliseconds;
+    m_config.m_quadroSync                  = settings.m_quadroSync;
+    m_syncInterval                         = settings.m_syncInterval;
+  }
+}
+
+void RenderThread::processCommands()
+{
+  // Drain all pending requests first, repeated toggles cancel each other out
+  std::uint64_t presentBarrierChanges = 0;
+  Command       command;
+  while(m_commands.pop(command))
+  {
+    switch(command)
+    {
+      case Command::TOGGLE_STEREO:
+        m_requestToggleStereo = !m_requestToggleStereo;
+        break;
+      case Command::TOGGLE_BORDERLESS:
+        if(m_requestedDisplayMode != DisplayMode::FULLSCREEN)
+        {
+          m_requestedDisplayMode =
+              m_requestedDisplayMode == DisplayMode::BORDERLESS ? DisplayMode::WINDOWED : DisplayMode::BORDERLESS;
+        }
+        break;
+      case Command::TOGGLE_FULLSCREEN:
+        if(m_requestedDisplayMode != DisplayMode::BORDERLESS)
+        {
+          m_requestedDisplayMode =
+              m_requestedDisplayMode == DisplayMode::FULLSCREEN ? DisplayMode::WINDOWED : DisplayMode::FULLSCREEN;
+        }
+        break;
+      case Command::TOGGLE_PRESENT_BARRIER:
+        ++presentBarrierChanges;
+        break;
+      case Command::RESET_FRAME_COUNT:
+        m_requestResetFrameCount = true;
+        break;
+      case Command::FLASH_MARKER:
+        m_latencyMarker.trigger(m_flashRequestTime);
+        break;
+    }
+  }
+
+  if(m_transitionBenchmark.isRunning())
+  {
+    const NvU32 syncMode = m_presentBarrierJoined ? m_presentBarrierFrameStats.SyncMode : PRESENT_BARRIER_NOT_JOINED;
+    if(auto step = m_transitionBenchmark.update(syncMode, m_transitionState == TransitionState::IDLE))
+    {
+      executeBenchmarkStep(*step, presentBarrierChanges);
+    }
+    m_runFinished = m_transitionBenchmark.isFinished();
+  }
+  if(m_regressionBenchmark.isRunning())
+  {
+    // Called at the end of swapBuffers(), m_frameRecord is still the complete record of the presented frame
+    const NvU32 syncMode = m_presentBarrierJoined ? m_presentBarrierFrameStats.SyncMode : PRESENT_BARRIER_NOT_JOINED;
+    if(auto benchmarkCase =
+           m_regressionBenchmark.update(m_frameRecord, syncMode, m_transitionState == TransitionState::IDLE))
+    {
+      applyBenchmarkCase(*benchmarkCase);
+    }
+    m_runFinished = m_runFinished || m_regressionBenchmark.isFinished();
+  }
+  if(m_validation.isRunning())
+  {
+    const NvU32 syncMode = m_presentBarrierJoined ? m_presentBarrierFrameStats.SyncMode : PRESENT_BARRIER_NOT_JOINED;
+    m_validation.update(syncMode, m_syncMetrics);
+    m_runFinished = m_runFinished || m_validation.isFinished();
+  }
+
+  // Leaving fullscreen (e.g. through alt+tab) also requires a display mode transition
+  BOOL fullscreen;
+  HR_CHECK(m_swapChain->GetFullscreenState(&fullscreen, nullptr));
+  const bool fullscreenChanged = fullscreen != (m_displayMode == DisplayMode::FULLSCREEN);
+  const bool toggleStereo      = m_requestToggleStereo && !m_skipNextSwap;
+  if(!toggleStereo && !fullscreenChanged && m_requestedDisplayMode == m_displayMode && presentBarrierChanges == 0)
+  {
+    return;
+  }
+
+  // Nothing changes until the frames in flight are done, see advanceTransition()
+  if(m_transitionState == TransitionState::RESYNCING)
+  {
+    completeTransition(false);
+  }
+  const bool join                   = m_presentBarrierJoined != (presentBarrierChanges % 2 != 0);
+  m_transitionState                 = TransitionState::DRAINING;
+  m_transitionToggleStereo          = toggleStereo;
+  m_transitionJoinPresentBarrier    = join && !m_config.m_disablePresentBarrier;
+  m_transitionPresentBarrierChanges = presentBarrierChanges;
+  m_transitionRequestFrame          = m_frameIdx;
+  m_transitionRequestTime           = qpcNow();
+  m_transitionDrainStart            = m_transitionRequestTime;
+  if(toggleStereo)
+  {
+    m_requestToggleStereo = false;
+  }
+  HR_CHECK(m_frameFence->SetEventOnCompletion(m_frameIdx, m_syncEvt));
+}
+
+void RenderThread::executeBenchmarkStep(TransitionBenchmark::Step const& step, std::uint64_t& presentBarrierChanges)
+{
+  auto toggleDisplayMode = [this, &step](DisplayMode mode) {
+    if(!step.m_back)
+    {
+      m_benchmarkDisplayMode = m_displayMode;
+      m_requestedDisplayMode = m_displayMode == mode ? DisplayMode::WINDOWED : mode;
+    }
+    else
+    {
+      m_requestedDisplayMode = m_benchmarkDisplayMode;
+    }
+  };
+
+  switch(step.m_kind)
+  {
+    case TransitionKind::FULLSCREEN:
+      toggleDisplayMode(DisplayMode::FULLSCREEN);
+      break;
+    case TransitionKind::BORDERLESS:
+      toggleDisplayMode(DisplayMode::BORDERLESS);
+      break;
+    case TransitionKind::WIN_KEY:
+    {
+      INPUT inputs[2]      = {};
+      inputs[0].type       = INPUT_KEYBOARD;
+      inputs[0].ki.wVk     = VK_LWIN;
+      inputs[1]            = inputs[0];
+      inputs[1].ki.dwFlags = KEYEVENTF_KEYUP;
+      if(SendInput(2, inputs, sizeof(INPUT)) != 2)
+      {
+        HR_CHECK(HRESULT_FROM_WIN32(GetLastError()));
+      }
+      break;
+    }
+    case TransitionKind::STEREO:
+      m_requestToggleStereo = !m_requestToggleStereo;
+      break;
+    case TransitionKind::PRESENT_BARRIER:
+      ++presentBarrierChanges;
+      break;
+    default:
+      break;
+  }
+}
+
+void RenderThread::applyBenchmarkCase(BenchmarkCase const& benchmarkCase)
+{
+  switch(benchmarkCase.m_windowMode)
+  {
+    case BenchmarkWindowMode::BORDERLESS:
+      m_requestedDisplayMode = DisplayMode::BORDERLESS;
+      break;
+    case BenchmarkWindowMode::FULLSCREEN:
+      m_requestedDisplayMode = DisplayMode::FULLSCREEN;
+      break;
+    default:
+      m_requestedDisplayMode = DisplayMode::WINDOWED;
+      break;
+  }
+  m_requestToggleStereo = benchmarkCase.m_stereo != m_config.m_stereo;
+
+  // Overrides the settings until they are changed in the gui, fetchSettings() only applies new ones
+  m_syncInterval                         = benchmarkCase.m_vsync ? 1 : 0;
+  m_config.m_sleepIntervalInMilliseconds = benchmarkCase.m_sleepMillis;
+  m_gpuLoadController.reset(benchmarkCase.m_gpuLoadMillis,
+                            benchmarkCase.m_gpuLoadMillis > 0.0f ? static_cast<float>(m_gpuLoadController.work())
+                                                                 : GpuLoadController::MIN_WORK);
+}
+
+bool RenderThread::advanceTransition()
+{
+  if(m_transitionState != TransitionState::DRAINING)
+  {
+    return true;
+  }
+
+  if(m_frameFence->GetCompletedValue() < m_frameIdx)
+  {
+    const std::int64_t timeout = static_cast<std::int64_t>(m_config.m_syncTimeoutMillis) * qpcFrequency() / 1000;
+    if(qpcNow() - m_transitionDrainStart < timeout)
+    {
+      // Stale signals of earlier waits only cause an early poll
+      WaitForSingleObject(m_syncEvt, TRANSITION_POLL_MILLIS);
+      return false;
+    }
+    if(m_presentBarrierJoined)
+    {
+      LOGW("CPU/GPU synchronization timeout. Forcing present barrier leave.\n");
+      forcePresentBarrierChange();
+      m_transitionDrainStart = qpcNow();
+      return false;
+    }
+    LOGW("Frames in flight did not finish within %u ms, transitioning anyway.\n", m_config.m_syncTimeoutMillis);
+  }
+
+  m_transitionDrainedTime = qpcNow();
+  applyTransition();
+  return true;
+}
+
+void RenderThread::applyTransition()
+{
+  // The swap chain may end up on another output
+  m_vsyncProbe.close();
+  {
+    // All frames are done, so the transitions' syncs return right away and the mutex is only held briefly
+    std::lock_guard guard(m_mutex);
+    if(m_transitionToggleStereo)
+    {
+      swapResize(m_frameContext.m_width, m_frameContext.m_height, !m_config.m_stereo, false);
+    }
+    m_requestedDisplayMode = trySetDisplayMode(m_requestedDisplayMode);
+
+    // Re-creating the swap chain for stereo leaves the present barrier, it is re-joined if it was joined before
+    if(m_transitionJoinPresentBarrier != m_presentBarrierJoined)
+    {
+      forcePresentBarrierChange();
+    }
+    m_presentBarrierChangesCompleted += m_transitionPresentBarrierChanges;
+    m_conVar.notify_all();
+  }
+
+  openVsyncProbe();
+
+  m_transitionAppliedTime = qpcNow();
+  m_transitionState       = TransitionState::RESYNCING;
+  if(!m_presentBarrierJoined)
+  {
+    completeTransition(false);
+  }
+}
+
+void RenderThread::updateTransition()
+{
+  if(m_transitionState != TransitionState::RESYNCING)
+  {
+    return;
+  }
+  const NvU32 syncMode = m_presentBarrierFrameStats.SyncMode;
+  if(m_presentBarrierJoined && (syncMode == PRESENT_BARRIER_SYNC_SYSTEM || syncMode == PRESENT_BARRIER_SYNC_CLUSTER))
+  {
+    completeTransition(true);
+  }
+  else if(!m_presentBarrierJoined || qpcToMillis(qpcNow() - m_transitionAppliedTime) > TRANSITION_RESYNC_TIMEOUT_MILLIS)
+  {
+    LOGW("Present barrier did not reach SYNC_SYSTEM after the transition.\n");
+    completeTransition(false);
+  }
+}
+
+void RenderThread::completeTransition(bool resynced)
+{
+  const std::int64_t   end   = qpcNow();
+  ModeTransitionStats& stats = m_transitionStats;
+  ++stats.m_count;
+  stats.m_drainMillis  = static_cast<float>(qpcToMillis(m_transitionDrainedTime - m_transitionRequestTime));
+  stats.m_applyMillis  = static_cast<float>(qpcToMillis(m_transitionAppliedTime - m_transitionDrainedTime));
+  stats.m_resyncMillis = resynced ? static_cast<float>(qpcToMillis(end - m_transitionAppliedTime)) : 0.0f;
+  stats.m_totalMillis  = static_cast<float>(qpcToMillis(end - m_transitionRequestTime));
+  stats.m_frames       = static_cast<std::uint32_t>(m_frameIdx - m_transitionRequestFrame);
+  stats.m_resynced     = resynced;
+  m_transitionState    = TransitionState::IDLE;
+  LOGI("Transition took %.1f ms: drain %.1f ms, apply %.1f ms, resync %.1f ms, %u frames%s.\n", stats.m_totalMillis,
+       stats.m_drainMillis, stats.m_applyMillis, stats.m_resyncMillis, stats.m_frames,
+       resynced ? "" : ", present barrier not in sync");
+}
+
 bool RenderThread::init(unsigned int initialWidth, unsigned int initialHeight)
 {
+  // Startup phases are timed and logged once init is done
+  const std::int64_t initStart  = qpcNow();
+  std::int64_t       phaseStart = initStart;
+  auto               endPhase   = [&phaseStart]() {
+    const std::int64_t now    = qpcNow();
+    const double       millis = qpcToMillis(now - phaseStart);
+    phaseStart                = now;
+    return millis;
+  };
+
   if(m_config.m_testMode == "f" && m_config.m_startupDisplayMode == "b")
   {
     LOGE("Display mode must not be borderless when using fullscreen transition test mode.");
@@ -135,120 +537,509 @@ bool RenderThread::init(unsigned int initialWidth, unsigned int initialHeight)
     return false;
   }
 
+  if(!parseGpuLoadMode(m_config.m_gpuLoadMode, m_gpuLoadMode))
+  {
+    LOGE("GPU load mode must be (a)lu, (f)ill, or (b)andwidth.\n");
+    return false;
+  }
+  if(!parseLinePattern(m_config.m_linePattern, m_linePattern))
+  {
+    LOGE("Line pattern must be (l)ines, (g)rid, (d)iagonal, (c)heckerboard, or (m)arkers.\n");
+    return false;
+  }
+  if(m_linePattern != LinePattern::LINES && m_config.m_patternElements == 0)
+  {
+    LOGE("Number of pattern elements must be greater than 0.\n");
+    return false;
+  }
+  FramePacing framePacing = FramePacing::SLEEP;
+  if(!parseFramePacing(m_config.m_framePacing, framePacing))
+  {
+    LOGE("Frame pacing must be (s)leep, (w)aitable, (t)imed, or (j)ust-in-time.\n");
+    return false;
+  }
+  // Just-in-time pacing starts frames relative to the vblanks predicted by the probe
+  if(framePacing == FramePacing::JUST_IN_TIME)
+  {
+    m_config.m_vsyncProbe = true;
+  }
+  // Flashes are logged with the vblank they landed on
+  m_config.m_latencyFlash =
+      m_config.m_latencyFlash || m_config.m_flashPort != 0 || !m_config.m_flashBroadcastAddress.empty();
+  if(m_config.m_latencyFlash)
+  {
+    m_config.m_vsyncProbe = true;
+  }
+  if(m_config.m_transitionBenchmarkTrials != 0)
+  {
+    std::vector<TransitionKind> kinds;
+    if(!parseTransitionKinds(m_config.m_transitionBenchmarkKinds, kinds))
+    {
+      LOGE("Transition benchmark kinds must be a combination of (f)ullscreen, (b)orderless, (w)indows key, (s)tereo, "
+           "and (p)resent barrier.\n");
+      return false;
+    }
+    if(!m_transitionBenchmark.init(kinds, m_config.m_transitionBenchmarkTrials, m_config.m_transitionBenchmarkSettle,
+                                   m_config.m_transitionBenchmarkFile))
+    {
+      LOGE("Transition benchmark needs a report file.\n");
+      return false;
+    }
+  }
+  if(!m_config.m_benchmarkFile.empty())
+  {
+    BenchmarkMatrix    matrix;
+    std::vector<float> sleepMillis;
+    if(!parseBenchmarkWindowModes(m_config.m_benchmarkModes, matrix.m_windowModes))
+    {
+      LOGE("Benchmark window modes must be a combination of (w)indowed, (b)orderless, and (f)ullscreen.\n");
+      return false;
+    }
+    if(!parseBenchmarkList(m_config.m_benchmarkSleep, sleepMillis)
+       || !parseBenchmarkList(m_config.m_benchmarkLoad, matrix.m_gpuLoadMillis))
+    {
+      LOGE("Benchmark sleep intervals and GPU loads must be comma-separated lists of non-negative numbers.\n");
+      return false;
+    }
+    for(float millis : sleepMillis)
+    {
+      matrix.m_sleepMillis.push_back(static_cast<std::uint32_t>(millis));
+    }
+    matrix.m_stereo = m_config.m_benchmarkStereo;
+    if(!m_regressionBenchmark.init(matrix, m_config.m_benchmarkFrames, m_config.m_transitionBenchmarkSettle,
+                                   m_config.m_benchmarkFile, m_config.m_benchmarkBaseline,
+                                   m_config.m_benchmarkThresholdPercent / 100.0f))
+    {
+      LOGE("Benchmark needs at least 2 frames per case and a non-negative threshold.\n");
+      return false;
+    }
+    // The present margin of every case comes from the probe
+    m_config.m_vsyncProbe = true;
+  }
+  if(!parseMinimalContent(m_config.m_minimalContent, m_minimalContent))
+  {
+    LOGE("Minimal content must be (c)leared or (i)ndicator.\n");
+    return false;
+  }
+  // Minimal content leaves out everything that is not needed to see whether the present barrier is in sync
+  if(m_minimalContent != MinimalContent::NONE)
+  {
+    m_config.m_disableGui          = true;
+    m_config.m_showVerticalLines   = false;
+    m_config.m_showHorizontalLines = false;
+  }
+  if(m_config.m_validateFrames != 0 || m_config.m_validateSeconds > 0.0f)
+  {
+    NvU32 requiredSyncMode = PRESENT_BARRIER_SYNC_CLUSTER;
+    if(!parseSyncMode(m_config.m_validateSyncMode, requiredSyncMode))
+    {
+      LOGE("Validation sync mode must be client, system, or cluster.\n");
+      return false;
+    }
+    m_validation.init(m_config.m_validateFrames, m_config.m_validateSeconds, requiredSyncMode);
+  }
+  ThreadSchedulingSettings scheduling;
+  if(!parseThreadPriority(m_config.m_threadPriority, scheduling.m_priority))
+  {
+    LOGE("Thread priority must be (n)ormal, (a)bove normal, (h)ighest, or (t)ime critical.\n");
+    return false;
+  }
+  if(!parseAffinityMask(m_config.m_threadAffinity, scheduling.m_affinityMask))
+  {
+    LOGE("Thread affinity must be a hexadecimal processor mask.\n");
+    return false;
+  }
+  scheduling.m_mmcssTask             = m_config.m_mmcssTask;
+  scheduling.m_timerResolutionMillis = m_config.m_timerResolutionMillis;
+  // init runs on the render thread, an explicit affinity mask replaces the NUMA node placement
+  m_threadScheduling.apply(scheduling);
+
+  ThreadSchedulingSettings const& applied   = m_threadScheduling.applied();
+  m_telemetryPacket.m_affinityMask          = applied.m_affinityMask;
+  m_telemetryPacket.m_threadPriority        = applied.m_priority;
+  m_telemetryPacket.m_timerResolutionMillis = applied.m_timerResolutionMillis;
+  std::strncpy(m_telemetryPacket.m_mmcssTask, applied.m_mmcssTask.c_str(),
+               sizeof(m_telemetryPacket.m_mmcssTask) - 1);
+
+  if(m_config.m_backBufferCount < 2 || m_config.m_backBufferCount > DXGI_MAX_SWAP_CHAIN_BUFFERS)
+  {
+    LOGE("Number of back buffers must be between 2 and %d.\n", DXGI_MAX_SWAP_CHAIN_BUFFERS);
+    return false;
+  }
+  if(m_config.m_maxFrameLatency > DXGI_MAX_SWAP_CHAIN_BUFFERS)
+  {
+    LOGE("Maximum frame latency must not exceed %d.\n", DXGI_MAX_SWAP_CHAIN_BUFFERS);
+    return false;
+  }
+  // D3D12 swap chains only support a maximum frame latency with the frame latency waitable object
+  if(m_config.m_maxFrameLatency != 0 && framePacing == FramePacing::SLEEP)
+  {
+    LOGI("Maximum frame latency requires a waitable swap chain, using waitable frame pacing.\n");
+    framePacing = FramePacing::WAITABLE;
+  }
+  if(!m_frameScheduler.init(framePacing, m_config.m_presentPeriodMicros, m_config.m_maxFrameLatency))
+  {
+    return false;
+  }
+  FenceWaitStrategy fenceWait = FenceWaitStrategy::EVENT;
+  if(!parseFenceWaitStrategy(m_config.m_fenceWait, fenceWait))
+  {
+    LOGE("Fence wait strategy must be (e)vent, (s)pin, or (h)ybrid.\n");
+    return false;
+  }
+  if(!m_fenceWaiter.init(fenceWait, m_config.m_fenceSpinMicros))
+  {
+    return false;
+  }
+
+  const bool gpuLoad = m_config.m_gpuLoadTargetMillis > 0.0f || m_config.m_gpuLoadWork != 0
+                       || m_regressionBenchmark.usesGpuLoad();
+  m_gpuLoadController.reset(m_config.m_gpuLoadTargetMillis, static_cast<float>(m_config.m_gpuLoadWork));
+
+  // The frame counter file is just another output format of the frame recorder
+  std::string       recordFilePath = m_config.m_recordFilePath;
+  FrameRecordFormat recordFormat   = FrameRecordFormat::BINARY;
   if(!m_config.m_frameCounterFilePath.empty())
   {
-    m_frameCounterFile.open(m_config.m_frameCounterFilePath);
+    if(!recordFilePath.empty())
+    {
+      LOGE("Frame counter file and frame record file must not be used at the same time.\n");
+      return false;
+    }
+    recordFilePath = m_config.m_frameCounterFilePath;
+    recordFormat   = FrameRecordFormat::FRAME_COUNTER;
+  }
+  else if(m_config.m_recordFormat == "c" || m_config.m_recordFormat == "csv")
+  {
+    recordFormat = FrameRecordFormat::CSV;
+  }
+  else if(m_config.m_recordFormat == "f" || m_config.m_recordFormat == "framecounter")
+  {
+    recordFormat = FrameRecordFormat::FRAME_COUNTER;
+  }
+  else if(m_config.m_recordFormat != "b" && m_config.m_recordFormat != "binary")
+  {
+    LOGE("Record format must be (b)inary, (c)sv, or (f)ramecounter.\n");
+    return false;
+  }
+  // Soak runs rotate the frame records by default, so they cannot fill the disk
+  std::uint64_t recordMaxMegabytes = m_config.m_recordMaxMegabytes;
+  if(recordMaxMegabytes == 0 && m_config.m_soakIntervalMinutes != 0)
+  {
+    recordMaxMegabytes = 256;
+  }
+  if(!recordFilePath.empty()
+     && !m_frameRecorder.open(recordFilePath, recordFormat, m_config.m_recordCapacity, recordMaxMegabytes << 20))
+  {
+    return false;
   }
 
-  // Create device
-  if(!m_context.init(m_contextInfo))
+  m_syncMetrics.setInterval(m_config.m_syncMetricsInterval);
+
+  if(!m_config.m_telemetryAddress.empty()
+     && !m_telemetryPublisher.open(m_config.m_telemetryAddress, m_config.m_nodeName,
+                                   m_config.m_telemetryIntervalMillis))
+  {
+    return false;
+  }
+  if(m_config.m_latencyFlash
+     && !m_latencyMarker.open(m_config.m_flashBroadcastAddress, static_cast<std::uint16_t>(m_config.m_flashPort),
+                              m_config.m_flashLeadMillis))
   {
     return false;
   }
+  if(m_config.m_telemetryCollectorPort != 0
+     && !m_telemetryCollector.open(static_cast<std::uint16_t>(m_config.m_telemetryCollectorPort),
+                                   m_config.m_minInSyncRatio, m_config.m_maxPresentDriftPerSecond))
+  {
+    return false;
+  }
+
+  // Create device, unless it is shared with another window
+  if(m_context == &m_ownedContext && !m_ownedContext.init(m_contextInfo))
+  {
+    return false;
+  }
+  const double deviceMillis = endPhase();
+
+  // Pipelines are compiled or loaded from the pipeline library while NvAPI and the swap chain are initialized
+  if(!m_config.m_disablePipelineCache)
+  {
+    ComPtr<IDXGIAdapter> adapter;
+    m_context->m_factory->EnumAdapterByLuid(m_context->m_device->GetAdapterLuid(), IID_PPV_ARGS(&adapter));
+    const std::string directory =
+        m_config.m_pipelineCacheDirectory.empty() ? NVPSystem::exePath() : m_config.m_pipelineCacheDirectory;
+    m_pipelineCache.init(m_context->m_device, adapter.Get(), directory, std::to_string(m_config.m_windowIndex));
+  }
+  if(m_config.m_soakIntervalMinutes != 0)
+  {
+    ComPtr<IDXGIAdapter3> adapter;
+    m_context->m_factory->EnumAdapterByLuid(m_context->m_device->GetAdapterLuid(), IID_PPV_ARGS(&adapter));
+    if(!m_soakMonitor.open(m_config.m_soakFilePath, m_config.m_soakIntervalMinutes * 60, recordMaxMegabytes << 20,
+                           adapter.Get()))
+    {
+      return false;
+    }
+  }
+  double      pipelineMillis = 0.0;
+  std::thread pipelineThread([this, gpuLoad, &pipelineMillis]() {
+    const std::int64_t begin = qpcNow();
+    createPipelines(gpuLoad);
+    pipelineMillis = qpcToMillis(qpcNow() - begin);
+  });
 
   CHECK_NV(NvAPI_Initialize());
   if(!m_config.m_disablePresentBarrier)
   {
     // Check whether the system supports present barrier (Quadro + driver with support)
     bool presentBarrierSupported = false;
-    if(NvAPI_D3D12_QueryPresentBarrierSupport(m_context.m_device, &presentBarrierSupported) != NVAPI_OK || !presentBarrierSupported)
+    if(NvAPI_D3D12_QueryPresentBarrierSupport(m_context->m_device, &presentBarrierSupported) != NVAPI_OK
+       || !presentBarrierSupported)
+    {
+      LOGE("Present barrier is not supported on this system\n");
+      pipelineThread.join();
+      return false;
+    }
+  }
+  if(m_config.m_syncSampleIntervalMicros != 0
+     && !m_syncSampler.start(m_context->m_device, m_config.m_syncSampleIntervalMicros))
+  {
+    LOGW("Statistics and frame count are queried after every present.\n");
+  }
+  const double nvapiMillis = endPhase();
+
+  // Create fence and event used for context synchronization
+  HR_CHECK(m_context->m_device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_frameFence)));
+  HR_CHECK(m_context->m_device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_presentBarrierFence)));
+  HR_CHECK(m_context->m_device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_guiFence)));
+  m_syncEvt = CreateEventA(NULL, FALSE, FALSE, NULL);
+  m_guiEvt  = CreateEventA(NULL, FALSE, FALSE, NULL);
+  if(m_syncEvt == NULL || m_guiEvt == NULL)
+  {
+    HR_CHECK(HRESULT_FROM_WIN32(GetLastError()));
+  }
+
+  // Present and the frame's draws stay on the swap chain's queue, everything else that can overlap them moves
+  if(m_config.m_asyncCompute)
+  {
+    D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+    queueDesc.Type                     = D3D12_COMMAND_LIST_TYPE_DIRECT;
+    if(!m_config.m_disableGui)
+    {
+      HR_CHECK(m_context->m_device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_guiQueue)));
+      m_guiQueue->SetName(L"gui_queue");
+    }
+    if(m_linePattern != LinePattern::LINES || (gpuLoad && m_gpuLoadMode == GpuLoadMode::ALU))
+    {
+      queueDesc.Type = D3D12_COMMAND_LIST_TYPE_COMPUTE;
+      HR_CHECK(m_context->m_device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_computeQueue)));
+      m_computeQueue->SetName(L"compute_queue");
+      HR_CHECK(m_context->m_device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_computeFence)));
+    }
+    else
     {
-      LOGE("Present barrier is not supported on this system\n");
-      return false;
+      LOGI("Only line patterns and the ALU GPU load run on the compute queue, it is not used.\n");
     }
   }
 
-  // Create fence and event used for context synchronization
-  HR_CHECK(m_context.m_device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_frameFence)));
-  HR_CHECK(m_context.m_device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_presentBarrierFence)));
-  HR_CHECK(m_context.m_device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_guiFence)));
-  m_syncEvt = CreateEventA(NULL, FALSE, FALSE, "SyncEvent");
-  if(m_syncEvt == NULL)
-  {
-    HR_CHECK(HRESULT_FROM_WIN32(GetLastError()));
-  }
-
   // Create descriptor heaps
   D3D12_DESCRIPTOR_HEAP_DESC descriptorHeapDesc = {};
   descriptorHeapDesc.Type                       = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
-  descriptorHeapDesc.NumDescriptors             = D3D12_SWAP_CHAIN_SIZE * 2 + 1;
+  descriptorHeapDesc.NumDescriptors             = m_config.m_backBufferCount * 3 + GUI_TARGETS;
   descriptorHeapDesc.Flags                      = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-  HR_CHECK(m_context.m_device->CreateDescriptorHeap(&descriptorHeapDesc, IID_PPV_ARGS(&m_rtvHeap)));
+  HR_CHECK(m_context->m_device->CreateDescriptorHeap(&descriptorHeapDesc, IID_PPV_ARGS(&m_rtvHeap)));
 
   descriptorHeapDesc.Type           = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-  descriptorHeapDesc.NumDescriptors = 2;
+  descriptorHeapDesc.NumDescriptors = 4;
   descriptorHeapDesc.Flags          = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-  HR_CHECK(m_context.m_device->CreateDescriptorHeap(&descriptorHeapDesc, IID_PPV_ARGS(&m_cbvSrvUavHeap)));
+  HR_CHECK(m_context->m_device->CreateDescriptorHeap(&descriptorHeapDesc, IID_PPV_ARGS(&m_cbvSrvUavHeap)));
 
   // Create swap chain
   swapResize(initialWidth, initialHeight, m_config.m_stereo, true);
 
-  // Load compiled shader binaries from disk
-  std::vector<std::string> searchDirectories;
-  searchDirectories.push_back(NVPSystem::exePath());
-  searchDirectories.push_back(NVPSystem::exePath() + PROJECT_RELDIRECTORY);
-  searchDirectories.push_back(PROJECT_NAME);
-
-  std::string lineVsData      = nvh::loadFile("line_vs.cso", true, searchDirectories);
-  std::string indicatorVsData = nvh::loadFile("indicator_vs.cso", true, searchDirectories);
-  std::string psData          = nvh::loadFile("ps.cso", true, searchDirectories);
-  std::string guiVsData       = nvh::loadFile("gui_vs.cso", true, searchDirectories);
-  std::string guiPsData       = nvh::loadFile("gui_ps.cso", true, searchDirectories);
-  if(lineVsData.empty() || indicatorVsData.empty() || psData.empty() || guiPsData.empty())
-  {
-    LOGE(
-        "Could not load required shader binaries 'line_vs.cso', 'indicator_vs.cso', 'ps.cso', gui_vs.cso, and "
-        "gui_ps.cso\n");
+  m_gpuTimer.init(m_context->m_device, m_context->m_commandQueue, static_cast<UINT>(m_backBufferResources.size()),
+                  GUI_TARGETS);
+  if(m_computeQueue)
+  {
+    m_gpuTimer.initCompute(m_context->m_device, m_computeQueue.Get());
+  }
+  if(m_config.m_frameMarker
+     && !m_frameMarker.init(m_context->m_device, static_cast<UINT>(m_backBufferResources.size()), BACK_BUFFER_FORMAT))
+  {
+    pipelineThread.join();
     return false;
   }
 
   // Create command allocators and a single list which will be re-used every frame
   m_graphicsCommandAllocators.resize(m_backBufferResources.size(), nullptr);
-  m_guiCommandAllocators.resize(m_backBufferResources.size(), nullptr);
   m_allocatorFrameIndices.resize(m_backBufferResources.size(), 0);
   for(UINT i = 0; i < m_graphicsCommandAllocators.size(); ++i)
   {
-    HR_CHECK(m_context.m_device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT,
+    HR_CHECK(m_context->m_device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT,
                                                         IID_PPV_ARGS(&m_graphicsCommandAllocators[i])));
-    HR_CHECK(m_context.m_device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&m_guiCommandAllocators[i])));
   }
+  for(GuiTarget& target : m_guiTargets)
+  {
+    HR_CHECK(m_context->m_device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT,
+                                                         IID_PPV_ARGS(&target.m_commandAllocator)));
+  }
+  if(m_computeQueue)
+  {
+    m_computeCommandAllocators.resize(m_graphicsCommandAllocators.size(), nullptr);
+    for(ComPtr<ID3D12CommandAllocator>& allocator : m_computeCommandAllocators)
+    {
+      HR_CHECK(m_context->m_device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COMPUTE, IID_PPV_ARGS(&allocator)));
+    }
+  }
+  // Per-frame constants follow the command allocators, so they share their fence guard
+  m_uploadRing.init(m_context->m_device, static_cast<UINT>(m_graphicsCommandAllocators.size()), UPLOAD_RING_SLOT_BYTES);
 
   ID3D12Device4* device4 = nullptr;
-  HR_CHECK(m_context.m_device->QueryInterface(&device4));
+  HR_CHECK(m_context->m_device->QueryInterface(&device4));
   HR_CHECK(device4->CreateCommandList1(1, D3D12_COMMAND_LIST_TYPE_DIRECT, D3D12_COMMAND_LIST_FLAG_NONE,
                                        IID_PPV_ARGS(&m_graphicsCommandList)));
   HR_CHECK(device4->CreateCommandList1(1, D3D12_COMMAND_LIST_TYPE_DIRECT, D3D12_COMMAND_LIST_FLAG_NONE,
                                        IID_PPV_ARGS(&m_guiCommandList)));
+  if(m_computeQueue)
+  {
+    HR_CHECK(device4->CreateCommandList1(1, D3D12_COMMAND_LIST_TYPE_COMPUTE, D3D12_COMMAND_LIST_FLAG_NONE,
+                                         IID_PPV_ARGS(&m_computeCommandList)));
+  }
+  device4->Release();
+
+  // The frame fence guards every execution of a signal list before its frame slot is used again
+  HR_CHECK(m_context->m_device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT,
+                                                       IID_PPV_ARGS(&m_signalCommandAllocator)));
+  m_signalCommandLists.resize(m_graphicsCommandAllocators.size(), nullptr);
+  for(UINT i = 0; i < m_signalCommandLists.size(); ++i)
+  {
+    HR_CHECK(m_context->m_device->CreateCommandList(1, D3D12_COMMAND_LIST_TYPE_DIRECT, m_signalCommandAllocator.Get(),
+                                                    nullptr, IID_PPV_ARGS(&m_signalCommandLists[i])));
+    m_gpuTimer.recordSignal(m_signalCommandLists[i].Get(), i);
+    HR_CHECK(m_signalCommandLists[i]->Close());
+  }
+  const double swapChainMillis = endPhase();
 
-  // Create root signature for line rendering shaders
-  CD3DX12_DESCRIPTOR_RANGE guiDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0);
-  CD3DX12_ROOT_PARAMETER   rootParameters[2] = {};
-  rootParameters[0].InitAsConstants(11, 0, 0, D3D12_SHADER_VISIBILITY_VERTEX);
-  rootParameters[1].InitAsDescriptorTable(1, &guiDescriptorRange, D3D12_SHADER_VISIBILITY_PIXEL);
+  pipelineThread.join();
+  m_pipelineCache.store();
+  const double pipelineWaitMillis = endPhase();
 
-  CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc(ARRAYSIZE(rootParameters), rootParameters);
+  // The bandwidth load reads from a texture too large for the caches, its content doesn't matter
+  if(gpuLoad && m_gpuLoadMode == GpuLoadMode::BANDWIDTH)
+  {
+    CD3DX12_HEAP_PROPERTIES loadTexHeapProps(D3D12_HEAP_TYPE_DEFAULT);
+    CD3DX12_RESOURCE_DESC   loadTexDesc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, 4096, 4096, 1, 1);
+    HR_CHECK(m_context->m_device->CreateCommittedResource(&loadTexHeapProps, D3D12_HEAP_FLAG_NONE, &loadTexDesc,
+                                                         D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, nullptr,
+                                                         IID_PPV_ARGS(&m_loadTexture)));
+    m_loadTexture->SetName(L"load_texture");
+    D3D12_SHADER_RESOURCE_VIEW_DESC loadTexSrvDesc = {};
+    loadTexSrvDesc.Format                          = loadTexDesc.Format;
+    loadTexSrvDesc.ViewDimension                   = D3D12_SRV_DIMENSION_TEXTURE2D;
+    loadTexSrvDesc.Shader4ComponentMapping         = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    loadTexSrvDesc.Texture2D.MipLevels             = 1;
+    CD3DX12_CPU_DESCRIPTOR_HANDLE loadTexSrvHandle(m_cbvSrvUavHeap->GetCPUDescriptorHandleForHeapStart(), 2,
+                                                   m_context->m_device->GetDescriptorHandleIncrementSize(
+                                                       D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV));
+    m_context->m_device->CreateShaderResourceView(m_loadTexture.Get(), &loadTexSrvDesc, loadTexSrvHandle);
+  }
+  // The compute load writes a few results nobody reads, only so it isn't optimized away
+  if(m_loadComputePipeline)
+  {
+    CD3DX12_HEAP_PROPERTIES loadResultHeapProps(D3D12_HEAP_TYPE_DEFAULT);
+    CD3DX12_RESOURCE_DESC   loadResultDesc =
+        CD3DX12_RESOURCE_DESC::Buffer(LOAD_RESULT_COUNT * sizeof(float), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+    HR_CHECK(m_context->m_device->CreateCommittedResource(&loadResultHeapProps, D3D12_HEAP_FLAG_NONE, &loadResultDesc,
+                                                         D3D12_RESOURCE_STATE_UNORDERED_ACCESS, nullptr,
+                                                         IID_PPV_ARGS(&m_loadResultBuffer)));
+    m_loadResultBuffer->SetName(L"load_result_buffer");
+  }
 
-  ComPtr<ID3DBlob> rootSignatureBlob;
-  ComPtr<ID3DBlob> rootSignatureErrorBlob;
-  HRESULT rootSignatureHr = D3D12SerializeVersionedRootSignature(&rootSignatureDesc, &rootSignatureBlob, &rootSignatureErrorBlob);
-  if(rootSignatureErrorBlob)
+  // The pattern buffer is only written by the compute pass, which transitions it to and from unordered access
+  if(m_linePattern != LinePattern::LINES)
   {
-    std::string errorStr = std::string(static_cast<char const*>(rootSignatureErrorBlob->GetBufferPointer()),
-                                       static_cast<char const*>(rootSignatureErrorBlob->GetBufferPointer())
-                                           + rootSignatureErrorBlob->GetBufferSize())
-                           + "\n";
-    if(rootSignatureHr == S_OK)
+    CD3DX12_HEAP_PROPERTIES patternHeapProps(D3D12_HEAP_TYPE_DEFAULT);
+    CD3DX12_RESOURCE_DESC   patternDesc = CD3DX12_RESOURCE_DESC::Buffer(
+        static_cast<UINT64>(m_config.m_patternElements) * PATTERN_ELEMENT_SIZE,
+        D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+    m_patternBuffers.resize(m_computeQueue ? m_backBufferResources.size() : 1);
+    for(ComPtr<ID3D12Resource>& patternBuffer : m_patternBuffers)
     {
-      LOGW(errorStr.c_str());
+      HR_CHECK(m_context->m_device->CreateCommittedResource(&patternHeapProps, D3D12_HEAP_FLAG_NONE, &patternDesc,
+                                                           D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, nullptr,
+                                                           IID_PPV_ARGS(&patternBuffer)));
+      patternBuffer->SetName(L"pattern_buffer");
     }
-    else
+    LOGI("%s pattern with up to %u elements generated on the GPU.\n", linePatternName(m_linePattern),
+         m_config.m_patternElements);
+  }
+
+  BundlePipelines bundlePipelines   = {};
+  bundlePipelines.m_verticalLines   = m_verticalLinesPipeline.Get();
+  bundlePipelines.m_horizontalLines = m_horizontalLinesPipeline.Get();
+  bundlePipelines.m_pattern         = m_patternPipeline.Get();
+  bundlePipelines.m_indicator       = m_indicatorPipeline.Get();
+  bundlePipelines.m_gui             = m_guiPipeline.Get();
+  recordBundles(m_bundles, bundlePipelines);
+  if(m_viewInstancingSupported)
+  {
+    bundlePipelines.m_verticalLines   = m_viewInstancedVerticalLinesPipeline.Get();
+    bundlePipelines.m_horizontalLines = m_viewInstancedHorizontalLinesPipeline.Get();
+    bundlePipelines.m_pattern         = m_viewInstancedPatternPipeline.Get();
+    bundlePipelines.m_indicator       = m_viewInstancedIndicatorPipeline.Get();
+    bundlePipelines.m_gui             = m_viewInstancedGuiPipeline.Get();
+    recordBundles(m_viewInstancedBundles, bundlePipelines);
+  }
+
+  // Switch into fullscreen (which is required for present barrier to work)
+  if(m_config.m_startupDisplayMode == "b" || m_config.m_startupDisplayMode == "borderless")
+  {
+    if(trySetDisplayMode(DisplayMode::BORDERLESS) != DisplayMode::BORDERLESS)
+    {
+      LOGW("Failed to set borderless display mode.\n");
+    }
+  }
+  else if(m_config.m_startupDisplayMode == "f" || m_config.m_startupDisplayMode == "fullscreen")
+  {
+    if(trySetDisplayMode(DisplayMode::FULLSCREEN) != DisplayMode::FULLSCREEN)
     {
-      LOGE(errorStr.c_str());
+      LOGW("Failed to set borderless fullscreen mode.\n");
     }
   }
-  HR_CHECK(rootSignatureHr);
-  HR_CHECK(m_context.m_device->CreateRootSignature(1, rootSignatureBlob->GetBufferPointer(),
-                                                   rootSignatureBlob->GetBufferSize(), IID_PPV_ARGS(&m_rootSignature)));
+  else if(m_config.m_startupDisplayMode != "w" && m_config.m_startupDisplayMode != "windowed")
+  {
+    LOGE("Display mode argument must be (b)orderless, (f)ullscreen, or (w)indowed.");
+    return false;
+  }
+  forcePresentBarrierChange();
+  m_presentBarrierFrameStats.dwVersion = NV_PRESENT_BARRIER_FRAME_STATICS_VER1;
+  openVsyncProbe();
+  const double displayModeMillis = endPhase();
+
+  // ImGui is global, so only a single render thread may use it
+  if(!m_config.m_disableGui && !initGui())
+  {
+    return false;
+  }
+  const double guiMillis = endPhase();
+
+  LOGI("Startup %.1f ms: device %.1f ms, NvAPI %.1f ms, swap chain %.1f ms, pipelines %.1f ms (%u loaded, %u compiled, "
+       "waited %.1f ms), display mode %.1f ms, gui %.1f ms\n",
+       qpcToMillis(qpcNow() - initStart), deviceMillis, nvapiMillis, swapChainMillis, pipelineMillis,
+       m_pipelineCache.loadedCount(), m_pipelineCache.compiledCount(), pipelineWaitMillis, displayModeMillis,
+       guiMillis);
+  return true;
+}
+
+void RenderThread::createPipelines(bool gpuLoad)
+{
+  ID3D12Device4* device4 = nullptr;
+  HR_CHECK(m_context->m_device->QueryInterface(&device4));
+
+  // The root signature is serialized at build time into the gui vertex shader
+  const D3D12_SHADER_BYTECODE rootSignatureShader = shaderBytecode(Shader::GUI_VS);
+  HR_CHECK(m_context->m_device->CreateRootSignature(1, rootSignatureShader.pShaderBytecode,
+                                                   rootSignatureShader.BytecodeLength, IID_PPV_ARGS(&m_rootSignature)));
 
   // Create graphics pipeline for line rendering (using simple quads rendered from triangle strips)
   struct PipelineStateDesc
@@ -262,6 +1053,7 @@ bool RenderThread::init(unsigned int initialWidth, unsigned int initialHeight)
     CD3DX12_PIPELINE_STATE_STREAM_PRIMITIVE_TOPOLOGY    m_primitiveTopology;
     CD3DX12_PIPELINE_STATE_STREAM_RENDER_TARGET_FORMATS m_renderTargets;
     CD3DX12_PIPELINE_STATE_STREAM_NODE_MASK             m_nodeMask;
+    CD3DX12_PIPELINE_STATE_STREAM_VIEW_INSTANCING       m_viewInstancing;
   } pipelineStateDesc;
   D3D12_PIPELINE_STATE_STREAM_DESC pipelineStateStreamDesc = {sizeof(PipelineStateDesc), &pipelineStateDesc};
 
@@ -276,19 +1068,49 @@ bool RenderThread::init(unsigned int initialWidth, unsigned int initialHeight)
   renderTargets.RTFormats[0]          = BACK_BUFFER_FORMAT;
 
   pipelineStateDesc.m_rootSig           = m_rootSignature.Get();
-  pipelineStateDesc.m_vs                = CD3DX12_SHADER_BYTECODE(lineVsData.data(), lineVsData.size());
-  pipelineStateDesc.m_ps                = CD3DX12_SHADER_BYTECODE(psData.data(), psData.size());
+  pipelineStateDesc.m_vs                = shaderBytecode(Shader::LINE_VERTICAL_VS);
+  pipelineStateDesc.m_ps                = shaderBytecode(Shader::PS);
   pipelineStateDesc.m_rasterizer        = rasterizerDesc;
   pipelineStateDesc.m_blendDesc         = CD3DX12_BLEND_DESC((CD3DX12_DEFAULT()));
   pipelineStateDesc.m_depthStencil      = depthStencilDesc;
   pipelineStateDesc.m_primitiveTopology = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
   pipelineStateDesc.m_renderTargets     = renderTargets;
   pipelineStateDesc.m_nodeMask          = 1;
-  HR_CHECK(device4->CreatePipelineState(&pipelineStateStreamDesc, IID_PPV_ARGS(&m_linesPipeline)));
+  pipelineStateDesc.m_viewInstancing    = CD3DX12_VIEW_INSTANCING_DESC(CD3DX12_DEFAULT());
+  HR_CHECK(m_pipelineCache.createPipelineState(device4, L"vertical_lines", pipelineStateStreamDesc,
+                                               m_verticalLinesPipeline));
+
+  // The orientation of the lines is a shader permutation
+  pipelineStateDesc.m_vs = shaderBytecode(Shader::LINE_HORIZONTAL_VS);
+  HR_CHECK(m_pipelineCache.createPipelineState(device4, L"horizontal_lines", pipelineStateStreamDesc,
+                                               m_horizontalLinesPipeline));
+
+  // Compute pipelines run on the direct queue, or on the compute queue with -asynccompute
+  struct ComputePipelineStateDesc
+  {
+    CD3DX12_PIPELINE_STATE_STREAM_ROOT_SIGNATURE m_rootSig;
+    CD3DX12_PIPELINE_STATE_STREAM_CS             m_cs;
+    CD3DX12_PIPELINE_STATE_STREAM_NODE_MASK      m_nodeMask;
+  } computeStateDesc;
+  D3D12_PIPELINE_STATE_STREAM_DESC computeStateStreamDesc = {sizeof(ComputePipelineStateDesc), &computeStateDesc};
+  computeStateDesc.m_rootSig                              = m_rootSignature.Get();
+  computeStateDesc.m_nodeMask                             = 1;
+
+  // Create graphics pipeline for GPU generated patterns, every instance is one element of the pattern buffer
+  const bool pattern = m_linePattern != LinePattern::LINES;
+  if(pattern)
+  {
+    pipelineStateDesc.m_vs = shaderBytecode(Shader::PATTERN_VS);
+    HR_CHECK(m_pipelineCache.createPipelineState(device4, L"pattern", pipelineStateStreamDesc, m_patternPipeline));
+
+    computeStateDesc.m_cs = shaderBytecode(Shader::PATTERN_CS);
+    HR_CHECK(
+        m_pipelineCache.createPipelineState(device4, L"pattern_cs", computeStateStreamDesc, m_patternComputePipeline));
+  }
 
   // Create graphics pipeline for present barrier status indicator
-  pipelineStateDesc.m_vs = CD3DX12_SHADER_BYTECODE(indicatorVsData.data(), indicatorVsData.size());
-  HR_CHECK(device4->CreatePipelineState(&pipelineStateStreamDesc, IID_PPV_ARGS(&m_indicatorPipeline)));
+  pipelineStateDesc.m_vs = shaderBytecode(Shader::INDICATOR_VS);
+  HR_CHECK(m_pipelineCache.createPipelineState(device4, L"indicator", pipelineStateStreamDesc, m_indicatorPipeline));
 
   // create graphics pipeline for gui rendering
   CD3DX12_BLEND_DESC guiBlendDesc          = CD3DX12_BLEND_DESC(CD3DX12_DEFAULT());
@@ -296,37 +1118,88 @@ bool RenderThread::init(unsigned int initialWidth, unsigned int initialHeight)
   guiBlendDesc.RenderTarget[0].SrcBlend    = D3D12_BLEND_SRC_ALPHA;
   guiBlendDesc.RenderTarget[0].DestBlend   = D3D12_BLEND_INV_SRC_ALPHA;
 
-  pipelineStateDesc.m_vs        = CD3DX12_SHADER_BYTECODE(guiVsData.data(), guiVsData.size());
-  pipelineStateDesc.m_ps        = CD3DX12_SHADER_BYTECODE(guiPsData.data(), guiPsData.size());
+  pipelineStateDesc.m_vs        = shaderBytecode(Shader::GUI_VS);
+  pipelineStateDesc.m_ps        = shaderBytecode(Shader::GUI_PS);
   pipelineStateDesc.m_blendDesc = guiBlendDesc;
-  HR_CHECK(device4->CreatePipelineState(&pipelineStateStreamDesc, IID_PPV_ARGS(&m_guiPipeline)));
+  HR_CHECK(m_pipelineCache.createPipelineState(device4, L"gui", pipelineStateStreamDesc, m_guiPipeline));
 
-  device4->Release();
+  // Create graphics pipeline for the GPU load, a fullscreen triangle like the gui blended with zero opacity. The ALU
+  // load doesn't need the render target, so with -asynccompute it is a compute pipeline instead.
+  if(gpuLoad && m_config.m_asyncCompute && m_gpuLoadMode == GpuLoadMode::ALU)
+  {
+    computeStateDesc.m_cs = shaderBytecode(Shader::LOAD_CS);
+    HR_CHECK(m_pipelineCache.createPipelineState(device4, L"load_cs", computeStateStreamDesc, m_loadComputePipeline));
+  }
+  else if(gpuLoad)
+  {
+    pipelineStateDesc.m_ps = shaderBytecode(Shader::LOAD_PS);
+    HR_CHECK(m_pipelineCache.createPipelineState(device4, L"load", pipelineStateStreamDesc, m_loadPipeline));
+  }
 
-  // Switch into fullscreen (which is required for present barrier to work)
-  if(m_config.m_startupDisplayMode == "b" || m_config.m_startupDisplayMode == "borderless")
+  // Create graphics pipeline for the frame marker, the fullscreen triangle is cut down to the marker by the scissor
+  if(m_config.m_frameMarker)
   {
-    if(trySetDisplayMode(DisplayMode::BORDERLESS) != DisplayMode::BORDERLESS)
-    {
-      LOGW("Failed to set borderless display mode.\n");
-    }
+    pipelineStateDesc.m_ps        = shaderBytecode(Shader::MARKER_PS);
+    pipelineStateDesc.m_blendDesc = CD3DX12_BLEND_DESC((CD3DX12_DEFAULT()));
+    HR_CHECK(m_pipelineCache.createPipelineState(device4, L"marker", pipelineStateStreamDesc, m_markerPipeline));
   }
-  else if(m_config.m_startupDisplayMode == "f" || m_config.m_startupDisplayMode == "fullscreen")
+
+  // Create view instanced pipelines rendering both stereo eyes in one pass, otherwise every eye is a separate pass
+  D3D12_FEATURE_DATA_D3D12_OPTIONS3 options3    = {};
+  D3D12_FEATURE_DATA_SHADER_MODEL   shaderModel = {D3D_SHADER_MODEL_6_1};
+  const bool                        viewInstancing =
+      !m_config.m_disableViewInstancing
+      && SUCCEEDED(m_context->m_device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS3, &options3, sizeof(options3)))
+      && options3.ViewInstancingTier != D3D12_VIEW_INSTANCING_TIER_NOT_SUPPORTED
+      && SUCCEEDED(
+          m_context->m_device->CheckFeatureSupport(D3D12_FEATURE_SHADER_MODEL, &shaderModel, sizeof(shaderModel)))
+      && shaderModel.HighestShaderModel >= D3D_SHADER_MODEL_6_1;
+  if(viewInstancing)
   {
-    if(trySetDisplayMode(DisplayMode::FULLSCREEN) != DisplayMode::FULLSCREEN)
+    // Every view renders into its own array slice of the back buffer
+    const D3D12_VIEW_INSTANCE_LOCATION viewInstanceLocations[2] = {{0, 0}, {0, 1}};
+    pipelineStateDesc.m_viewInstancing =
+        CD3DX12_VIEW_INSTANCING_DESC(2, viewInstanceLocations, D3D12_VIEW_INSTANCING_FLAG_NONE);
+
+    pipelineStateDesc.m_vs        = shaderBytecode(Shader::LINE_VERTICAL_VS_VI);
+    pipelineStateDesc.m_ps        = shaderBytecode(Shader::PS_VI);
+    pipelineStateDesc.m_blendDesc = CD3DX12_BLEND_DESC((CD3DX12_DEFAULT()));
+    HR_CHECK(m_pipelineCache.createPipelineState(device4, L"vertical_lines_vi", pipelineStateStreamDesc,
+                                                 m_viewInstancedVerticalLinesPipeline));
+
+    pipelineStateDesc.m_vs = shaderBytecode(Shader::LINE_HORIZONTAL_VS_VI);
+    HR_CHECK(m_pipelineCache.createPipelineState(device4, L"horizontal_lines_vi", pipelineStateStreamDesc,
+                                                 m_viewInstancedHorizontalLinesPipeline));
+
+    if(pattern)
     {
-      LOGW("Failed to set borderless fullscreen mode.\n");
+      pipelineStateDesc.m_vs = shaderBytecode(Shader::PATTERN_VS_VI);
+      HR_CHECK(m_pipelineCache.createPipelineState(device4, L"pattern_vi", pipelineStateStreamDesc,
+                                                   m_viewInstancedPatternPipeline));
     }
+
+    pipelineStateDesc.m_vs = shaderBytecode(Shader::INDICATOR_VS_VI);
+    HR_CHECK(m_pipelineCache.createPipelineState(device4, L"indicator_vi", pipelineStateStreamDesc,
+                                                 m_viewInstancedIndicatorPipeline));
+
+    pipelineStateDesc.m_vs        = shaderBytecode(Shader::GUI_VS_VI);
+    pipelineStateDesc.m_ps        = shaderBytecode(Shader::GUI_PS_VI);
+    pipelineStateDesc.m_blendDesc = guiBlendDesc;
+    HR_CHECK(
+        m_pipelineCache.createPipelineState(device4, L"gui_vi", pipelineStateStreamDesc, m_viewInstancedGuiPipeline));
+
+    m_viewInstancingSupported = true;
   }
-  else if(m_config.m_startupDisplayMode != "w" && m_config.m_startupDisplayMode != "windowed")
+  else if(!m_config.m_disableViewInstancing)
   {
-    LOGE("Display mode argument must be (b)orderless, (f)ullscreen, or (w)indowed.");
-    return false;
+    LOGI("View instancing is not supported, stereo eyes are rendered in separate passes.\n");
   }
-  forcePresentBarrierChange();
-  m_presentBarrierFrameStats.dwVersion = NV_PRESENT_BARRIER_FRAME_STATICS_VER1;
 
+  device4->Release();
+}
 
+bool RenderThread::initGui()
+{
   IMGUI_CHECKVERSION();
   if(!ImGui::CreateContext())
   {
@@ -340,20 +1213,42 @@ bool RenderThread::init(unsigned int initialWidth, unsigned int initialHeight)
     return false;
   }
   auto guiCpuHandle = m_cbvSrvUavHeap->GetCPUDescriptorHandleForHeapStart();
-  guiCpuHandle.ptr += m_context.m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+  guiCpuHandle.ptr += m_context->m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
   auto guiGpuHandle = m_cbvSrvUavHeap->GetGPUDescriptorHandleForHeapStart();
-  guiGpuHandle.ptr += m_context.m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-  if(!ImGui_ImplDX12_Init(m_context.m_device, static_cast<int>(m_graphicsCommandAllocators.size()), BACK_BUFFER_FORMAT,
+  guiGpuHandle.ptr += m_context->m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+  if(!ImGui_ImplDX12_Init(m_context->m_device, static_cast<int>(m_graphicsCommandAllocators.size()), BACK_BUFFER_FORMAT,
                           m_cbvSrvUavHeap.Get(), guiCpuHandle, guiGpuHandle))
   {
     LOGE("ImGui_ImplDX12_Init() failed.\n");
     return false;
   }
+
+  // From here on ImGui is only used by the gui worker
+  m_guiWorker = std::thread([this]() { guiWorkerLoop(); });
   return true;
 }
 
 void RenderThread::renderFrame()
 {
+  m_frameRecord                   = {};
+  m_frameRecord.m_backBufferCount = m_config.m_backBufferCount;
+  m_frameRecord.m_maxFrameLatency = m_config.m_maxFrameLatency;
+  if(m_frameScheduler.pacing() != FramePacing::SLEEP)
+  {
+    m_frameRecord.m_latencyWaitBegin = qpcNow();
+    m_frameRecord.m_latencyWaitEnd   = m_frameScheduler.waitForFrame(m_config.m_syncTimeoutMillis);
+  }
+  if(m_frameScheduler.pacing() == FramePacing::JUST_IN_TIME)
+  {
+    // Present the margin before the first vblank the frame can still make
+    const std::int64_t margin = static_cast<std::int64_t>(m_config.m_justInTimeMarginMicros) * qpcFrequency() / 1000000;
+    const std::int64_t vblank = m_vsyncProbe.nextVblank(qpcNow() + m_frameScheduler.frameCost() + margin);
+    m_frameScheduler.waitForFrameStart(vblank != 0 ? vblank - margin : 0);
+  }
+  m_frameRecord.m_frameBegin = qpcNow();
+
+  fetchSettings();
+
   if(m_frameCount % m_config.m_testModeInterval < 2 && m_config.m_testMode[0] != 'n')
   {
     INPUT input      = {};
@@ -382,164 +1277,403 @@ void RenderThread::renderFrame()
   {
     m_frameCount++;
   }
+  else if(m_syncSampler.isRunning())
+  {
+    // The sample may be a poll interval old, the count is extrapolated to the frame start
+    SyncSample const& sample = m_syncSampler.latest();
+    if(sample.m_quadroSyncValid)
+    {
+      m_frameCount = m_syncSampler.frameCountAt(m_frameRecord.m_frameBegin);
+    }
+  }
   if(!m_config.m_scrolling)
   {
     ++m_linesPosOffset;
   }
 
-  m_mutex.lock();
-  std::uint32_t sleepIntervalMillis = m_config.m_sleepIntervalInMilliseconds;
-  m_mutex.unlock();
-  if(sleepIntervalMillis != 0)
+  if(m_config.m_sleepIntervalInMilliseconds != 0)
   {
-    Sleep(sleepIntervalMillis);
+    if(m_frameScheduler.pacing() == FramePacing::SLEEP)
+    {
+      const std::int64_t sleepBegin = qpcNow();
+      Sleep(m_config.m_sleepIntervalInMilliseconds);
+      m_frameScheduler.wakeLatency().add(qpcNow() - sleepBegin
+                                         - m_config.m_sleepIntervalInMilliseconds * qpcFrequency() / 1000);
+    }
+    else
+    {
+      m_frameScheduler.delay(m_config.m_sleepIntervalInMilliseconds * qpcFrequency() / 1000);
+    }
   }
 
   // wait for command allocator to finish its execution
-  auto waitForFrameIdx = m_allocatorFrameIndices[m_swapChain->GetCurrentBackBufferIndex()];
-  if(m_frameFence->GetCompletedValue() < waitForFrameIdx)
+  m_backBufferIndex              = m_swapChain->GetCurrentBackBufferIndex();
+  m_frameRecord.m_fenceWaitBegin = qpcNow();
+  auto       waitForFrameIdx     = m_allocatorFrameIndices[m_backBufferIndex];
+  const bool fenceWaited         = m_frameFence->GetCompletedValue() < waitForFrameIdx;
+  if(fenceWaited && !m_fenceWaiter.wait(m_frameFence.Get(), waitForFrameIdx, m_syncEvt, m_config.m_syncTimeoutMillis))
+  {
+    LOGE("Wait for frame %d to finish timed out.\n", waitForFrameIdx);
+    m_skipNextSwap = true;
+    return;
+  }
+  m_skipNextSwap               = false;
+  m_frameRecord.m_fenceWaitEnd = qpcNow();
+
+  // The GPU finished the previous frame that used this back buffer, so its timestamps can be read without stalling
+  if(GpuTimer::Timings const* gpuTimings = m_gpuTimer.read(m_backBufferIndex))
   {
-    //auto begin = std::chrono::high_resolution_clock::now();
-    if(!m_skipNextSwap)
+    m_gpuTimings = *gpuTimings;
+    if(m_loadComputePipeline)
     {
-      m_frameFence->SetEventOnCompletion(waitForFrameIdx, m_syncEvt);
+      m_gpuTimings.m_loadMillis = m_gpuTimings.m_computeLoadMillis;
     }
-    switch(WaitForSingleObject(m_syncEvt, m_config.m_syncTimeoutMillis))
+    m_frameRecord.m_gpuFrameIndex      = m_gpuTimings.m_frameIndex;
+    m_frameRecord.m_gpuBegin           = m_gpuTimings.m_begin;
+    m_frameRecord.m_gpuEnd             = m_gpuTimings.m_end;
+    m_frameRecord.m_gpuLinesMillis     = m_gpuTimings.m_linesMillis;
+    m_frameRecord.m_gpuIndicatorMillis = m_gpuTimings.m_indicatorMillis;
+    m_frameRecord.m_gpuCompositeMillis = m_gpuTimings.m_compositeMillis;
+    m_frameRecord.m_gpuLoadMillis      = m_gpuTimings.m_loadMillis;
+    m_frameRecord.m_flags |= FRAME_RECORD_GPU_TIMINGS;
+    if(m_computeQueue)
     {
-      case WAIT_OBJECT_0:
-        break;
-      case WAIT_TIMEOUT:
-        LOGE("Wait for frame %d to finish timed out.\n", waitForFrameIdx);
-        m_skipNextSwap = true;
-        return;
-      default:
-        HR_CHECK(HRESULT_FROM_WIN32(GetLastError()));
+      m_frameRecord.m_gpuComputeBegin         = m_gpuTimings.m_computeBegin;
+      m_frameRecord.m_gpuComputeEnd           = m_gpuTimings.m_computeEnd;
+      m_frameRecord.m_gpuComputePatternMillis = m_gpuTimings.m_computePatternMillis;
+      m_frameRecord.m_gpuComputeOverlapMillis = m_gpuTimings.m_computeOverlapMillis;
+      m_frameRecord.m_flags |= FRAME_RECORD_GPU_COMPUTE;
+    }
+    m_gpuLoadController.update(m_gpuTimings.m_loadMillis);
+    // The fence is only signaled after Present and the present barrier's synchronization, the wake-up latency of the
+    // fence wait is measured from the timestamp right before the signal. The CPU/GPU clock calibration may place the
+    // signal slightly after the wake-up.
+    if(fenceWaited && m_gpuTimings.m_signal != 0)
+    {
+      const std::int64_t wakeLatency = std::max<std::int64_t>(m_frameRecord.m_fenceWaitEnd - m_gpuTimings.m_signal, 0);
+      m_frameScheduler.wakeLatency().add(wakeLatency);
+      m_fenceWaiter.histogram().add(wakeLatency);
     }
-    //auto end = std::chrono::high_resolution_clock::now();
-    //LOGI("frame %d: waited for %.3f ms.\n", m_frameIdx, std::chrono::duration<float, std::milli>(end - begin).count());
   }
-  m_skipNextSwap = false;
+  m_gpuTimings.m_guiMillis     = m_guiGpuMillis;
+  m_frameRecord.m_gpuGuiMillis = m_gpuTimings.m_guiMillis;
+  if(m_markerPipeline && m_frameMarker.read(m_backBufferIndex, m_frameMarkerValue))
+  {
+    m_frameRecord.m_markerFrame  = m_frameMarkerValue.m_frame;
+    m_frameRecord.m_markerNodeId = m_frameMarkerValue.m_nodeId;
+    m_frameRecord.m_flags |= m_frameMarkerValue.m_valid ? FRAME_RECORD_MARKER : FRAME_RECORD_MARKER_MISMATCH;
+  }
+
+  // Pick up the gui recorded since the last frame, while the worker is still busy the previous gui is composited again
+  const bool submitGui = collectGui();
+  if(submitGui)
+  {
+    m_guiCompositeTarget = m_guiJobTarget;
+  }
 
   // Begin recording command list
-  ComPtr<ID3D12CommandAllocator> commandAllocator = m_graphicsCommandAllocators[m_swapChain->GetCurrentBackBufferIndex()];
+  m_frameRecord.m_recordBegin                 = qpcNow();
+  ID3D12GraphicsCommandList* commandList      = m_graphicsCommandList.Get();
+  ID3D12CommandAllocator*    commandAllocator = m_graphicsCommandAllocators[m_backBufferIndex].Get();
+  // The first frame recorded after a flash event flashes
+  m_flashFrame = m_latencyMarker.isOpen() && m_latencyMarker.due(m_frameRecord.m_recordBegin, m_flash);
+  if(m_flashFrame)
+  {
+    m_frameRecord.m_flashId        = m_flash.m_id;
+    m_frameRecord.m_flashEventTime = m_flash.m_eventTime;
+    m_frameRecord.m_flags |= FRAME_RECORD_FLASH;
+  }
   HR_CHECK(commandAllocator->Reset());
-  HR_CHECK(m_graphicsCommandList->Reset(commandAllocator.Get(), m_linesPipeline.Get()));
-  auto cbvSrvUavHeap = m_cbvSrvUavHeap.Get();
-  m_graphicsCommandList->SetDescriptorHeaps(1, &cbvSrvUavHeap);
+  HR_CHECK(commandList->Reset(commandAllocator, m_verticalLinesPipeline.Get()));
+  m_uploadRing.beginFrame(m_backBufferIndex);
+  // The compute queue starts on the frame while its direct queue part is still being recorded
+  if(m_computeQueue)
+  {
+    submitCompute();
+  }
+  ID3D12DescriptorHeap* cbvSrvUavHeap = m_cbvSrvUavHeap.Get();
+  commandList->SetDescriptorHeaps(1, &cbvSrvUavHeap);
+  commandList->SetGraphicsRootSignature(m_rootSignature.Get());
+  m_gpuTimer.timestamp(commandList, m_backBufferIndex, GpuTimer::MAIN_BEGIN);
+  if(!m_computeQueue)
+  {
+    generatePattern(commandList);
+  }
 
-  ComPtr<ID3D12Resource>       currentBackBuffer = m_backBufferResources[m_swapChain->GetCurrentBackBufferIndex()];
+  ID3D12Resource*              currentBackBuffer = m_backBufferResources[m_backBufferIndex].Get();
   const D3D12_RESOURCE_BARRIER presentToRenderTarget =
-      nvdx12::transitionBarrier(currentBackBuffer.Get(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
-  m_graphicsCommandList->ResourceBarrier(1, &presentToRenderTarget);
-
-  ComPtr<ID3D12CommandAllocator> guiCommandAllocator = m_guiCommandAllocators[m_swapChain->GetCurrentBackBufferIndex()];
-  HR_CHECK(guiCommandAllocator->Reset());
-  HR_CHECK(m_guiCommandList->Reset(guiCommandAllocator.Get(), nullptr));
-  prepareGui();
+      nvdx12::transitionBarrier(currentBackBuffer, D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
+  commandList->ResourceBarrier(1, &presentToRenderTarget);
 
-  const UINT rtvIndex     = m_swapChain->GetCurrentBackBufferIndex();
-  const UINT rtvIncrement = m_context.m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-
-  // Clear background to black
+  // Clear background to black, with view instancing both eyes are a single pass into an array render target view
   const float clearColor[4] = {0, 0, 0, 1};
+  const bool  singlePass    = viewInstanced();
+  const UINT  passes        = m_config.m_stereo && !singlePass ? 2u : 1u;
+  if(singlePass)
   {
-    CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(m_rtvHeap->GetCPUDescriptorHandleForHeapStart(), rtvIndex, rtvIncrement);
-    m_graphicsCommandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
+    commandList->ClearRenderTargetView(m_frameContext.m_arrayRtvHandles[m_backBufferIndex], clearColor, 0, nullptr);
   }
-  if(m_config.m_stereo)
+  else
   {
-    CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(m_rtvHeap->GetCPUDescriptorHandleForHeapStart(),
-                                            D3D12_SWAP_CHAIN_SIZE + rtvIndex, rtvIncrement);
-    m_graphicsCommandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
+    for(UINT eye = 0; eye < passes; ++eye)
+    {
+      commandList->ClearRenderTargetView(m_frameContext.rtvHandle(m_backBufferIndex, eye), clearColor, 0, nullptr);
+    }
   }
 
   // Draw scrolling lines and a simple present barrier status indicator bar to the window
-  DXGI_SWAP_CHAIN_DESC1 swapChainDesc;
-  m_swapChain->GetDesc1(&swapChainDesc);
-  CD3DX12_RECT     scissorRect(0, 0, static_cast<LONG>(swapChainDesc.Width), static_cast<LONG>(swapChainDesc.Height));
-  CD3DX12_VIEWPORT viewport(0.0f, 0.0f, static_cast<float>(scissorRect.right), static_cast<float>(scissorRect.bottom));
-  m_graphicsCommandList->RSSetScissorRects(1, &scissorRect);
-  m_graphicsCommandList->RSSetViewports(1, &viewport);
+  commandList->RSSetScissorRects(1, &m_frameContext.m_scissorRect);
+  commandList->RSSetViewports(1, &m_frameContext.m_viewport);
 
+  // Synthetic load before the actual content, so the content is still rendered on top. Stereo frames load both eyes,
+  // the load pipeline is not view instanced.
+  m_gpuTimer.timestamp(commandList, m_backBufferIndex, GpuTimer::LOAD_BEGIN);
   for(UINT eye = 0; eye < (m_config.m_stereo ? 2u : 1u); ++eye)
   {
-    CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(m_rtvHeap->GetCPUDescriptorHandleForHeapStart(),
-                                            rtvIndex + eye * D3D12_SWAP_CHAIN_SIZE, rtvIncrement);
-    m_graphicsCommandList->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr);
+    commandList->OMSetRenderTargets(1, &m_frameContext.rtvHandle(m_backBufferIndex, eye), FALSE, nullptr);
+    drawLoad(commandList);
+  }
+  m_gpuTimer.timestamp(commandList, m_backBufferIndex, GpuTimer::LOAD_END);
 
-    drawLines(m_graphicsCommandList, eye);
-    drawSyncIndicator(m_graphicsCommandList);
-    drawGui(m_graphicsCommandList);
+  for(UINT eye = 0; eye < passes; ++eye)
+  {
+    D3D12_CPU_DESCRIPTOR_HANDLE const& rtvHandle = singlePass ? m_frameContext.m_arrayRtvHandles[m_backBufferIndex] :
+                                                                m_frameContext.rtvHandle(m_backBufferIndex, eye);
+    commandList->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr);
+
+    auto eyeTimestamp = [&](GpuTimer::Timestamp timestamp) {
+      m_gpuTimer.timestamp(commandList, m_backBufferIndex, GpuTimer::eyeTimestamp(eye, timestamp));
+    };
+    eyeTimestamp(GpuTimer::EYE_BEGIN);
+    drawLines(commandList, eye);
+    eyeTimestamp(GpuTimer::EYE_LINES_END);
+    drawSyncIndicator(commandList);
+    eyeTimestamp(GpuTimer::EYE_INDICATOR_END);
+    drawGui(commandList);
+    eyeTimestamp(GpuTimer::EYE_GUI_END);
   }
 
+  // The marker row is copied out of the back buffer on its way to present
+  D3D12_RESOURCE_STATES renderTargetState = D3D12_RESOURCE_STATE_RENDER_TARGET;
+  if(drawFrameMarker(commandList))
+  {
+    const D3D12_RESOURCE_BARRIER renderTargetToCopySource = nvdx12::transitionBarrier(
+        currentBackBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_COPY_SOURCE);
+    commandList->ResourceBarrier(1, &renderTargetToCopySource);
+    m_frameMarker.copy(commandList, currentBackBuffer, m_backBufferIndex, static_cast<std::uint32_t>(m_frameCount),
+                       frameMarkerId());
+    renderTargetState = D3D12_RESOURCE_STATE_COPY_SOURCE;
+  }
   const D3D12_RESOURCE_BARRIER renderTargetToPresent =
-      nvdx12::transitionBarrier(currentBackBuffer.Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
-  m_graphicsCommandList->ResourceBarrier(1, &renderTargetToPresent);
+      nvdx12::transitionBarrier(currentBackBuffer, renderTargetState, D3D12_RESOURCE_STATE_PRESENT);
+  commandList->ResourceBarrier(1, &renderTargetToPresent);
+  m_gpuTimer.timestamp(commandList, m_backBufferIndex, GpuTimer::MAIN_END);
+  m_gpuTimer.resolve(commandList, m_backBufferIndex, passes, m_frameIdx + 1);
 
-  // Finish recording and execute command lists
-  HR_CHECK(m_guiCommandList->Close());
-  ID3D12CommandList* rawGuiCommandList = m_guiCommandList.Get();
-  m_context.m_commandQueue->Wait(m_frameFence.Get(), m_frameIdx);
-  m_context.m_commandQueue->ExecuteCommandLists(1, &rawGuiCommandList);
-  m_context.m_commandQueue->Signal(m_guiFence.Get(), m_frameIdx + 1);
-  HR_CHECK(m_graphicsCommandList->Close());
-  ID3D12CommandList* rawCommandList = m_graphicsCommandList.Get();
-  m_context.m_commandQueue->Wait(m_guiFence.Get(), m_frameIdx + 1);
-  m_context.m_commandQueue->ExecuteCommandLists(1, &rawCommandList);
+  // Finish recording and execute command lists, the gui is rendered before the frame on the same queue, or on the gui
+  // queue which the frame waits for before compositing it
+  HR_CHECK(commandList->Close());
+  m_frameRecord.m_recordEnd = qpcNow();
+
+  if(submitGui)
+  {
+    ID3D12CommandQueue* guiQueue          = m_guiQueue ? m_guiQueue.Get() : m_context->m_commandQueue;
+    ID3D12CommandList*  rawGuiCommandList = m_guiCommandList.Get();
+    guiQueue->ExecuteCommandLists(1, &rawGuiCommandList);
+    m_guiTargets[m_guiCompositeTarget].m_submitIndex = ++m_guiSubmitCount;
+    HR_CHECK(guiQueue->Signal(m_guiFence.Get(), m_guiSubmitCount));
+  }
+  if(m_guiQueue)
+  {
+    HR_CHECK(m_context->m_commandQueue->Wait(m_guiFence.Get(), m_guiTargets[m_guiCompositeTarget].m_submitIndex));
+  }
+  ID3D12CommandList* rawCommandList = commandList;
+  m_context->m_commandQueue->ExecuteCommandLists(1, &rawCommandList);
+
+  kickGui();
 }
 
 void RenderThread::swapBuffers()
 {
   if(!m_skipNextSwap)
   {
-    m_allocatorFrameIndices[m_swapChain->GetCurrentBackBufferIndex()] = ++m_frameIdx;
+    m_allocatorFrameIndices[m_backBufferIndex] = ++m_frameIdx;
+    m_frameRecord.m_frameIndex                 = m_frameIdx;
+    m_frameRecord.m_targetPresentTime          = m_frameScheduler.waitForPresentTime();
+    if(m_vsyncProbe.isOpen())
+    {
+      m_vsyncProbe.queryScanLine(m_frameRecord.m_vsync);
+    }
+    m_frameRecord.m_presentBegin = qpcNow();
     m_swapChain->Present(m_syncInterval, 0);
-    HR_CHECK(m_context.m_commandQueue->Signal(m_frameFence.Get(), m_frameIdx));
+    m_frameRecord.m_presentEnd = qpcNow();
+    m_frameScheduler.presented(m_frameRecord.m_presentBegin);
+    if(m_vsyncProbe.isOpen())
+    {
+      m_vsyncProbe.presented(m_swapChain.Get(), m_frameRecord.m_presentBegin, m_frameRecord.m_vsync);
+      m_frameRecord.m_flags |= FRAME_RECORD_VSYNC;
+    }
+    if(m_resizeBegin != 0)
+    {
+      m_resizeToPresentMillis = static_cast<float>(qpcToMillis(m_frameRecord.m_presentEnd - m_resizeBegin));
+      m_resizeBegin           = 0;
+    }
+    if(m_presentSkew)
+    {
+      m_presentSkew->presented(m_config.m_windowIndex, m_frameRecord.m_presentBegin);
+    }
+    m_gpuTimer.setPresentTime(m_backBufferIndex, m_frameRecord.m_presentBegin);
+    if(m_markerPipeline)
+    {
+      m_frameMarker.setPresentTime(m_backBufferIndex, systemTimeNow());
+    }
+    // The frame fence covers the frame's compute load too, the wait is queued after Present so it doesn't delay it
+    if(m_computeQueue)
+    {
+      HR_CHECK(m_context->m_commandQueue->Wait(m_computeFence.Get(), m_computeSubmitCount));
+    }
+    ID3D12CommandList* signalCommandList = m_signalCommandLists[m_backBufferIndex].Get();
+    m_context->m_commandQueue->ExecuteCommandLists(1, &signalCommandList);
+    m_gpuTimer.signaled(m_backBufferIndex);
+    HR_CHECK(m_context->m_commandQueue->Signal(m_frameFence.Get(), m_frameIdx));
 
-    if(!m_config.m_disablePresentBarrier && m_presentBarrierJoined)
+    if(m_syncSampler.isRunning())
+    {
+      // Only the latest sample of the sampler thread is read, no driver calls after Present
+      m_syncSampler.setQuadroSync(m_config.m_quadroSync);
+      if(m_requestResetFrameCount)
+      {
+        m_requestResetFrameCount = false;
+        m_syncSampler.requestResetFrameCount();
+      }
+      SyncSample const& sample        = m_syncSampler.latest();
+      m_frameRecord.m_statsQueryBegin = sample.m_time;
+      m_frameRecord.m_statsQueryEnd   = sample.m_time;
+      m_frameRecord.m_flags |= FRAME_RECORD_SAMPLED;
+      if(m_presentBarrierJoined && sample.m_presentBarrierStatsValid)
+      {
+        m_presentBarrierFrameStats          = sample.m_presentBarrierStats;
+        m_frameRecord.m_presentBarrierStats = m_presentBarrierFrameStats;
+        m_frameRecord.m_flags |= FRAME_RECORD_PRESENT_BARRIER_STATS;
+      }
+      if(m_config.m_quadroSync && sample.m_quadroSyncValid)
+      {
+        // The measured count of the poll, m_frameCount may be extrapolated
+        m_frameRecord.m_quadroSyncFrameCount = sample.m_quadroSyncFrameCount;
+        m_frameRecord.m_flags |= FRAME_RECORD_QUADRO_SYNC;
+      }
+    }
+    else if(!m_config.m_disablePresentBarrier && m_presentBarrierJoined)
     {
+      m_frameRecord.m_statsQueryBegin = qpcNow();
       CHECK_NV(NvAPI_QueryPresentBarrierFrameStatistics(m_presentBarrierClient, &m_presentBarrierFrameStats));
+      m_frameRecord.m_statsQueryEnd       = qpcNow();
+      m_frameRecord.m_presentBarrierStats = m_presentBarrierFrameStats;
+      m_frameRecord.m_flags |= FRAME_RECORD_PRESENT_BARRIER_STATS;
 
       if(m_config.m_quadroSync)
       {
         if(m_requestResetFrameCount)
         {
           m_requestResetFrameCount = false;
-          CHECK_NV(NvAPI_D3D1x_ResetFrameCount(m_context.m_device));
+          CHECK_NV(NvAPI_D3D1x_ResetFrameCount(m_context->m_device));
         }
-        CHECK_NV(NvAPI_D3D1x_QueryFrameCount(m_context.m_device, &m_frameCount));
-      }
-
-      if(m_frameCounterFile.is_open())
-      {
-        m_frameCounterFile << m_presentBarrierFrameStats.PresentCount << std::endl;
+        CHECK_NV(NvAPI_D3D1x_QueryFrameCount(m_context->m_device, &m_frameCount));
+        m_frameRecord.m_quadroSyncFrameCount = m_frameCount;
+        m_frameRecord.m_flags |= FRAME_RECORD_QUADRO_SYNC;
       }
     }
-    std::lock_guard guard(m_mutex);
-    if(m_requestToggleStereo)
+    if(m_flashFrame)
+    {
+      logFlash();
+    }
+    m_syncMetrics.update(m_frameIdx, m_presentBarrierJoined, m_presentBarrierFrameStats);
+    updateTransition();
+    if(m_presentSkew)
     {
-      DXGI_SWAP_CHAIN_DESC1 desc;
-      m_swapChain->GetDesc1(&desc);
-      swapResize(desc.Width, desc.Height, !m_config.m_stereo, false);
-      m_requestToggleStereo = false;
+      m_presentSkew->setSyncMode(m_config.m_windowIndex, m_presentBarrierJoined ? m_presentBarrierFrameStats.SyncMode :
+                                                                                  PRESENT_BARRIER_NOT_JOINED);
     }
   }
+  else
+  {
+    m_frameRecord.m_frameIndex = m_frameIdx;
+    m_frameRecord.m_flags |= FRAME_RECORD_WAIT_TIMEOUT;
+  }
 
+  if(m_frameRecorder.isOpen())
   {
-    std::lock_guard guard(m_mutex);
-    m_requestedDisplayMode = trySetDisplayMode(m_requestedDisplayMode);
-    if(m_presentBarrierChangeRequested)
+    m_frameRecorder.record(m_frameRecord);
+  }
+  if(m_soakMonitor.isOpen())
+  {
+    SoakSample soakSample;
+    soakSample.m_record             = m_frameRecord;
+    soakSample.m_syncLossEvents     = m_syncMetrics.syncLossEvents();
+    soakSample.m_presentsOutOfSync  = m_syncMetrics.presentsOutOfSync();
+    soakSample.m_missedRefreshes    = m_syncMetrics.totalMissedRefreshes();
+    soakSample.m_swapResizes        = m_swapResizes;
+    soakSample.m_displayModeChanges = m_displayModeChanges;
+    m_soakMonitor.record(soakSample);
+  }
+
+  if(m_telemetryPublisher.isOpen() && !m_skipNextSwap)
+  {
+    if(m_lastPresentBegin != 0)
     {
-      // sync may cause a present barrier leave on its own
-      bool before = m_presentBarrierJoined;
-      sync();
-      if(before == m_presentBarrierJoined)
-      {
-        forcePresentBarrierChange();
-      }
-      m_presentBarrierChangeRequested = false;
-      m_conVar.notify_all();
+      m_telemetryPacket.m_frameTimes.add(qpcToMillis(m_frameRecord.m_presentBegin - m_lastPresentBegin));
+    }
+    m_lastPresentBegin                        = m_frameRecord.m_presentBegin;
+    m_telemetryPacket.m_frameIndex            = m_frameIdx;
+    m_telemetryPacket.m_presentBarrierJoined  = m_presentBarrierJoined ? 1 : 0;
+    m_telemetryPacket.m_syncMode              = m_presentBarrierFrameStats.SyncMode;
+    m_telemetryPacket.m_presentCount          = m_presentBarrierFrameStats.PresentCount;
+    m_telemetryPacket.m_presentInSyncCount    = m_presentBarrierFrameStats.PresentInSyncCount;
+    m_telemetryPacket.m_flipInSyncCount       = m_presentBarrierFrameStats.FlipInSyncCount;
+    m_telemetryPacket.m_refreshCount          = m_presentBarrierFrameStats.RefreshCount;
+    m_telemetryPacket.m_wakeLatencyMeanMicros = m_frameScheduler.wakeLatency().meanMicros();
+    m_telemetryPacket.m_wakeLatencyMaxMicros  = m_frameScheduler.wakeLatency().maxMicros();
+    m_telemetryPacket.m_vblankMarginMinMicros = m_vsyncProbe.marginMinMillis() * 1000.0f;
+    if(m_frameMarkerValue.m_valid)
+    {
+      m_telemetryPacket.m_markerFrame      = m_frameMarkerValue.m_frame;
+      m_telemetryPacket.m_markerNodeId     = m_frameMarkerValue.m_nodeId;
+      m_telemetryPacket.m_markerSystemTime = m_frameMarkerValue.m_presentSystemTime;
     }
+    m_telemetryPublisher.update(m_telemetryPacket);
+  }
+
+  processCommands();
+}
+
+void RenderThread::openVsyncProbe()
+{
+  if(!m_config.m_vsyncProbe)
+  {
+    return;
+  }
+  ComPtr<IDXGIOutput> output;
+  if(FAILED(m_swapChain->GetContainingOutput(&output)) || !m_vsyncProbe.open(output.Get()))
+  {
+    LOGW("Could not find the output of the swap chain, vblanks are not probed.\n");
+  }
+}
+
+void RenderThread::logFlash()
+{
+  // Relative to the event, the raw QPC event time correlates the flash with external clocks
+  auto sinceEvent = [this](std::int64_t time) { return qpcToMillis(time - m_flash.m_eventTime); };
+  const bool vblank =
+      (m_frameRecord.m_flags & FRAME_RECORD_VSYNC) && (m_frameRecord.m_vsync.m_flags & VSYNC_SAMPLE_VBLANK);
+  LOGI("Flash %llu (%s) at QPC %lld: recorded %+.3f ms, presented %+.3f ms, next vblank %+.3f ms, present count %u, "
+       "frame %llu\n",
+       static_cast<unsigned long long>(m_flash.m_id), m_flash.m_network ? "network" : "local",
+       static_cast<long long>(m_flash.m_eventTime), sinceEvent(m_frameRecord.m_recordBegin),
+       sinceEvent(m_frameRecord.m_presentBegin), vblank ? sinceEvent(m_frameRecord.m_vsync.m_vblankTime) : 0.0,
+       m_presentBarrierFrameStats.PresentCount, static_cast<unsigned long long>(m_frameIdx));
+  if(m_flash.m_network)
+  {
+    LOGI("  trigger received %.3f ms before the flash time\n", -sinceEvent(m_flash.m_receiveTime));
   }
 }
 
@@ -549,17 +1683,11 @@ bool RenderThread::sync()
   {
     return true;
   }
-  HR_CHECK(m_frameFence->SetEventOnCompletion(m_frameIdx, m_syncEvt));
-  DWORD waitResult = WaitForSingleObject(m_syncEvt, m_config.m_syncTimeoutMillis);
-  if(waitResult == WAIT_OBJECT_0)
+  if(m_fenceWaiter.wait(m_frameFence.Get(), m_frameIdx, m_syncEvt, m_config.m_syncTimeoutMillis))
   {
     return true;
   }
-  else if(waitResult != WAIT_TIMEOUT)
-  {
-    HR_CHECK(HRESULT_FROM_WIN32(GetLastError()));
-  }
-  else if(m_presentBarrierJoined)
+  if(m_presentBarrierJoined)
   {
     LOGW("CPU/GPU synchronization timeout. Forcing present barrier leave.\n");
     forcePresentBarrierChange();
@@ -570,64 +1698,58 @@ bool RenderThread::sync()
 
 void RenderThread::setSleepInterval(std::uint32_t millis)
 {
-  std::lock_guard guard(m_mutex);
-  m_config.m_sleepIntervalInMilliseconds = millis;
+  m_pendingSettings.m_sleepIntervalInMilliseconds = millis;
+  publishSettings();
   LOGI("Sleep interval set to %u ms\n", millis);
 }
 
 void RenderThread::changeSleepInterval(std::int32_t deltaMillis)
 {
-  std::lock_guard guard(m_mutex);
-  std::int32_t    millis = m_config.m_sleepIntervalInMilliseconds + deltaMillis;
+  std::int32_t millis = m_pendingSettings.m_sleepIntervalInMilliseconds + deltaMillis;
   if(0 <= millis)
   {
-    m_config.m_sleepIntervalInMilliseconds = static_cast<std::uint32_t>(millis);
+    m_pendingSettings.m_sleepIntervalInMilliseconds = static_cast<std::uint32_t>(millis);
+    publishSettings();
   }
 }
 
 void RenderThread::requestBorderlessStateChange()
 {
-  std::lock_guard guard(m_mutex);
-  if(m_requestedDisplayMode != DisplayMode::FULLSCREEN)
-  {
-    if(m_requestedDisplayMode == DisplayMode::BORDERLESS)
-    {
-      m_requestedDisplayMode = DisplayMode::WINDOWED;
-    }
-    else
-    {
-      m_requestedDisplayMode = DisplayMode::BORDERLESS;
-    }
-  }
+  pushCommand(Command::TOGGLE_BORDERLESS);
 }
 
 void RenderThread::requestFullscreenStateChange()
 {
-  std::lock_guard guard(m_mutex);
-  if(m_requestedDisplayMode != DisplayMode::BORDERLESS)
-  {
-    if(m_requestedDisplayMode == DisplayMode::FULLSCREEN)
-    {
-      m_requestedDisplayMode = DisplayMode::WINDOWED;
-    }
-    else
-    {
-      m_requestedDisplayMode = DisplayMode::FULLSCREEN;
-    }
-  }
+  pushCommand(Command::TOGGLE_FULLSCREEN);
 }
 
 void RenderThread::requestResetFrameCount()
 {
-  std::lock_guard guard(m_mutex);
-  m_requestResetFrameCount = true;
+  pushCommand(Command::RESET_FRAME_COUNT);
+}
+
+void RenderThread::requestFlash()
+{
+  m_flashRequestTime = qpcNow();
+  pushCommand(Command::FLASH_MARKER);
 }
 
 bool RenderThread::requestPresentBarrierChange(std::uint32_t maxWaitMillis)
 {
+  if(!pushCommand(Command::TOGGLE_PRESENT_BARRIER))
+  {
+    return false;
+  }
+  const std::uint64_t ticket = ++m_presentBarrierChangesRequested;
+  if(maxWaitMillis == 0)
+  {
+    return true;
+  }
+
+  // Waiting for the transition is a real blocking operation requested by the caller
   std::unique_lock lock(m_mutex);
-  m_presentBarrierChangeRequested = true;
-  return maxWaitMillis == 0 || m_conVar.wait_for(lock, std::chrono::milliseconds(maxWaitMillis)) == std::cv_status::no_timeout;
+  return m_conVar.wait_for(lock, std::chrono::milliseconds(maxWaitMillis),
+                           [this, ticket]() { return m_presentBarrierChangesCompleted >= ticket; });
 }
 
 void RenderThread::forcePresentBarrierChange()
@@ -640,10 +1762,12 @@ void RenderThread::forcePresentBarrierChange()
       params.dwVersion                      = NV_JOIN_PRESENT_BARRIER_PARAMS_VER1;
       CHECK_NV(NvAPI_JoinPresentBarrier(m_presentBarrierClient, &params));
       m_presentBarrierJoined = true;
+      m_syncSampler.setPresentBarrierClient(m_presentBarrierClient);
       LOGD("Present barrier joined.\n");
     }
     else
     {
+      m_syncSampler.setPresentBarrierClient(nullptr);
       CHECK_NV(NvAPI_LeavePresentBarrier(m_presentBarrierClient));
       m_presentBarrierJoined = false;
       LOGD("Present barrier left.\n");
@@ -663,16 +1787,20 @@ void RenderThread::swapResize(int width, int height, bool stereo, bool force)
     }
   }
 
+  m_resizeBegin = qpcNow();
+  ++m_swapResizes;
+  discardGui();
   sync();
 
   // Release back buffer resources before resizing swap chain
   m_backBufferResources.clear();
 
   // Create swap chain
-  const UINT swapFlags = DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING;
+  const UINT swapFlags = DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING | m_frameScheduler.swapChainFlags();
 
   if(m_swapChain == nullptr || stereo != m_config.m_stereo)
   {
+    m_frameScheduler.setSwapChain(nullptr);
     m_swapChain.Reset();
 
     DXGI_SWAP_CHAIN_DESC1 swapChainDesc = {};
@@ -682,16 +1810,18 @@ void RenderThread::swapResize(int width, int height, bool stereo, bool force)
     swapChainDesc.Stereo                = stereo;
     swapChainDesc.SampleDesc            = {1, 0};
     swapChainDesc.BufferUsage           = DXGI_USAGE_RENDER_TARGET_OUTPUT;
-    swapChainDesc.BufferCount           = D3D12_SWAP_CHAIN_SIZE;
+    swapChainDesc.BufferCount           = m_config.m_backBufferCount;
     swapChainDesc.Scaling               = DXGI_SCALING_NONE;
     swapChainDesc.SwapEffect            = stereo ? DXGI_SWAP_EFFECT_FLIP_SEQUENTIAL : DXGI_SWAP_EFFECT_FLIP_DISCARD;
     swapChainDesc.AlphaMode             = DXGI_ALPHA_MODE_UNSPECIFIED;
     swapChainDesc.Flags                 = swapFlags;
 
     ComPtr<IDXGISwapChain1> swapChain1;
-    HR_CHECK(m_context.m_factory->CreateSwapChainForHwnd(m_context.m_commandQueue, m_windowCallback->getWindowHandle(),
-                                                         &swapChainDesc, nullptr, nullptr, &swapChain1));
+    HR_CHECK(m_context->m_factory->CreateSwapChainForHwnd(m_context->m_commandQueue,
+                                                         m_windowCallback->getWindowHandle(), &swapChainDesc, nullptr,
+                                                         nullptr, &swapChain1));
     HR_CHECK(swapChain1.As(&m_swapChain));
+    m_frameScheduler.setSwapChain(m_swapChain.Get());
 
     m_config.m_stereo = stereo;
 
@@ -699,18 +1829,18 @@ void RenderThread::swapResize(int width, int height, bool stereo, bool force)
     {
       releasePresentBarrier();
 
-      CHECK_NV(NvAPI_D3D12_CreatePresentBarrierClient(m_context.m_device, m_swapChain.Get(), &m_presentBarrierClient));
+      CHECK_NV(NvAPI_D3D12_CreatePresentBarrierClient(m_context->m_device, m_swapChain.Get(), &m_presentBarrierClient));
     }
   }
   else
   {
-    HR_CHECK(m_swapChain->ResizeBuffers(D3D12_SWAP_CHAIN_SIZE, width, height, DXGI_FORMAT_UNKNOWN, swapFlags));
+    HR_CHECK(m_swapChain->ResizeBuffers(m_config.m_backBufferCount, width, height, DXGI_FORMAT_UNKNOWN, swapFlags));
   }
 
-  m_backBufferResources.resize(D3D12_SWAP_CHAIN_SIZE);
+  m_backBufferResources.resize(m_config.m_backBufferCount);
 
   // get back buffers and create render target views
-  const UINT rtvIncrement = m_context.m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+  const UINT rtvIncrement = m_context->m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
   for(UINT i = 0; i < m_backBufferResources.size(); ++i)
   {
     HR_CHECK(m_swapChain->GetBuffer(i, IID_PPV_ARGS(&m_backBufferResources[i])));
@@ -737,42 +1867,87 @@ void RenderThread::swapResize(int width, int height, bool stereo, bool force)
       rtvDesc.Texture2DArray.PlaneSlice      = 0;
     }
 
-    CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(m_rtvHeap->GetCPUDescriptorHandleForHeapStart(), i, rtvIncrement);
-    m_context.m_device->CreateRenderTargetView(m_backBufferResources[i].Get(), &rtvDesc, rtvHandle);
+    CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(m_rtvHeap->GetCPUDescriptorHandleForHeapStart(), i, rtvIncrement);
+    m_context->m_device->CreateRenderTargetView(m_backBufferResources[i].Get(), &rtvDesc, rtvHandle);
+
+    if(m_config.m_stereo)
+    {
+      rtvDesc.Texture2DArray.FirstArraySlice = 1;
+      CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandleRight(rtvHandle, m_config.m_backBufferCount, rtvIncrement);
+      m_context->m_device->CreateRenderTargetView(m_backBufferResources[i].Get(), &rtvDesc, rtvHandleRight);
+
+      // Both eyes for single-pass stereo, placed after the gui render target views
+      rtvDesc.Texture2DArray.FirstArraySlice = 0;
+      rtvDesc.Texture2DArray.ArraySize       = 2;
+      CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandleArray(rtvHandle, m_config.m_backBufferCount * 2 + GUI_TARGETS,
+                                                   rtvIncrement);
+      m_context->m_device->CreateRenderTargetView(m_backBufferResources[i].Get(), &rtvDesc, rtvHandleArray);
+    }
+  }
+
+  // The gui textures are placed in a heap sized for the largest swap chain so far. Gui pixels are loaded by position,
+  // so larger textures work for any swap chain size and smaller sizes keep the textures and their views as they are.
+  // Their shader resource views are at the slots 0 and 3 around the ImGui font and the load texture. Without a gui
+  // they are not needed at all.
+  if(!m_config.m_disableGui
+     && (m_guiHeap == nullptr || static_cast<UINT>(width) > m_guiTextureSize[0]
+         || static_cast<UINT>(height) > m_guiTextureSize[1]))
+  {
+    m_guiTextureSize[0] = std::max(m_guiTextureSize[0], static_cast<UINT>(width));
+    m_guiTextureSize[1] = std::max(m_guiTextureSize[1], static_cast<UINT>(height));
+
+    CD3DX12_RESOURCE_DESC guiTexDesc(D3D12_RESOURCE_DIMENSION_TEXTURE2D, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT,
+                                     m_guiTextureSize[0], m_guiTextureSize[1], 1, 1, BACK_BUFFER_FORMAT, 1, 0,
+                                     D3D12_TEXTURE_LAYOUT_UNKNOWN, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET);
 
-    if(m_config.m_stereo)
+    const D3D12_RESOURCE_ALLOCATION_INFO allocation = m_context->m_device->GetResourceAllocationInfo(0, 1, &guiTexDesc);
+
+    // The textures are placed one after the other at aligned offsets
+    const UINT64      textureSize = (allocation.SizeInBytes + allocation.Alignment - 1) & ~(allocation.Alignment - 1);
+    CD3DX12_HEAP_DESC guiHeapDesc(textureSize * GUI_TARGETS, D3D12_HEAP_TYPE_DEFAULT, allocation.Alignment,
+                                  D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES);
+    for(GuiTarget& target : m_guiTargets)
     {
-      rtvDesc.Texture2DArray.FirstArraySlice = 1;
-      CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandleRight(rtvHandle, D3D12_SWAP_CHAIN_SIZE, rtvIncrement);
-      m_context.m_device->CreateRenderTargetView(m_backBufferResources[i].Get(), &rtvDesc, rtvHandleRight);
-    }
-  }
-
-  // set up gui texture
-  m_guiTexture.Reset();
-  CD3DX12_HEAP_PROPERTIES guiTexHeapProps(D3D12_HEAP_TYPE_DEFAULT);
-  CD3DX12_RESOURCE_DESC   guiTexDesc(D3D12_RESOURCE_DIMENSION_TEXTURE2D, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT,
-                                     width, height, 1, 1, BACK_BUFFER_FORMAT, 1, 0, D3D12_TEXTURE_LAYOUT_UNKNOWN,
-                                     D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET);
-  const FLOAT             black[] = {0.0f, 0.0f, 0.0f, 0.0f};
-  CD3DX12_CLEAR_VALUE     guiTexClearValue(guiTexDesc.Format, black);
-  HR_CHECK(m_context.m_device->CreateCommittedResource(&guiTexHeapProps, D3D12_HEAP_FLAG_NONE, &guiTexDesc, D3D12_RESOURCE_STATE_RENDER_TARGET,
-                                                       &guiTexClearValue, IID_PPV_ARGS(&m_guiTexture)));
-  m_guiTexture->SetName(L"gui_texture");
-  D3D12_SHADER_RESOURCE_VIEW_DESC guiTexSrvDesc = {};
-  guiTexSrvDesc.Format                          = guiTexDesc.Format;
-  guiTexSrvDesc.ViewDimension                   = D3D12_SRV_DIMENSION_TEXTURE2D;
-  guiTexSrvDesc.Shader4ComponentMapping         = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-  guiTexSrvDesc.Texture2D.MipLevels             = 1;
-  m_context.m_device->CreateShaderResourceView(m_guiTexture.Get(), &guiTexSrvDesc,
-                                               m_cbvSrvUavHeap->GetCPUDescriptorHandleForHeapStart());
-  D3D12_RENDER_TARGET_VIEW_DESC guiTexRtvDesc = {};
-  guiTexRtvDesc.Format                        = guiTexDesc.Format;
-  guiTexRtvDesc.ViewDimension                 = D3D12_RTV_DIMENSION_TEXTURE2D;
-  auto guiRtvCpuHandle                        = m_rtvHeap->GetCPUDescriptorHandleForHeapStart();
-  guiRtvCpuHandle.ptr +=
-      D3D12_SWAP_CHAIN_SIZE * 2 * m_context.m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-  m_context.m_device->CreateRenderTargetView(m_guiTexture.Get(), &guiTexRtvDesc, guiRtvCpuHandle);
+      target.m_texture.Reset();
+    }
+    m_guiHeap.Reset();
+    HR_CHECK(m_context->m_device->CreateHeap(&guiHeapDesc, IID_PPV_ARGS(&m_guiHeap)));
+    m_guiHeap->SetName(L"gui_heap");
+
+    const FLOAT         black[] = {0.0f, 0.0f, 0.0f, 0.0f};
+    CD3DX12_CLEAR_VALUE guiTexClearValue(guiTexDesc.Format, black);
+    D3D12_SHADER_RESOURCE_VIEW_DESC guiTexSrvDesc = {};
+    guiTexSrvDesc.Format                          = guiTexDesc.Format;
+    guiTexSrvDesc.ViewDimension                   = D3D12_SRV_DIMENSION_TEXTURE2D;
+    guiTexSrvDesc.Shader4ComponentMapping         = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    guiTexSrvDesc.Texture2D.MipLevels             = 1;
+    D3D12_RENDER_TARGET_VIEW_DESC guiTexRtvDesc   = {};
+    guiTexRtvDesc.Format                          = guiTexDesc.Format;
+    guiTexRtvDesc.ViewDimension                   = D3D12_RTV_DIMENSION_TEXTURE2D;
+    const UINT srvIncrement =
+        m_context->m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    for(UINT i = 0; i < GUI_TARGETS; ++i)
+    {
+      GuiTarget& target = m_guiTargets[i];
+      HR_CHECK(m_context->m_device->CreatePlacedResource(m_guiHeap.Get(), i * textureSize, &guiTexDesc,
+                                                         D3D12_RESOURCE_STATE_RENDER_TARGET, &guiTexClearValue,
+                                                         IID_PPV_ARGS(&target.m_texture)));
+      target.m_texture->SetName(L"gui_texture");
+      target.m_placed = true;
+      CD3DX12_CPU_DESCRIPTOR_HANDLE guiSrvCpuHandle(m_cbvSrvUavHeap->GetCPUDescriptorHandleForHeapStart(), i * 3,
+                                                    srvIncrement);
+      m_context->m_device->CreateShaderResourceView(target.m_texture.Get(), &guiTexSrvDesc, guiSrvCpuHandle);
+      CD3DX12_CPU_DESCRIPTOR_HANDLE guiRtvCpuHandle(m_rtvHeap->GetCPUDescriptorHandleForHeapStart(),
+                                                    m_config.m_backBufferCount * 2 + i, rtvIncrement);
+      m_context->m_device->CreateRenderTargetView(target.m_texture.Get(), &guiTexRtvDesc, guiRtvCpuHandle);
+    }
+  }
+  for(GuiTarget& target : m_guiTargets)
+  {
+    // The next recording clears the whole swap chain area
+    target.m_valid = false;
+    target.m_rect  = {};
+  }
 
   if(!m_config.m_disablePresentBarrier)
   {
@@ -786,60 +1961,76 @@ void RenderThread::swapResize(int width, int height, bool stereo, bool force)
     CHECK_NV(NvAPI_D3D12_RegisterPresentBarrierResources(m_presentBarrierClient, m_presentBarrierFence.Get(),
                                                          rawBackBuffers.data(), static_cast<NvU32>(rawBackBuffers.size())));
   }
+
+  updateFrameContext();
 }
 
 void RenderThread::toggleStereo()
 {
-  std::lock_guard guard(m_mutex);
-  m_requestToggleStereo = !m_requestToggleStereo;
+  pushCommand(Command::TOGGLE_STEREO);
 }
 
 void RenderThread::toggleQuadroSync()
 {
-  std::lock_guard guard(m_mutex);
-  m_config.m_quadroSync = !m_config.m_quadroSync;
+  m_pendingSettings.m_quadroSync = !m_pendingSettings.m_quadroSync;
+  publishSettings();
 }
 
 void RenderThread::setVsync(bool enabled)
 {
-  std::lock_guard guard(m_mutex);
-  m_syncInterval = enabled ? 1 : 0;
+  m_pendingSettings.m_syncInterval = enabled ? 1 : 0;
+  publishSettings();
 }
 
-void RenderThread::drawLines(ComPtr<ID3D12GraphicsCommandList> commandList, uint32_t offset)
+void RenderThread::updateFrameContext()
 {
-  if(!m_config.m_showVerticalLines && !m_config.m_showHorizontalLines)
-  {
-    return;
-  }
-
-  // Update line constants
-  struct LineConstants
-  {
-    float    verticalSizeA;
-    float    verticalSizeB;
-    float    horizontalSizeA;
-    float    horizontalSizeB;
-    float    verticalOffset;
-    float    horizontalOffset;
-    float    verticalSpacing;
-    float    horizontalSpacing;
-    uint32_t numLines;
-    uint32_t firstHorizontalInstance;
-    uint32_t extraOffset;
-  } constants;
-  static_assert((sizeof(LineConstants) % sizeof(uint32_t)) == 0, "Unexpected LineConstants size");
-
-  constants.numLines = m_config.m_numLines;
-  constants.firstHorizontalInstance =
-      m_config.m_showHorizontalLines ? (m_config.m_showVerticalLines ? m_config.m_numLines / 2 : 0) : m_config.m_numLines;
-  constants.extraOffset = offset;
-
   DXGI_SWAP_CHAIN_DESC1 swapChainDesc;
   m_swapChain->GetDesc1(&swapChainDesc);
   const UINT width  = swapChainDesc.Width;
   const UINT height = swapChainDesc.Height;
 
+  m_frameContext.m_width           = width;
+  m_frameContext.m_height          = height;
+  m_frameContext.m_backBufferCount = static_cast<UINT>(m_backBufferResources.size());
+  m_frameContext.m_scissorRect     = CD3DX12_RECT(0, 0, static_cast<LONG>(width), static_cast<LONG>(height));
+  m_frameContext.m_viewport        =
+      CD3DX12_VIEWPORT(0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height));
+
+  // Render target views of all back buffers, right eye views follow the left eye views
+  const UINT rtvIncrement = m_context->m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+  const UINT srvIncrement =
+      m_context->m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+  const UINT eyes         = m_config.m_stereo ? 2u : 1u;
+  m_frameContext.m_rtvHandles.resize(eyes * m_frameContext.m_backBufferCount);
+  const D3D12_CPU_DESCRIPTOR_HANDLE rtvHeapStart = m_rtvHeap->GetCPUDescriptorHandleForHeapStart();
+  const D3D12_GPU_DESCRIPTOR_HANDLE srvHeapStart = m_cbvSrvUavHeap->GetGPUDescriptorHandleForHeapStart();
+  for(UINT i = 0; i < m_frameContext.m_rtvHandles.size(); ++i)
+  {
+    m_frameContext.m_rtvHandles[i] = CD3DX12_CPU_DESCRIPTOR_HANDLE(rtvHeapStart, i, rtvIncrement);
+  }
+  m_frameContext.m_arrayRtvHandles.resize(m_config.m_stereo ? m_frameContext.m_backBufferCount : 0);
+  for(UINT i = 0; i < m_frameContext.m_arrayRtvHandles.size(); ++i)
+  {
+    m_frameContext.m_arrayRtvHandles[i] =
+        CD3DX12_CPU_DESCRIPTOR_HANDLE(rtvHeapStart, m_config.m_backBufferCount * 2 + GUI_TARGETS + i, rtvIncrement);
+  }
+  for(UINT i = 0; i < GUI_TARGETS; ++i)
+  {
+    m_frameContext.m_guiRtvHandles[i] =
+        CD3DX12_CPU_DESCRIPTOR_HANDLE(rtvHeapStart, m_config.m_backBufferCount * 2 + i, rtvIncrement);
+    m_frameContext.m_guiSrvHandles[i] = CD3DX12_GPU_DESCRIPTOR_HANDLE(srvHeapStart, i * 3, srvIncrement);
+  }
+  m_frameContext.m_loadSrvHandle = CD3DX12_GPU_DESCRIPTOR_HANDLE(srvHeapStart, 2, srvIncrement);
+
+  // Line constants, only the offsets depend on the frame. Vertical and horizontal lines are separate draws.
+  m_frameContext.m_verticalLineCount = m_config.m_showHorizontalLines ?
+                                           (m_config.m_showVerticalLines ? m_config.m_numLines / 2 : 0) :
+                                           m_config.m_numLines;
+  m_frameContext.m_horizontalLineCount = m_config.m_numLines - m_frameContext.m_verticalLineCount;
+  LineConstants& constants             = m_frameContext.m_lineConstants;
+  constants.eye                        = 0;
+  constants.horizontalInstanceBase     = m_frameContext.m_verticalLineCount;
+
   // Convert pixel size into interpolation values
   constants.verticalSizeA   = m_config.m_lineSizeInPixels[0] / static_cast<float>(width);
   constants.horizontalSizeA = m_config.m_lineSizeInPixels[0] / static_cast<float>(height);
@@ -854,32 +2045,224 @@ void RenderThread::drawLines(ComPtr<ID3D12GraphicsCommandList> commandList, uint
     constants.horizontalSizeB = constants.horizontalSizeA;
   }
 
+  // Calculate spacing between lines so that they appear as a grid of squares
+  constants.verticalSpacing =
+      (static_cast<float>(height) / m_frameContext.m_verticalLineCount) / static_cast<float>(width);
+  constants.horizontalSpacing =
+      (static_cast<float>(height) / m_frameContext.m_horizontalLineCount) / static_cast<float>(height);
+
+  // Pattern constants, only the frame changes
+  PatternConstants& patternConstants = m_frameContext.m_patternConstants;
+  patternConstants.pattern           = static_cast<uint32_t>(m_linePattern);
+  patternConstants.elementCount      = m_config.m_patternElements;
+  patternConstants.frame             = 0;
+  patternConstants.speed             = m_config.m_lineSpeedInPixels;
+  patternConstants.width             = static_cast<float>(width);
+  patternConstants.height            = static_cast<float>(height);
+  patternConstants.lineSize          = static_cast<float>(m_config.m_lineSizeInPixels[0]);
+  patternConstants.cellSize          = static_cast<float>(std::max(m_config.m_lineSizeInPixels[1], 1u));
+  patternConstants.display           = m_config.m_windowIndex;
+  patternConstants.eye               = 0;
+}
+
+void RenderThread::recordBundles(DrawBundles& bundles, BundlePipelines const& pipelines)
+{
+  // Bundles inherit the root arguments of the calling command list as long as they set the same root signature
+  if(!m_bundleAllocator)
+  {
+    HR_CHECK(
+        m_context->m_device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_BUNDLE, IID_PPV_ARGS(&m_bundleAllocator)));
+  }
+  auto beginBundle = [this](ComPtr<ID3D12GraphicsCommandList>& bundle, ID3D12PipelineState* pipeline) {
+    HR_CHECK(m_context->m_device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_BUNDLE, m_bundleAllocator.Get(),
+                                                   pipeline, IID_PPV_ARGS(&bundle)));
+    bundle->SetGraphicsRootSignature(m_rootSignature.Get());
+    bundle->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+  };
+
+  // Render the lines via instancing (every instance is one line, where each line consists of a quad made of two
+  // triangles), every orientation with its own shader permutation
+  beginBundle(bundles.m_lines, pipelines.m_verticalLines);
+  if(m_frameContext.m_verticalLineCount != 0)
+  {
+    bundles.m_lines->DrawInstanced(4, m_frameContext.m_verticalLineCount, 0, 0);
+  }
+  if(m_frameContext.m_horizontalLineCount != 0)
+  {
+    bundles.m_lines->SetPipelineState(pipelines.m_horizontalLines);
+    bundles.m_lines->DrawInstanced(4, m_frameContext.m_horizontalLineCount, 0, 0);
+  }
+  HR_CHECK(bundles.m_lines->Close());
+
+  // Unused elements of the pattern buffer have zero size
+  if(pipelines.m_pattern)
+  {
+    beginBundle(bundles.m_pattern, pipelines.m_pattern);
+    bundles.m_pattern->DrawInstanced(4, m_config.m_patternElements, 0, 0);
+    HR_CHECK(bundles.m_pattern->Close());
+  }
+
+  beginBundle(bundles.m_indicator, pipelines.m_indicator);
+  bundles.m_indicator->DrawInstanced(8, 1, 0, 0);
+  HR_CHECK(bundles.m_indicator->Close());
+
+  // The gui texture alternates, so its descriptor table is inherited from the calling command list as well
+  beginBundle(bundles.m_gui, pipelines.m_gui);
+  bundles.m_gui->DrawInstanced(3, 1, 0, 0);
+  HR_CHECK(bundles.m_gui->Close());
+}
+
+LoadConstants RenderThread::loadConstants()
+{
+  LoadConstants constants;
+  constants.mode    = static_cast<uint32_t>(m_gpuLoadMode);
+  constants.work    = m_gpuLoadController.work();
+  constants.seed    = static_cast<uint32_t>(m_frameIdx);
+  constants.opacity = 0.0f;
+
+  m_frameRecord.m_gpuLoadWork = constants.work;
+  return constants;
+}
+
+void RenderThread::drawLoad(ID3D12GraphicsCommandList* commandList)
+{
+  if(!m_loadPipeline)
+  {
+    return;
+  }
+
+  const LoadConstants constants = loadConstants();
+  commandList->SetPipelineState(m_loadPipeline.Get());
+  commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+  commandList->SetGraphicsRootConstantBufferView(ROOT_CONSTANTS, m_uploadRing.push(constants));
+  commandList->SetGraphicsRootDescriptorTable(ROOT_TEXTURES, m_frameContext.m_loadSrvHandle);
+
+  // Fill rate load is generated by overdraw, every instance is another fullscreen layer
+  commandList->DrawInstanced(3, m_gpuLoadMode == GpuLoadMode::FILL ? constants.work : 1, 0, 0);
+}
+
+void RenderThread::dispatchLoad(ID3D12GraphicsCommandList* commandList)
+{
+  if(!m_loadComputePipeline)
+  {
+    return;
+  }
+
+  const LoadConstants constants = loadConstants();
+  commandList->SetPipelineState(m_loadComputePipeline.Get());
+  commandList->SetComputeRootSignature(m_rootSignature.Get());
+  commandList->SetComputeRootConstantBufferView(ROOT_CONSTANTS, m_uploadRing.push(constants));
+  commandList->SetComputeRootUnorderedAccessView(ROOT_PATTERN_UAV, m_loadResultBuffer->GetGPUVirtualAddress());
+
+  // One thread per pixel and eye, the same work as the pixel shader load
+  commandList->Dispatch((m_frameContext.m_width + LOAD_GROUP_SIZE - 1) / LOAD_GROUP_SIZE,
+                        (m_frameContext.m_height + LOAD_GROUP_SIZE - 1) / LOAD_GROUP_SIZE, m_config.m_stereo ? 2u : 1u);
+}
+
+void RenderThread::generatePattern(ID3D12GraphicsCommandList* commandList)
+{
+  if(!m_patternComputePipeline)
+  {
+    return;
+  }
+
+  PatternConstants constants = m_frameContext.m_patternConstants;
+  constants.frame            = static_cast<uint32_t>(m_frameCount - m_linesPosOffset);
+
+  // The draws of the previous frame are done with the buffer, they are on the same queue. On the compute queue, the
+  // buffer of this frame slot was last read by a frame the CPU already waited for.
+  ID3D12Resource*              buffer            = patternBuffer();
+  const D3D12_RESOURCE_BARRIER toUnorderedAccess = nvdx12::transitionBarrier(
+      buffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+  commandList->ResourceBarrier(1, &toUnorderedAccess);
+  commandList->SetPipelineState(m_patternComputePipeline.Get());
+  commandList->SetComputeRootSignature(m_rootSignature.Get());
+  commandList->SetComputeRootConstantBufferView(ROOT_CONSTANTS, m_uploadRing.push(constants));
+  commandList->SetComputeRootUnorderedAccessView(ROOT_PATTERN_UAV, buffer->GetGPUVirtualAddress());
+  commandList->Dispatch((constants.elementCount + PATTERN_GROUP_SIZE - 1) / PATTERN_GROUP_SIZE, 1, 1);
+  const D3D12_RESOURCE_BARRIER toShaderResource = nvdx12::transitionBarrier(
+      buffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+  commandList->ResourceBarrier(1, &toShaderResource);
+}
+
+void RenderThread::submitCompute()
+{
+  ID3D12GraphicsCommandList* commandList      = m_computeCommandList.Get();
+  ID3D12CommandAllocator*    commandAllocator = m_computeCommandAllocators[m_backBufferIndex].Get();
+  ID3D12CommandList*         rawCommandList   = commandList;
+  HR_CHECK(commandAllocator->Reset());
+
+  // The pattern is a submission of its own, so the direct queue only waits for the pattern and not for the load
+  HR_CHECK(commandList->Reset(commandAllocator, nullptr));
+  m_gpuTimer.computeTimestamp(commandList, m_backBufferIndex, GpuTimer::COMPUTE_BEGIN);
+  generatePattern(commandList);
+  m_gpuTimer.computeTimestamp(commandList, m_backBufferIndex, GpuTimer::COMPUTE_PATTERN_END);
+  HR_CHECK(commandList->Close());
+  m_computeQueue->ExecuteCommandLists(1, &rawCommandList);
+  HR_CHECK(m_computeQueue->Signal(m_computeFence.Get(), ++m_computeSubmitCount));
+  HR_CHECK(m_context->m_commandQueue->Wait(m_computeFence.Get(), m_computeSubmitCount));
+
+  // The load runs alongside the frame on the direct queue
+  HR_CHECK(commandList->Reset(commandAllocator, nullptr));
+  m_gpuTimer.computeTimestamp(commandList, m_backBufferIndex, GpuTimer::COMPUTE_LOAD_BEGIN);
+  dispatchLoad(commandList);
+  m_gpuTimer.computeTimestamp(commandList, m_backBufferIndex, GpuTimer::COMPUTE_LOAD_END);
+  m_gpuTimer.resolveCompute(commandList, m_backBufferIndex);
+  HR_CHECK(commandList->Close());
+  m_computeQueue->ExecuteCommandLists(1, &rawCommandList);
+  HR_CHECK(m_computeQueue->Signal(m_computeFence.Get(), ++m_computeSubmitCount));
+}
+
+void RenderThread::drawLines(ID3D12GraphicsCommandList* commandList, uint32_t eye)
+{
+  if(!m_config.m_showVerticalLines && !m_config.m_showHorizontalLines)
+  {
+    return;
+  }
+
+  if(m_patternPipeline)
+  {
+    PatternConstants constants = m_frameContext.m_patternConstants;
+    constants.frame            = static_cast<uint32_t>(m_frameCount - m_linesPosOffset);
+    constants.eye              = eye;
+    commandList->SetGraphicsRootConstantBufferView(ROOT_CONSTANTS, m_uploadRing.push(constants));
+    commandList->SetGraphicsRootShaderResourceView(ROOT_PATTERN_SRV, patternBuffer()->GetGPUVirtualAddress());
+    commandList->ExecuteBundle(drawBundles().m_pattern.Get());
+    return;
+  }
+
   // Update line offset based on the current frame count and speed
+  LineConstants constants = m_frameContext.m_lineConstants;
+  const UINT    width     = m_frameContext.m_width;
+  const UINT    height    = m_frameContext.m_height;
+  constants.eye           = eye;
   constants.verticalOffset =
       (((m_frameCount - m_linesPosOffset) * m_config.m_lineSpeedInPixels) % width) / static_cast<float>(width);
-  constants.verticalOffset += offset * constants.verticalSizeB;
+  constants.verticalOffset += eye * constants.verticalSizeB;
   constants.horizontalOffset =
       (((m_frameCount - m_linesPosOffset) * m_config.m_lineSpeedInPixels) % height) / static_cast<float>(height);
-  constants.horizontalOffset += offset * constants.horizontalSizeB;
-
-  // Calculate spacing between lines so that they appear as a grid of squares
-  constants.verticalSpacing = (static_cast<float>(height) / constants.firstHorizontalInstance) / static_cast<float>(width);
-  constants.horizontalSpacing =
-      (static_cast<float>(height) / (m_config.m_numLines - constants.firstHorizontalInstance)) / static_cast<float>(height);
+  constants.horizontalOffset += eye * constants.horizontalSizeB;
 
-  commandList->SetPipelineState(m_linesPipeline.Get());
-  commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
-  commandList->SetGraphicsRootSignature(m_rootSignature.Get());
-  commandList->SetGraphicsRoot32BitConstants(0, sizeof(LineConstants) / sizeof(uint32_t), &constants, 0);
-
-  // Render the lines via instancing (every instance is one line, where each line consists of a quad made of two triangles)
-  commandList->DrawInstanced(4, m_config.m_numLines, 0, 0);
+  commandList->SetGraphicsRootConstantBufferView(ROOT_CONSTANTS, m_uploadRing.push(constants));
+  commandList->ExecuteBundle(drawBundles().m_lines.Get());
 }
 
-void RenderThread::drawSyncIndicator(ComPtr<ID3D12GraphicsCommandList> commandList)
+void RenderThread::drawSyncIndicator(ID3D12GraphicsCommandList* commandList)
 {
+  if(m_minimalContent == MinimalContent::CLEARED && !m_flashFrame)
+  {
+    return;
+  }
+
   float color[3] = {0.25f, 0.25f, 0.25f};  // gray
-  if(m_presentBarrierJoined)
+  if(m_flashFrame)
+  {
+    // High contrast against every sync mode color and the black background
+    color[0] = 1.0f;
+    color[1] = 1.0f;
+    color[2] = 1.0f;
+  }
+  else if(m_presentBarrierJoined)
   {
     switch(m_presentBarrierFrameStats.SyncMode)
     {
@@ -905,13 +2288,44 @@ void RenderThread::drawSyncIndicator(ComPtr<ID3D12GraphicsCommandList> commandLi
     }
   }
 
-  commandList->SetPipelineState(m_indicatorPipeline.Get());
-  commandList->SetGraphicsRoot32BitConstants(0, 3, color, 0);
-  commandList->DrawInstanced(8, 1, 0, 0);
+  IndicatorConstants constants = {{color[0], color[1], color[2]}};
+  commandList->SetGraphicsRootConstantBufferView(ROOT_CONSTANTS, m_uploadRing.push(constants));
+  commandList->ExecuteBundle(drawBundles().m_indicator.Get());
+}
+
+bool RenderThread::drawFrameMarker(ID3D12GraphicsCommandList* commandList)
+{
+  const LONG width  = static_cast<LONG>(FRAME_MARKER_WIDTH);
+  const LONG height = static_cast<LONG>(FRAME_MARKER_CELL_SIZE);
+  if(!m_markerPipeline || m_frameContext.m_scissorRect.right < width || m_frameContext.m_scissorRect.bottom < height)
+  {
+    return false;
+  }
+
+  // Only into the first eye, the readback copies from its array slice
+  const D3D12_RECT      markerRect = {0, 0, width, height};
+  const MarkerConstants constants  = FrameMarker::encode(static_cast<std::uint32_t>(m_frameCount), frameMarkerId());
+  commandList->OMSetRenderTargets(1, &m_frameContext.rtvHandle(m_backBufferIndex, 0), FALSE, nullptr);
+  commandList->RSSetScissorRects(1, &markerRect);
+  commandList->SetPipelineState(m_markerPipeline.Get());
+  commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+  commandList->SetGraphicsRootConstantBufferView(ROOT_CONSTANTS, m_uploadRing.push(constants));
+  commandList->DrawInstanced(3, 1, 0, 0);
+  commandList->RSSetScissorRects(1, &m_frameContext.m_scissorRect);
+  return true;
 }
 
-void RenderThread::prepareGui()
+bool RenderThread::recordGui(GuiSnapshot const& snapshot, UINT target)
 {
+  // Limit the update rate of the statistics, the composited gui target keeps the last rendered gui in the meantime
+  const std::int64_t now = qpcNow();
+  if(m_guiTargets[m_guiCompositeTarget].m_valid && m_config.m_guiUpdateIntervalMillis != 0
+     && now - m_guiLastUpdate < static_cast<std::int64_t>(m_config.m_guiUpdateIntervalMillis) * qpcFrequency() / 1000)
+  {
+    return false;
+  }
+  m_guiLastUpdate = now;
+
   ImGui_ImplDX12_NewFrame();
   ImGui_ImplGlfw_NewFrame();
   ImGui::NewFrame();
@@ -919,14 +2333,14 @@ void RenderThread::prepareGui()
   ImGui::Begin("Present barrier stats");
   ImGui::SetWindowSize({240, 120});
   ImGui::SetWindowPos({0, 0});
-  if(m_presentBarrierJoined)
+  if(snapshot.m_presentBarrierJoined)
   {
     if(ImGui::BeginTable("table", 2, ImGuiTableFlags_SizingStretchProp))
     {
       ImGui::TableNextColumn();
       ImGui::Text("SyncMode");
       ImGui::TableNextColumn();
-      switch(m_presentBarrierFrameStats.SyncMode)
+      switch(snapshot.m_presentBarrierStats.SyncMode)
       {
         case PRESENT_BARRIER_NOT_JOINED:
           ImGui::Text("NOT_JOINED");
@@ -941,25 +2355,25 @@ void RenderThread::prepareGui()
           ImGui::Text("SYNC_CLUSTER");
           break;
         default:
-          ImGui::Text("0x%08x", m_presentBarrierFrameStats.SyncMode);
+          ImGui::Text("0x%08x", snapshot.m_presentBarrierStats.SyncMode);
           break;
       }
       ImGui::TableNextColumn();
       ImGui::Text("PresentCount");
       ImGui::TableNextColumn();
-      ImGui::Text("%d", m_presentBarrierFrameStats.PresentCount);
+      ImGui::Text("%d", snapshot.m_presentBarrierStats.PresentCount);
       ImGui::TableNextColumn();
       ImGui::Text("PresentInSyncCount");
       ImGui::TableNextColumn();
-      ImGui::Text("%d", m_presentBarrierFrameStats.PresentInSyncCount);
+      ImGui::Text("%d", snapshot.m_presentBarrierStats.PresentInSyncCount);
       ImGui::TableNextColumn();
       ImGui::Text("FlipInSyncCount");
       ImGui::TableNextColumn();
-      ImGui::Text("%d", m_presentBarrierFrameStats.FlipInSyncCount);
+      ImGui::Text("%d", snapshot.m_presentBarrierStats.FlipInSyncCount);
       ImGui::TableNextColumn();
       ImGui::Text("RefreshCount");
       ImGui::TableNextColumn();
-      ImGui::Text("%d", m_presentBarrierFrameStats.RefreshCount);
+      ImGui::Text("%d", snapshot.m_presentBarrierStats.RefreshCount);
       ImGui::EndTable();
     }
   }
@@ -970,30 +2384,388 @@ void RenderThread::prepareGui()
   }
   ImGui::End();
 
+  ImGui::Begin("GPU timings");
+  ImGui::SetWindowPos({560, 0}, ImGuiCond_FirstUseEver);
+  ImGui::SetWindowSize({240, 240}, ImGuiCond_FirstUseEver);
+  ImGui::Text("Frame       %.3f ms", snapshot.m_gpuTimings.m_frameMillis);
+  ImGui::Text("GUI         %.3f ms", snapshot.m_gpuTimings.m_guiMillis);
+  ImGui::Text("Lines       %.3f ms", snapshot.m_gpuTimings.m_linesMillis);
+  ImGui::Text("Indicator   %.3f ms", snapshot.m_gpuTimings.m_indicatorMillis);
+  ImGui::Text("Composite   %.3f ms", snapshot.m_gpuTimings.m_compositeMillis);
+  ImGui::Text("End-Present %.3f ms", snapshot.m_gpuTimings.m_presentToEndMillis);
+  if(m_computeQueue)
+  {
+    // The compute queue's span of the frame, and how much of its load ran while the direct queue rendered the frame
+    GpuTimer::Timings const& timings = snapshot.m_gpuTimings;
+    ImGui::Text("Compute     %.3f ms", qpcToMillis(timings.m_computeEnd - timings.m_computeBegin));
+    ImGui::Text("Pattern     %.3f ms", timings.m_computePatternMillis);
+    ImGui::Text("Overlap     %.3f ms", timings.m_computeOverlapMillis);
+  }
+  if(m_loadPipeline || m_loadComputePipeline)
+  {
+    ImGui::Text("Load        %.3f ms", snapshot.m_gpuTimings.m_loadMillis);
+    ImGui::Text("%s load work %u (target %.2f ms)", gpuLoadModeName(m_gpuLoadMode), snapshot.m_gpuLoadWork,
+                snapshot.m_gpuLoadTargetMillis);
+  }
+  ImGui::End();
+
+  if(m_frameScheduler.pacing() != FramePacing::SLEEP)
+  {
+    ImGui::Begin("Frame pacing");
+    ImGui::SetWindowPos({800, 0}, ImGuiCond_FirstUseEver);
+    ImGui::SetWindowSize({240, 80}, ImGuiCond_FirstUseEver);
+    ImGui::Text("Input-Present %.3f ms", snapshot.m_latencyMillis);
+    if(m_frameScheduler.pacing() == FramePacing::TIMED || m_frameScheduler.pacing() == FramePacing::JUST_IN_TIME)
+    {
+      ImGui::Text("Present error %.3f ms", snapshot.m_presentErrorMillis);
+    }
+    ImGui::End();
+  }
+
+  if(snapshot.m_vsyncProbed)
+  {
+    ImGui::Begin("Vsync");
+    ImGui::SetWindowPos({800, 80}, ImGuiCond_FirstUseEver);
+    ImGui::SetWindowSize({240, 120}, ImGuiCond_FirstUseEver);
+    ImGui::Text("Refresh       %.3f ms", snapshot.m_refreshMillis);
+    ImGui::Text("Margin mean   %.3f ms", snapshot.m_vblankMarginMeanMillis);
+    ImGui::Text("Margin min    %.3f ms", snapshot.m_vblankMarginMinMillis);
+    ImGui::Text("Present-Flip  %.3f ms", snapshot.m_displayLatencyMillis);
+    ImGui::Text("Scanline      %u", snapshot.m_scanLine);
+    ImGui::End();
+  }
+
+  ThreadSchedulingSettings const& scheduling = m_threadScheduling.applied();
+  ImGui::Begin("Render thread");
+  ImGui::SetWindowPos({560, 180}, ImGuiCond_FirstUseEver);
+  ImGui::SetWindowSize({240, 240}, ImGuiCond_FirstUseEver);
+  ImGui::Text("Priority   %s", threadPriorityName(scheduling.m_priority));
+  ImGui::Text("MMCSS      %s", scheduling.m_mmcssTask.empty() ? "-" : scheduling.m_mmcssTask.c_str());
+  if(scheduling.m_affinityMask != 0)
+  {
+    ImGui::Text("Affinity   0x%llx", static_cast<unsigned long long>(scheduling.m_affinityMask));
+  }
+  if(scheduling.m_timerResolutionMillis != 0)
+  {
+    ImGui::Text("Timer      %u ms", scheduling.m_timerResolutionMillis);
+  }
+  ImGui::Text("Wake mean  %.1f us", snapshot.m_wakeLatencyMeanMicros);
+  ImGui::Text("Wake max   %.1f us", snapshot.m_wakeLatencyMaxMicros);
+  WakeLatencyHistogram const& fenceWake = snapshot.m_fenceWakeLatency;
+  ImGui::Text("Fence wait %s, p50 %.0f us, p99 %.0f us", fenceWaitStrategyName(m_fenceWaiter.strategy()),
+              fenceWake.percentileMicros(0.5f), fenceWake.percentileMicros(0.99f));
+  float fenceWakeBins[WAKE_LATENCY_HISTOGRAM_BINS];
+  for(std::uint32_t i = 0; i < WAKE_LATENCY_HISTOGRAM_BINS; ++i)
+  {
+    fenceWakeBins[i] = static_cast<float>(fenceWake.m_bins[i]);
+  }
+  ImGui::PlotHistogram("##fencewake", fenceWakeBins, WAKE_LATENCY_HISTOGRAM_BINS, 0, "log2 us", 0.0f, FLT_MAX, {0, 40});
+  ImGui::Text("Resize     %.1f ms to present", snapshot.m_resizeToPresentMillis);
+  ModeTransitionStats const& transition = snapshot.m_modeTransition;
+  if(transition.m_count != 0)
+  {
+    ImGui::Text("Transition %.1f ms, %u frames", transition.m_totalMillis, transition.m_frames);
+    ImGui::Text("  drain %.1f ms, apply %.1f ms", transition.m_drainMillis, transition.m_applyMillis);
+    if(transition.m_resynced)
+    {
+      ImGui::Text("  resync %.1f ms", transition.m_resyncMillis);
+    }
+    else
+    {
+      ImGui::Text("  not resynced");
+    }
+  }
+  if(snapshot.m_frameMarker.m_valid)
+  {
+    ImGui::Text("Marker     frame %u node %u", snapshot.m_frameMarker.m_frame, snapshot.m_frameMarker.m_nodeId);
+    if(snapshot.m_frameMarkerMismatches != 0)
+    {
+      ImGui::Text("  %llu mismatches", static_cast<unsigned long long>(snapshot.m_frameMarkerMismatches));
+    }
+  }
+  ImGui::End();
+
+  ImGui::Begin("Sync metrics");
+  ImGui::SetWindowPos({240, 0}, ImGuiCond_FirstUseEver);
+  ImGui::SetWindowSize({320, 300}, ImGuiCond_FirstUseEver);
+  ImGui::Text("Sync loss events: %llu", static_cast<unsigned long long>(snapshot.m_syncMetrics.syncLossEvents()));
+  ImGui::Text("Presents out of sync: %llu",
+              static_cast<unsigned long long>(snapshot.m_syncMetrics.presentsOutOfSync()));
+  ImGui::Text("Missed refreshes: %llu", static_cast<unsigned long long>(snapshot.m_syncMetrics.totalMissedRefreshes()));
+  ImGui::Text("Degraded intervals: %llu", static_cast<unsigned long long>(snapshot.m_syncMetrics.degradedIntervals()));
+  ImGui::PlotLines("PresentInSync", snapshot.m_syncMetrics.presentInSyncRatios(), SyncMetrics::HISTORY_SIZE,
+                   snapshot.m_syncMetrics.historyOffset(), nullptr, 0.0f, 1.0f, {0, 40});
+  ImGui::PlotLines("FlipInSync", snapshot.m_syncMetrics.flipInSyncRatios(), SyncMetrics::HISTORY_SIZE,
+                   snapshot.m_syncMetrics.historyOffset(), nullptr, 0.0f, 1.0f, {0, 40});
+  ImGui::PlotLines("Missed refreshes", snapshot.m_syncMetrics.missedRefreshes(), SyncMetrics::HISTORY_SIZE,
+                   snapshot.m_syncMetrics.historyOffset(), nullptr, 0.0f, FLT_MAX, {0, 40});
+  for(std::uint32_t i = 0; i < snapshot.m_syncMetrics.transitionCount(); ++i)
+  {
+    SyncMetrics::Transition const& transition = snapshot.m_syncMetrics.transition(i);
+    ImGui::Text("Frame %llu: %s -> %s", static_cast<unsigned long long>(transition.m_frameIndex),
+                presentBarrierSyncModeName(transition.m_from), presentBarrierSyncModeName(transition.m_to));
+  }
+  ImGui::End();
+
+  if(m_presentSkew && m_presentSkew->windows() > 1)
+  {
+    ImGui::Begin("Windows");
+    ImGui::SetWindowPos({800, 80}, ImGuiCond_FirstUseEver);
+    ImGui::SetWindowSize({240, 200}, ImGuiCond_FirstUseEver);
+    ImGui::Text("Present skew     %.3f ms", snapshot.m_presentSkewMillis);
+    ImGui::Text("Peak skew        %.3f ms", snapshot.m_peakPresentSkewMillis);
+    bool allInClusterSync = true;
+    if(ImGui::BeginTable("windows", 3, ImGuiTableFlags_SizingStretchProp))
+    {
+      ImGui::TableNextColumn();
+      ImGui::Text("Window");
+      ImGui::TableNextColumn();
+      ImGui::Text("Adapter");
+      ImGui::TableNextColumn();
+      ImGui::Text("SyncMode");
+      for(std::uint32_t i = 0; i < m_presentSkew->windows(); ++i)
+      {
+        const NvU32 syncMode = m_presentSkew->syncMode(i);
+        allInClusterSync     = allInClusterSync && syncMode == PRESENT_BARRIER_SYNC_CLUSTER;
+        ImGui::TableNextColumn();
+        ImGui::Text("%u", i);
+        ImGui::TableNextColumn();
+        ImGui::Text("%u", m_presentSkew->adapter(i));
+        ImGui::TableNextColumn();
+        ImGui::Text("%s", presentBarrierSyncModeName(syncMode));
+      }
+      ImGui::EndTable();
+    }
+    ImGui::TextColored(allInClusterSync ? ImVec4(0.462f, 0.725f, 0.0f, 1.0f) : ImVec4(1.0f, 0.2f, 0.2f, 1.0f),
+                       allInClusterSync ? "All windows in SYNC_CLUSTER" : "Not all windows in SYNC_CLUSTER");
+    ImGui::End();
+  }
+
+  if(m_telemetryCollector.isOpen())
+  {
+    std::vector<ClusterNodeStatus> nodes = m_telemetryCollector.nodes();
+    ImGui::Begin("Cluster");
+    ImGui::SetWindowPos({0, 120}, ImGuiCond_FirstUseEver);
+    if(ImGui::BeginTable("cluster", 8, ImGuiTableFlags_SizingStretchProp))
+    {
+      ImGui::TableNextColumn();
+      ImGui::Text("Node");
+      ImGui::TableNextColumn();
+      ImGui::Text("Presents/s");
+      ImGui::TableNextColumn();
+      ImGui::Text("In sync");
+      ImGui::TableNextColumn();
+      ImGui::Text("Drift/s");
+      ImGui::TableNextColumn();
+      ImGui::Text("p99 ms");
+      ImGui::TableNextColumn();
+      ImGui::Text("Wake us");
+      ImGui::TableNextColumn();
+      ImGui::Text("Margin us");
+      ImGui::TableNextColumn();
+      ImGui::Text("Frame skew");
+      for(ClusterNodeStatus const& node : nodes)
+      {
+        const bool   flagged = node.m_stale || node.m_outOfSync || node.m_drifting || node.m_frameSkewed;
+        const ImVec4 color   = flagged ? ImVec4(1.0f, 0.2f, 0.2f, 1.0f) : ImVec4(1.0f, 1.0f, 1.0f, 1.0f);
+        ImGui::TableNextColumn();
+        ImGui::TextColored(color, "%s%s", node.m_name.c_str(), node.m_stale ? " (stale)" : "");
+        ImGui::TableNextColumn();
+        ImGui::TextColored(color, "%.2f", node.m_presentRate);
+        ImGui::TableNextColumn();
+        ImGui::TextColored(color, "%.1f%%", node.m_inSyncRatio * 100.0f);
+        ImGui::TableNextColumn();
+        ImGui::TextColored(color, "%.2f", node.m_driftPerSecond);
+        ImGui::TableNextColumn();
+        ImGui::TextColored(color, "%.1f", node.m_frameTimeP99);
+        ImGui::TableNextColumn();
+        ImGui::TextColored(color, "%.0f", node.m_last.m_wakeLatencyMaxMicros);
+        ImGui::TableNextColumn();
+        ImGui::TextColored(color, "%.0f", node.m_last.m_vblankMarginMinMicros);
+        ImGui::TableNextColumn();
+        ImGui::TextColored(color, "%+.1f", node.m_frameSkew);
+      }
+      ImGui::EndTable();
+    }
+    ImGui::End();
+  }
+
   ImGui::Render();
 
+  ImDrawData*         drawData = ImGui::GetDrawData();
+  const std::uint64_t hash     = hashDrawData(*drawData);
+  if(m_guiTargets[m_guiCompositeTarget].m_valid && hash == m_guiDrawDataHash)
+  {
+    return false;
+  }
+
+  // The allocator was last used for the previous recording into this target, which is usually long done
+  GuiTarget& guiTarget = m_guiTargets[target];
+  if(m_guiFence->GetCompletedValue() < guiTarget.m_submitIndex)
+  {
+    HR_CHECK(m_guiFence->SetEventOnCompletion(guiTarget.m_submitIndex, m_guiEvt));
+    WaitForSingleObject(m_guiEvt, INFINITE);
+  }
+  const float guiMillis = m_gpuTimer.readGui(target);
+  if(guiMillis >= 0.0f)
+  {
+    m_guiGpuMillis = guiMillis;
+  }
+  HR_CHECK(guiTarget.m_commandAllocator->Reset());
+  HR_CHECK(m_guiCommandList->Reset(guiTarget.m_commandAllocator.Get(), nullptr));
+  m_gpuTimer.guiTimestamp(m_guiCommandList.Get(), target, false);
+
+  // A render target placed in a heap has to be initialized by a discard, a full clear or a copy before its first use,
+  // the clear below only covers the swap chain area
+  if(guiTarget.m_placed)
+  {
+    m_guiCommandList->DiscardResource(guiTarget.m_texture.Get(), nullptr);
+    guiTarget.m_placed = false;
+  }
+
+  // Only clear what the target's previous gui covered, unless the texture content is undefined
+  const D3D12_RECT guiRect   = drawDataBounds(*drawData, m_frameContext.m_scissorRect);
+  D3D12_RECT       clearRect = m_frameContext.m_scissorRect;
+  if(guiTarget.m_valid)
+  {
+    clearRect = guiTarget.m_rect;
+    if(isEmpty(clearRect))
+    {
+      clearRect = guiRect;
+    }
+    else if(!isEmpty(guiRect))
+    {
+      clearRect.left   = std::min(clearRect.left, guiRect.left);
+      clearRect.top    = std::min(clearRect.top, guiRect.top);
+      clearRect.right  = std::max(clearRect.right, guiRect.right);
+      clearRect.bottom = std::max(clearRect.bottom, guiRect.bottom);
+    }
+  }
+  guiTarget.m_rect  = guiRect;
+  guiTarget.m_valid = true;
+  m_guiDrawDataHash = hash;
+
   auto cbvSrvUavHeap = m_cbvSrvUavHeap.Get();
   m_guiCommandList->SetDescriptorHeaps(1, &cbvSrvUavHeap);
-  auto guiRtvHandle = m_rtvHeap->GetCPUDescriptorHandleForHeapStart();
-  guiRtvHandle.ptr +=
-      D3D12_SWAP_CHAIN_SIZE * 2 * m_context.m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
   FLOAT guiClearColor[] = {0.0f, 0.0f, 0.0f, 0.0f};
-  m_guiCommandList->ClearRenderTargetView(guiRtvHandle, guiClearColor, 0, nullptr);
-  m_guiCommandList->OMSetRenderTargets(1, &guiRtvHandle, FALSE, nullptr);
-  ImGui_ImplDX12_RenderDrawData(ImGui::GetDrawData(), m_guiCommandList.Get());
+  if(!isEmpty(clearRect))
+  {
+    m_guiCommandList->ClearRenderTargetView(m_frameContext.m_guiRtvHandles[target], guiClearColor, 1, &clearRect);
+  }
+  m_guiCommandList->OMSetRenderTargets(1, &m_frameContext.m_guiRtvHandles[target], FALSE, nullptr);
+  ImGui_ImplDX12_RenderDrawData(drawData, m_guiCommandList.Get());
+  m_gpuTimer.guiTimestamp(m_guiCommandList.Get(), target, true);
+  m_gpuTimer.resolveGui(m_guiCommandList.Get(), target);
+  HR_CHECK(m_guiCommandList->Close());
+  return true;
 }
 
-void RenderThread::drawGui(ComPtr<ID3D12GraphicsCommandList> commandList)
+void RenderThread::drawGui(ID3D12GraphicsCommandList* commandList)
 {
-  commandList->SetPipelineState(m_guiPipeline.Get());
-  commandList->SetGraphicsRootDescriptorTable(1, m_cbvSrvUavHeap->GetGPUDescriptorHandleForHeapStart());
-  D3D12_RESOURCE_BARRIER rt2psBarrier = nvdx12::transitionBarrier(m_guiTexture.Get(), D3D12_RESOURCE_STATE_RENDER_TARGET,
-                                                                  D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+  GuiTarget const& target = m_guiTargets[m_guiCompositeTarget];
+  if(m_config.m_disableGui || !target.m_valid || isEmpty(target.m_rect))
+  {
+    return;
+  }
+
+  // The composite is a fullscreen triangle, the scissor keeps it from reading the texture outside of the gui
+  commandList->RSSetScissorRects(1, &target.m_rect);
+  commandList->SetGraphicsRootDescriptorTable(ROOT_TEXTURES, m_frameContext.m_guiSrvHandles[m_guiCompositeTarget]);
+  D3D12_RESOURCE_BARRIER rt2psBarrier = nvdx12::transitionBarrier(
+      target.m_texture.Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
   commandList->ResourceBarrier(1, &rt2psBarrier);
-  commandList->DrawInstanced(3, 1, 0, 0);
-  D3D12_RESOURCE_BARRIER ps2rtBarrier =
-      nvdx12::transitionBarrier(m_guiTexture.Get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+  commandList->ExecuteBundle(drawBundles().m_gui.Get());
+  D3D12_RESOURCE_BARRIER ps2rtBarrier = nvdx12::transitionBarrier(
+      target.m_texture.Get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
   commandList->ResourceBarrier(1, &ps2rtBarrier);
+  commandList->RSSetScissorRects(1, &m_frameContext.m_scissorRect);
+}
+
+bool RenderThread::collectGui()
+{
+  std::lock_guard guard(m_guiMutex);
+  if(m_guiJobState != GuiJobState::DONE)
+  {
+    return false;
+  }
+  m_guiJobState = GuiJobState::IDLE;
+  return m_guiRecorded;
+}
+
+void RenderThread::kickGui()
+{
+  if(!m_guiWorker.joinable())
+  {
+    return;
+  }
+
+  std::lock_guard guard(m_guiMutex);
+  if(m_guiJobState != GuiJobState::IDLE)
+  {
+    return;
+  }
+  m_guiSnapshot.m_presentBarrierJoined  = m_presentBarrierJoined;
+  m_guiSnapshot.m_presentBarrierStats   = m_presentBarrierFrameStats;
+  m_guiSnapshot.m_gpuTimings            = m_gpuTimings;
+  m_guiSnapshot.m_gpuLoadWork           = m_gpuLoadController.work();
+  m_guiSnapshot.m_gpuLoadTargetMillis   = m_gpuLoadController.targetMillis();
+  m_guiSnapshot.m_latencyMillis         = m_frameScheduler.latencyMillis();
+  m_guiSnapshot.m_presentErrorMillis    = m_frameScheduler.presentErrorMillis();
+  m_guiSnapshot.m_syncMetrics           = m_syncMetrics;
+  m_guiSnapshot.m_wakeLatencyMeanMicros = m_frameScheduler.wakeLatency().meanMicros();
+  m_guiSnapshot.m_wakeLatencyMaxMicros  = m_frameScheduler.wakeLatency().maxMicros();
+  m_guiSnapshot.m_fenceWakeLatency      = m_fenceWaiter.histogram();
+  m_guiSnapshot.m_modeTransition        = m_transitionStats;
+  m_guiSnapshot.m_resizeToPresentMillis = m_resizeToPresentMillis;
+  m_guiSnapshot.m_vsyncProbed           = m_vsyncProbe.isOpen();
+  if(m_guiSnapshot.m_vsyncProbed)
+  {
+    m_guiSnapshot.m_refreshMillis          = static_cast<float>(qpcToMillis(m_vsyncProbe.refreshPeriod()));
+    m_guiSnapshot.m_vblankMarginMeanMillis = m_vsyncProbe.marginMeanMillis();
+    m_guiSnapshot.m_vblankMarginMinMillis  = m_vsyncProbe.marginMinMillis();
+    m_guiSnapshot.m_displayLatencyMillis   = m_vsyncProbe.displayLatencyMillis();
+    m_guiSnapshot.m_scanLine               = m_vsyncProbe.scanLine();
+  }
+  if(m_presentSkew)
+  {
+    m_guiSnapshot.m_presentSkewMillis     = m_presentSkew->skewMillis();
+    m_guiSnapshot.m_peakPresentSkewMillis = m_presentSkew->peakSkewMillis();
+  }
+  m_guiSnapshot.m_frameMarker           = m_frameMarkerValue;
+  m_guiSnapshot.m_frameMarkerMismatches = m_frameMarker.mismatches();
+  m_guiJobTarget                        = (m_guiCompositeTarget + 1) % GUI_TARGETS;
+  m_guiJobState                         = GuiJobState::PENDING;
+  m_guiConVar.notify_all();
+}
+
+void RenderThread::discardGui()
+{
+  // A gui recorded for the old gui targets is never submitted
+  std::unique_lock lock(m_guiMutex);
+  m_guiConVar.wait(lock, [this]() { return m_guiJobState == GuiJobState::IDLE || m_guiJobState == GuiJobState::DONE; });
+  m_guiJobState = GuiJobState::IDLE;
+}
+
+void RenderThread::guiWorkerLoop()
+{
+  std::unique_lock lock(m_guiMutex);
+  while(true)
+  {
+    m_guiConVar.wait(lock, [this]() { return m_guiWorkerStop || m_guiJobState == GuiJobState::PENDING; });
+    if(m_guiWorkerStop)
+    {
+      return;
+    }
+
+    // The render thread leaves the snapshot and the gui targets alone until the job is done
+    m_guiJobState = GuiJobState::RECORDING;
+    lock.unlock();
+    const bool recorded = recordGui(m_guiSnapshot, m_guiJobTarget);
+    lock.lock();
+    m_guiRecorded = recorded;
+    m_guiJobState = GuiJobState::DONE;
+    m_guiConVar.notify_all();
+  }
 }
 
 DisplayMode RenderThread::trySetDisplayMode(DisplayMode displayMode)
@@ -1028,13 +2800,14 @@ DisplayMode RenderThread::trySetDisplayMode(DisplayMode displayMode)
   else
   {
     ComPtr<IDXGIAdapter> adapter;
-    HR_CHECK(m_context.m_factory->EnumAdapterByLuid(m_context.m_device->GetAdapterLuid(), IID_PPV_ARGS(&adapter)));
+    HR_CHECK(m_context->m_factory->EnumAdapterByLuid(m_context->m_device->GetAdapterLuid(), IID_PPV_ARGS(&adapter)));
     HR_CHECK(adapter->EnumOutputs(static_cast<UINT>(m_config.m_outputIndex), &output));
   }
 
   assert(output != nullptr);
 
   sync();
+  ++m_displayModeChanges;
 
   DXGI_MODE_DESC modeDesc = {};
   modeDesc.Format         = BACK_BUFFER_FORMAT;
@@ -1070,9 +2843,9 @@ DisplayMode RenderThread::trySetDisplayMode(DisplayMode displayMode)
     }
     else
     {
-      // Move the window a little away from the corner of the output
-      x += 128;
-      y += 160;
+      // Move the window a little away from the corner of the output, additional windows cascade from there
+      x += 128 + 32 * static_cast<int>(m_config.m_windowIndex);
+      y += 160 + 32 * static_cast<int>(m_config.m_windowIndex);
       modeDesc.Width  = m_config.m_winSize[0];
       modeDesc.Height = m_config.m_winSize[1];
       m_windowCallback->setDecorated(true);
@@ -1093,6 +2866,7 @@ void RenderThread::releasePresentBarrier()
 {
   if(!m_config.m_disablePresentBarrier && m_presentBarrierClient)
   {
+    m_syncSampler.setPresentBarrierClient(nullptr);
     if(m_presentBarrierJoined)
     {
       CHECK_NV(NvAPI_LeavePresentBarrier(m_presentBarrierClient));
@@ -1105,29 +2879,97 @@ void RenderThread::releasePresentBarrier()
 
 void RenderThread::end()
 {
-  ImGui_ImplDX12_Shutdown();
-  ImGui_ImplGlfw_Shutdown();
-  ImGui::DestroyContext();
+  if(m_guiWorker.joinable())
+  {
+    {
+      std::lock_guard guard(m_guiMutex);
+      m_guiWorkerStop = true;
+      m_guiConVar.notify_all();
+    }
+    m_guiWorker.join();
+  }
+  if(!m_config.m_disableGui)
+  {
+    ImGui_ImplDX12_Shutdown();
+    ImGui_ImplGlfw_Shutdown();
+    ImGui::DestroyContext();
+  }
 
+  // A run that is interrupted before its limit, e.g. by closing the window, is judged by the frames so far
+  m_validation.finish(m_syncMetrics);
+  WakeLatencyHistogram const& fenceWake = m_fenceWaiter.histogram();
+  if(fenceWake.m_count != 0)
+  {
+    LOGI("Fence wake latency with %s waits: p50 %.0f us, p99 %.0f us, p99.9 %.0f us over %llu waits\n",
+         fenceWaitStrategyName(m_fenceWaiter.strategy()), fenceWake.percentileMicros(0.5f),
+         fenceWake.percentileMicros(0.99f), fenceWake.percentileMicros(0.999f),
+         static_cast<unsigned long long>(fenceWake.m_count));
+  }
+  m_fenceWaiter.deinit();
+  m_syncSampler.stop();
+  m_latencyMarker.close();
   releasePresentBarrier();
   //CHECK_NV(NvAPI_Unload());
 
-  m_guiTexture.Reset();
+  m_frameRecorder.close();
+  m_soakMonitor.close();
+  m_telemetryPublisher.close();
+  m_telemetryCollector.close();
+  m_threadScheduling.revert();
+
+  m_gpuTimer.deinit();
+  m_uploadRing.deinit();
+  for(GuiTarget& target : m_guiTargets)
+  {
+    target = {};
+  }
+  m_guiHeap.Reset();
   m_guiPipeline.Reset();
+  m_loadPipeline.Reset();
+  m_markerPipeline.Reset();
+  m_frameMarker.deinit();
+  m_loadTexture.Reset();
+  m_bundles              = {};
+  m_viewInstancedBundles = {};
+  m_bundleAllocator.Reset();
+  m_viewInstancedVerticalLinesPipeline.Reset();
+  m_viewInstancedHorizontalLinesPipeline.Reset();
+  m_viewInstancedPatternPipeline.Reset();
+  m_viewInstancedIndicatorPipeline.Reset();
+  m_viewInstancedGuiPipeline.Reset();
   m_indicatorPipeline.Reset();
-  m_linesPipeline.Reset();
+  m_verticalLinesPipeline.Reset();
+  m_horizontalLinesPipeline.Reset();
+  m_patternPipeline.Reset();
+  m_patternComputePipeline.Reset();
+  m_patternBuffers.clear();
+  m_loadComputePipeline.Reset();
+  m_loadResultBuffer.Reset();
+  m_pipelineCache.deinit();
   m_rootSignature.Reset();
   m_rtvHeap.Reset();
   m_cbvSrvUavHeap.Reset();
   m_guiCommandList.Reset();
   m_graphicsCommandList.Reset();
-  m_guiCommandAllocators.clear();
   m_graphicsCommandAllocators.clear();
+  m_signalCommandLists.clear();
+  m_signalCommandAllocator.Reset();
+  m_computeCommandList.Reset();
+  m_computeCommandAllocators.clear();
+  m_computeFence.Reset();
+  m_computeQueue.Reset();
+  m_guiQueue.Reset();
   CloseHandle(m_syncEvt);
+  CloseHandle(m_guiEvt);
   m_guiFence.Reset();
   m_frameFence.Reset();
   m_presentBarrierFence.Reset();
   m_backBufferResources.clear();
+  m_vsyncProbe.close();
+  m_frameScheduler.deinit();
   m_swapChain.Reset();
-  m_context.deinit();
+  if(m_context == &m_ownedContext)
+  {
+    m_ownedContext.deinit();
+  }
 }
\ No newline at end of file
@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <condition_variable>
 #include <mutex>
 #include <optional>
@@ -18,6 +20,28 @@ using Microsoft::WRL::ComPtr;
 
 #include <nvapi.h>
 
+#include <ClusterTelemetry.h>
+#include <ControlPlane.h>
+#include <FenceWaiter.h>
+#include <FrameMarker.h>
+#include <FrameRecorder.h>
+#include <FrameScheduler.h>
+#include <GpuLoad.h>
+#include <GpuTimer.h>
+#include <LatencyMarker.h>
+#include <LinePattern.h>
+#include <PipelineCache.h>
+#include <PresentSkew.h>
+#include <RegressionBenchmark.h>
+#include <SoakMonitor.h>
+#include <SyncMetrics.h>
+#include <SyncSampler.h>
+#include <ThreadScheduling.h>
+#include <TransitionBenchmark.h>
+#include <UploadRing.h>
+#include <Validation.h>
+#include <VsyncProbe.h>
+
 enum class DisplayMode
 {
   WINDOWED,
@@ -30,22 +54,216 @@ struct Configuration
   std::string   m_startupDisplayMode          = "b";
   std::string   m_testMode                    = "n";
   std::string   m_frameCounterFilePath        = "";
+  std::string   m_recordFilePath              = "";
+  std::string   m_recordFormat                = "b";
+  std::string   m_telemetryAddress            = "";
+  std::string   m_nodeName                    = "";
+  std::string   m_gpuLoadMode                 = "a";
+  std::string   m_framePacing                 = "s";
+  std::string   m_fenceWait                   = "e";
+  std::string   m_threadAffinity              = "";
+  std::string   m_threadPriority              = "n";
+  std::string   m_mmcssTask                   = "";
+  std::string   m_transitionBenchmarkKinds    = "fbwsp";
+  std::string   m_transitionBenchmarkFile     = "transition_benchmark.json";
+  std::string   m_pipelineCacheDirectory      = "";  // empty for the executable's directory
+  std::string   m_linePattern                 = "l";
+  std::string   m_minimalContent              = "";  // empty renders the lines and the gui
+  std::string   m_validateSyncMode            = "cluster";
+  std::string   m_flashBroadcastAddress       = "";
+  std::string   m_soakFilePath                = "soak.csv";
+  std::string   m_benchmarkFile               = "";  // empty runs no benchmark
+  std::string   m_benchmarkBaseline           = "";
+  std::string   m_benchmarkModes              = "wbf";
+  std::string   m_benchmarkSleep              = "0";
+  std::string   m_benchmarkLoad               = "0";
   bool          m_disablePresentBarrier       = false;
   bool          m_stereo                      = false;
+  bool          m_disableViewInstancing       = false;
+  bool          m_disableGui                  = false;
+  bool          m_disablePipelineCache        = false;
+  bool          m_vsyncProbe                  = false;
+  bool          m_latencyFlash                = false;
+  bool          m_asyncCompute                = false;
+  bool          m_frameMarker                 = false;
+  bool          m_benchmarkStereo             = false;
   bool          m_showVerticalLines           = true;
   bool          m_showHorizontalLines         = true;
   bool          m_scrolling                   = true;
   bool          m_quadroSync                  = false;
   std::uint32_t m_testModeInterval            = 120;
   std::uint32_t m_numLines                    = 4;
+  std::uint32_t m_patternElements             = 4096;
   std::uint32_t m_lineSpeedInPixels           = 1;
   std::uint32_t m_sleepIntervalInMilliseconds = 0;
   std::uint32_t m_lineSizeInPixels[2]         = {1, 54};
   std::uint32_t m_syncTimeoutMillis           = 1000;
+  std::uint32_t m_recordCapacity              = 4096;
+  std::uint32_t m_recordMaxMegabytes          = 0;  // 0 grows without limit, or 256 with -soak
+  std::uint32_t m_soakIntervalMinutes         = 0;
+  std::uint32_t m_syncMetricsInterval         = 60;
+  std::uint32_t m_telemetryIntervalMillis     = 100;
+  std::uint32_t m_telemetryCollectorPort      = 0;
+  std::uint32_t m_gpuLoadWork                 = 0;
+  std::uint32_t m_presentPeriodMicros         = 0;
+  std::uint32_t m_justInTimeMarginMicros      = 1000;
+  std::uint32_t m_fenceSpinMicros             = 200;
+  std::uint32_t m_syncSampleIntervalMicros    = 0;  // 0 queries the statistics after every Present
+  std::uint32_t m_backBufferCount             = D3D12_SWAP_CHAIN_SIZE;
+  std::uint32_t m_maxFrameLatency             = 0;
+  std::uint32_t m_guiUpdateIntervalMillis     = 0;
+  std::uint32_t m_timerResolutionMillis       = 0;
+  std::uint32_t m_transitionBenchmarkTrials   = 0;
+  std::uint32_t m_transitionBenchmarkSettle   = 120;
+  std::uint32_t m_benchmarkFrames             = 300;
+  std::uint32_t m_validateFrames              = 0;
+  std::uint32_t m_frameMarkerId               = 0;  // plus the window index
+  std::uint32_t m_flashPort                   = 0;
+  std::uint32_t m_flashLeadMillis             = 100;
+  std::uint32_t m_windowCount                 = 1;
+  std::uint32_t m_windowIndex                 = 0;  // set per render thread, not a command-line option
+  float         m_minInSyncRatio              = 0.99f;
+  float         m_maxPresentDriftPerSecond    = 0.5f;
+  float         m_gpuLoadTargetMillis         = 0.0f;
+  float         m_validateSeconds             = 0.0f;
+  float         m_benchmarkThresholdPercent   = 10.0f;
   std::int32_t  m_outputIndex                 = -1;
+  std::int32_t  m_numaNode                    = -1;  // set per render thread, not a command-line option
   std::uint32_t m_winSize[2];
 };
 
+// Per-frame settings that can be changed at runtime from the window thread. They are published as a whole and picked
+// up by the render thread once at the beginning of every frame.
+struct FrameSettings
+{
+  std::uint32_t m_sleepIntervalInMilliseconds = 0;
+  NvU32         m_syncInterval                = 0;
+  bool          m_quadroSync                  = false;
+};
+
+// Requests from the window thread that are executed by the render thread between two frames
+enum class Command : std::uint8_t
+{
+  TOGGLE_STEREO,
+  TOGGLE_BORDERLESS,
+  TOGGLE_FULLSCREEN,
+  TOGGLE_PRESENT_BARRIER,
+  RESET_FRAME_COUNT,
+  FLASH_MARKER,
+};
+
+// Must match the LineConstants cbuffer in line.hlsli
+struct LineConstants
+{
+  float    verticalSizeA;
+  float    verticalSizeB;
+  float    horizontalSizeA;
+  float    horizontalSizeB;
+  float    verticalOffset;
+  float    horizontalOffset;
+  float    verticalSpacing;
+  float    horizontalSpacing;
+  uint32_t eye;
+  uint32_t horizontalInstanceBase;
+};
+
+// Must match the IndicatorConstants cbuffer in indicator_vs.hlsl
+struct IndicatorConstants
+{
+  float color[3];
+};
+
+// Must match the LoadConstants cbuffer in load_ps.hlsl and load_cs.hlsl
+struct LoadConstants
+{
+  uint32_t mode;
+  uint32_t work;
+  uint32_t seed;
+  float    opacity;
+};
+
+// Must match the PatternConstants cbuffer in pattern.hlsli
+struct PatternConstants
+{
+  uint32_t pattern;
+  uint32_t elementCount;
+  uint32_t frame;
+  uint32_t speed;
+  float    width;
+  float    height;
+  float    lineSize;
+  float    cellSize;
+  uint32_t display;
+  uint32_t eye;
+};
+
+// Latencies of a display mode, stereo or present barrier transition, all measured from the request
+struct ModeTransitionStats
+{
+  std::uint64_t m_count        = 0;      // completed transitions
+  float         m_drainMillis  = 0.0f;   // until the frames in flight finished
+  float         m_applyMillis  = 0.0f;   // swap chain, display mode and present barrier changes
+  float         m_resyncMillis = 0.0f;   // from the present barrier (re-)join until SYNC_SYSTEM or SYNC_CLUSTER
+  float         m_totalMillis  = 0.0f;
+  std::uint32_t m_frames       = 0;      // presented between the request and the end of the transition
+  bool          m_resynced     = false;  // false if the present barrier is not joined or did not resync in time
+};
+
+// Everything the gui shows, copied by the render thread whenever it hands a gui update to the gui worker
+struct GuiSnapshot
+{
+  bool                                m_presentBarrierJoined = false;
+  NV_PRESENT_BARRIER_FRAME_STATISTICS m_presentBarrierStats  = {};
+  GpuTimer::Timings                   m_gpuTimings;
+  std::uint32_t                       m_gpuLoadWork         = 0;
+  float                               m_gpuLoadTargetMillis = 0.0f;
+  float                               m_latencyMillis       = 0.0f;
+  float                               m_presentErrorMillis  = 0.0f;
+  SyncMetrics                         m_syncMetrics;
+  float                               m_presentSkewMillis     = 0.0f;
+  float                               m_peakPresentSkewMillis = 0.0f;
+  float                               m_wakeLatencyMeanMicros = 0.0f;
+  float                               m_wakeLatencyMaxMicros  = 0.0f;
+  WakeLatencyHistogram                m_fenceWakeLatency;
+  ModeTransitionStats                 m_modeTransition;
+  float                               m_resizeToPresentMillis  = 0.0f;
+  bool                                m_vsyncProbed            = false;
+  float                               m_refreshMillis          = 0.0f;
+  float                               m_vblankMarginMeanMillis = 0.0f;
+  float                               m_vblankMarginMinMillis  = 0.0f;
+  float                               m_displayLatencyMillis   = 0.0f;
+  std::uint32_t                       m_scanLine               = 0;
+  FrameMarkerValue                    m_frameMarker;
+  std::uint64_t                       m_frameMarkerMismatches  = 0;
+};
+
+constexpr UINT GUI_TARGETS = 2;
+
+// Everything frame recording needs that only changes with the swap chain, so the hot path only reads from it. Rebuilt
+// by swapResize.
+struct FrameContext
+{
+  UINT                                     m_width           = 0;
+  UINT                                     m_height          = 0;
+  UINT                                     m_backBufferCount = 0;
+  D3D12_VIEWPORT                           m_viewport        = {};
+  D3D12_RECT                               m_scissorRect     = {};
+  std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> m_rtvHandles;       // per eye and back buffer
+  std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> m_arrayRtvHandles;  // both eyes per back buffer, stereo only
+  D3D12_CPU_DESCRIPTOR_HANDLE              m_guiRtvHandles[GUI_TARGETS] = {};
+  D3D12_GPU_DESCRIPTOR_HANDLE              m_guiSrvHandles[GUI_TARGETS] = {};
+  D3D12_GPU_DESCRIPTOR_HANDLE              m_loadSrvHandle              = {};
+  LineConstants                            m_lineConstants              = {};  // offsets are updated every frame
+  PatternConstants                         m_patternConstants           = {};  // the frame is updated every frame
+  UINT                                     m_verticalLineCount          = 0;
+  UINT                                     m_horizontalLineCount        = 0;
+
+  D3D12_CPU_DESCRIPTOR_HANDLE const& rtvHandle(UINT backBufferIndex, UINT eye) const
+  {
+    return m_rtvHandles[eye * m_backBufferCount + backBufferIndex];
+  }
+};
+
 // window attributes can only be changed from window-owning thread
 class WindowCallback
 {
@@ -62,7 +280,10 @@ public:
   RenderThread();
   ~RenderThread() {}
 
-  bool        start(Configuration const& initialConfig, WindowCallback* windowCallback);
+  // Render threads of additional windows share the device and queue of the first window's render thread, which has
+  // to be started before and interrupted after them
+  bool        start(Configuration const& initialConfig, WindowCallback* windowCallback,
+                    nvdx12::Context* sharedContext = nullptr, PresentSkewMonitor* presentSkew = nullptr);
   void        togglePaused();
   void        interruptAndJoin();
   DisplayMode trySetDisplayMode(DisplayMode displayMode);
@@ -75,9 +296,16 @@ public:
   void        requestFullscreenStateChange();
   bool        requestPresentBarrierChange(std::uint32_t maxWaitMillis);
   void        requestResetFrameCount();
+  void        requestFlash();
   void        forcePresentBarrierChange();
 
   nvdx12::ContextCreateInfo& contextInfo() { return m_contextInfo; }
+  // Only valid once the render thread is started
+  nvdx12::Context* context() { return m_context; }
+  // A scripted run is done, the window should be closed
+  bool runFinished() const { return m_runFinished; }
+  // Result of a validation or benchmark run, only valid after interruptAndJoin()
+  int exitCode() const { return std::max(m_validation.exitCode(), m_regressionBenchmark.exitCode()); }
 
 private:
   enum class Status
@@ -90,20 +318,52 @@ private:
   };
 
   std::thread             m_thread;
-  Status                  m_status = Status::CREATED;
+  std::atomic<Status>     m_status = Status::CREATED;
   std::mutex              m_mutex;
   std::condition_variable m_conVar;
   WindowCallback*         m_windowCallback = nullptr;
 
-  Configuration m_config;
-  NvU32         m_linesPosOffset         = 0;
-  bool          m_requestToggleStereo    = false;
-  bool          m_requestResetFrameCount = false;
-  bool          m_skipNextSwap           = false;
-  std::ofstream m_frameCounterFile;
+  // The mutex is only held by the render thread during display mode, stereo, and present barrier transitions. Settings
+  // and requests are handed over lock-free, only owned by the window thread until published.
+  FrameSettings               m_pendingSettings;
+  TripleBuffer<FrameSettings> m_frameSettings;
+  SpscQueue<Command, 64>      m_commands;
+  std::uint64_t               m_presentBarrierChangesRequested = 0;
+  std::atomic<std::uint64_t>  m_presentBarrierChangesCompleted = 0;
+  std::atomic<std::int64_t>   m_flashRequestTime               = 0;  // of the last requestFlash()
+
+  Configuration     m_config;
+  NvU32             m_linesPosOffset         = 0;
+  bool              m_requestToggleStereo    = false;
+  bool              m_requestResetFrameCount = false;
+  bool              m_skipNextSwap           = false;
+  FrameRecorder     m_frameRecorder;
+  FrameRecord       m_frameRecord;
+  FrameScheduler    m_frameScheduler;
+  FenceWaiter       m_fenceWaiter;
+  VsyncProbe        m_vsyncProbe;
+  LatencyMarker     m_latencyMarker;
+  Flash             m_flash;
+  bool              m_flashFrame = false;  // the frame being rendered flashes the marker
+  FrameMarker       m_frameMarker;
+  FrameMarkerValue  m_frameMarkerValue;  // decoded from the latest frame slot that had a marker
+  GpuTimer          m_gpuTimer;
+  GpuTimer::Timings m_gpuTimings;
+  GpuLoadMode       m_gpuLoadMode = GpuLoadMode::ALU;
+  GpuLoadController m_gpuLoadController;
+  ThreadScheduling  m_threadScheduling;
+
+  SyncMetrics        m_syncMetrics;
+  SyncSampler        m_syncSampler;
+  TelemetryPublisher m_telemetryPublisher;
+  TelemetryCollector m_telemetryCollector;
+  TelemetryPacket    m_telemetryPacket;
+  std::int64_t       m_lastPresentBegin = 0;
 
   nvdx12::ContextCreateInfo m_contextInfo;
-  nvdx12::Context           m_context;
+  nvdx12::Context           m_ownedContext;
+  nvdx12::Context*          m_context     = &m_ownedContext;  // the first window's context for additional windows
+  PresentSkewMonitor*       m_presentSkew = nullptr;
 
   ComPtr<ID3D12Fence> m_presentBarrierFence;
   ComPtr<ID3D12Fence> m_frameFence;
@@ -111,47 +371,210 @@ private:
   UINT64              m_frameIdx = 0;
   HANDLE              m_syncEvt  = NULL;
 
+  // Async queues, only created with -asynccompute. The direct queue waits for the pattern of a frame before its draws
+  // and for the frame's compute load before the frame fence is signaled, so the frame fence also guards the compute
+  // allocators. The gui is rasterized on a second direct queue, compute queues can't rasterize.
+  ComPtr<ID3D12CommandQueue>                  m_computeQueue;
+  ComPtr<ID3D12CommandQueue>                  m_guiQueue;
+  ComPtr<ID3D12GraphicsCommandList>           m_computeCommandList;
+  std::vector<ComPtr<ID3D12CommandAllocator>> m_computeCommandAllocators;
+  ComPtr<ID3D12Fence>                         m_computeFence;
+  UINT64                                      m_computeSubmitCount = 0;
+  ComPtr<ID3D12PipelineState>                 m_loadComputePipeline;
+  ComPtr<ID3D12Resource>                      m_loadResultBuffer;  // written by the compute load, never read
+
   ComPtr<IDXGISwapChain3>             m_swapChain;
   std::vector<ComPtr<ID3D12Resource>> m_backBufferResources;
-  ComPtr<ID3D12Resource>              m_guiTexture;
+  ComPtr<ID3D12Resource>              m_loadTexture;
   ComPtr<ID3D12DescriptorHeap>        m_rtvHeap;
   ComPtr<ID3D12DescriptorHeap>        m_cbvSrvUavHeap;
 
   ComPtr<ID3D12GraphicsCommandList>           m_graphicsCommandList;
   std::vector<ComPtr<ID3D12CommandAllocator>> m_graphicsCommandAllocators;
-  ComPtr<ID3D12GraphicsCommandList>           m_guiCommandList;
-  std::vector<ComPtr<ID3D12CommandAllocator>> m_guiCommandAllocators;
   std::vector<UINT64>                         m_allocatorFrameIndices;
+  UploadRing                                  m_uploadRing;  // one slot per command allocator
+
+  // Recorded once, one per command allocator, with the timestamp executed right before the frame fence is signaled
+  ComPtr<ID3D12CommandAllocator>                 m_signalCommandAllocator;
+  std::vector<ComPtr<ID3D12GraphicsCommandList>> m_signalCommandLists;
 
   NvPresentBarrierClientHandle m_presentBarrierClient = nullptr;
 
-  ComPtr<ID3D12PipelineState> m_linesPipeline;
+  ComPtr<ID3D12PipelineState> m_verticalLinesPipeline;
+  ComPtr<ID3D12PipelineState> m_horizontalLinesPipeline;
   ComPtr<ID3D12PipelineState> m_indicatorPipeline;
   ComPtr<ID3D12PipelineState> m_guiPipeline;
-  ComPtr<ID3D12RootSignature> m_rootSignature;
+  ComPtr<ID3D12PipelineState> m_loadPipeline;
+  ComPtr<ID3D12PipelineState> m_markerPipeline;  // only with -framemarker
+
+  // GPU generated line patterns, only created for patterns other than LINES. The compute pass writes the elements of
+  // the frame into the pattern buffer, the draws of the same frame read them. On the compute queue the next frame's
+  // pattern is written while the draws of the previous frame still read theirs, so every frame slot has its own.
+  LinePattern                         m_linePattern = LinePattern::LINES;
+  ComPtr<ID3D12PipelineState>         m_patternComputePipeline;
+  ComPtr<ID3D12PipelineState>         m_patternPipeline;
+  std::vector<ComPtr<ID3D12Resource>> m_patternBuffers;
+
+  // Single-pass stereo, only created if view instancing is supported
+  ComPtr<ID3D12PipelineState> m_viewInstancedVerticalLinesPipeline;
+  ComPtr<ID3D12PipelineState> m_viewInstancedHorizontalLinesPipeline;
+  ComPtr<ID3D12PipelineState> m_viewInstancedIndicatorPipeline;
+  ComPtr<ID3D12PipelineState> m_viewInstancedGuiPipeline;
+  ComPtr<ID3D12PipelineState> m_viewInstancedPatternPipeline;
+  bool                        m_viewInstancingSupported = false;
+  PipelineCache               m_pipelineCache;
+
+  // Static parts of the frame, the frame's command list only binds the per-frame constants and sets barriers
+  struct DrawBundles
+  {
+    ComPtr<ID3D12GraphicsCommandList> m_lines;    // both orientations
+    ComPtr<ID3D12GraphicsCommandList> m_pattern;  // only for GPU generated patterns
+    ComPtr<ID3D12GraphicsCommandList> m_indicator;
+    ComPtr<ID3D12GraphicsCommandList> m_gui;
+  };
+  struct BundlePipelines
+  {
+    ID3D12PipelineState* m_verticalLines   = nullptr;
+    ID3D12PipelineState* m_horizontalLines = nullptr;
+    ID3D12PipelineState* m_pattern         = nullptr;
+    ID3D12PipelineState* m_indicator       = nullptr;
+    ID3D12PipelineState* m_gui             = nullptr;
+  };
+  ComPtr<ID3D12CommandAllocator> m_bundleAllocator;
+  DrawBundles                    m_bundles;
+  DrawBundles                    m_viewInstancedBundles;
+  ComPtr<ID3D12RootSignature>    m_rootSignature;
 
-  DisplayMode                         m_displayMode                   = DisplayMode::WINDOWED;
-  DisplayMode                         m_requestedDisplayMode          = DisplayMode::WINDOWED;
-  bool                                m_presentBarrierChangeRequested = false;
-  bool                                m_presentBarrierJoined          = false;
-  NvU32                               m_frameCount                    = 0;
-  NvU32                               m_syncInterval                  = 0;
-  NV_PRESENT_BARRIER_FRAME_STATISTICS m_presentBarrierFrameStats      = {};
+  // The gui is recorded by a worker thread into the gui target that is not composited. The render thread hands a
+  // snapshot to the worker after submitting a frame and submits the recorded gui with the first frame after the worker
+  // is done, until then the previous gui target is composited. Gui targets are only re-rendered when the gui's draw
+  // data changes and only composited within their bounds.
+  enum class GuiJobState
+  {
+    IDLE,
+    PENDING,
+    RECORDING,
+    DONE,
+  };
+  struct GuiTarget
+  {
+    ComPtr<ID3D12Resource>         m_texture;
+    ComPtr<ID3D12CommandAllocator> m_commandAllocator;
+    D3D12_RECT                     m_rect        = {};
+    UINT64                         m_submitIndex = 0;      // m_guiFence value once the last recording is executed
+    bool                           m_valid       = false;  // cleared whenever the texture is recreated
+    bool                           m_placed      = false;  // newly placed in the heap, discarded by the next recording
+  };
+  std::thread                       m_guiWorker;
+  std::mutex                        m_guiMutex;
+  std::condition_variable           m_guiConVar;
+  GuiJobState                       m_guiJobState   = GuiJobState::IDLE;  // guarded by m_guiMutex
+  bool                              m_guiWorkerStop = false;              // guarded by m_guiMutex
+  bool                              m_guiRecorded   = false;              // result of the last job
+  GuiSnapshot                       m_guiSnapshot;
+  UINT                              m_guiJobTarget = 0;
+  GuiTarget                         m_guiTargets[GUI_TARGETS];
+  ComPtr<ID3D12Heap>                m_guiHeap;
+  UINT                              m_guiTextureSize[2] = {};  // only grows, see swapResize
+  UINT                              m_guiCompositeTarget = 0;
+  UINT64                            m_guiSubmitCount     = 0;
+  ComPtr<ID3D12GraphicsCommandList> m_guiCommandList;
+  HANDLE                            m_guiEvt          = NULL;
+  std::atomic<float>                m_guiGpuMillis    = 0.0f;
+  std::uint64_t                     m_guiDrawDataHash = 0;  // worker only
+  std::int64_t                      m_guiLastUpdate   = 0;  // worker only
+
+  // Transitions first drain the frames in flight by polling the frame fence, so the mutex is never held while waiting
+  // for the GPU. All requested changes are then applied at once, and the transition ends when the present barrier is
+  // back in sync.
+  enum class TransitionState
+  {
+    IDLE,
+    DRAINING,
+    RESYNCING,
+  };
+  TransitionState     m_transitionState                 = TransitionState::IDLE;
+  bool                m_transitionToggleStereo          = false;
+  bool                m_transitionJoinPresentBarrier    = false;  // requested present barrier state
+  std::uint64_t       m_transitionPresentBarrierChanges = 0;
+  std::uint64_t       m_transitionRequestFrame          = 0;
+  std::int64_t        m_transitionRequestTime           = 0;
+  std::int64_t        m_transitionDrainStart            = 0;  // restarted after a forced present barrier leave
+  std::int64_t        m_transitionDrainedTime           = 0;
+  std::int64_t        m_transitionAppliedTime           = 0;
+  ModeTransitionStats m_transitionStats;
+  TransitionBenchmark m_transitionBenchmark;
+  RegressionBenchmark m_regressionBenchmark;
+  ValidationRun       m_validation;
+  MinimalContent      m_minimalContent        = MinimalContent::NONE;
+  std::int64_t        m_resizeBegin           = 0;  // reset by the first present after the swap chain was resized
+  float               m_resizeToPresentMillis = 0.0f;
+  std::uint32_t       m_swapResizes           = 0;
+  std::uint32_t       m_displayModeChanges    = 0;
+  SoakMonitor         m_soakMonitor;
+  DisplayMode         m_benchmarkDisplayMode = DisplayMode::WINDOWED;  // the current trial's display mode to go back to
+  std::atomic<bool>   m_runFinished          = false;
+
+  DisplayMode                         m_displayMode              = DisplayMode::WINDOWED;
+  DisplayMode                         m_requestedDisplayMode     = DisplayMode::WINDOWED;
+  bool                                m_presentBarrierJoined     = false;
+  NvU32                               m_frameCount               = 0;
+  NvU32                               m_syncInterval             = 0;
+  UINT                                m_backBufferIndex          = 0;
+  FrameContext                        m_frameContext;
+  NV_PRESENT_BARRIER_FRAME_STATISTICS m_presentBarrierFrameStats = {};
 
   bool isInterrupted();
+  bool pushCommand(Command command);
+  void publishSettings();
+  void fetchSettings();
+  void processCommands();
+  // Returns false while the frames in flight of a transition drain, no frame is rendered meanwhile
+  bool advanceTransition();
+  void applyTransition();
+  void updateTransition();
+  void completeTransition(bool resynced);
+  void executeBenchmarkStep(TransitionBenchmark::Step const& step, std::uint64_t& presentBarrierChanges);
+  void applyBenchmarkCase(BenchmarkCase const& benchmarkCase);
 
   bool init(unsigned int initialWidth, unsigned int initialHeight);
+  // Runs on a separate thread during init, only uses the device
+  void createPipelines(bool gpuLoad);
+  bool initGui();
   void setStatus(Status newStatus);
   void waitIfPaused();
   void renderFrame();
   void swapResize(int width, int height, bool stereo, bool force);
+  void updateFrameContext();
+  void recordBundles(DrawBundles& bundles, BundlePipelines const& pipelines);
+  bool viewInstanced() const { return m_config.m_stereo && m_viewInstancingSupported; }
+  DrawBundles const& drawBundles() const { return viewInstanced() ? m_viewInstancedBundles : m_bundles; }
   void swapBuffers();
+  // Follows the swap chain to the output it is on, only with -vsyncprobe or just-in-time pacing
+  void openVsyncProbe();
+  void logFlash();
   bool sync();
   void end();
   void releasePresentBarrier();
 
-  void drawLines(ComPtr<ID3D12GraphicsCommandList> commandList, uint32_t offset = 0);
-  void drawSyncIndicator(ComPtr<ID3D12GraphicsCommandList> commandList);
-  void drawGui(ComPtr<ID3D12GraphicsCommandList> commandList);
-  void prepareGui();
+  LoadConstants loadConstants();
+  void drawLoad(ID3D12GraphicsCommandList* commandList);
+  void dispatchLoad(ID3D12GraphicsCommandList* commandList);
+  // Every frame slot has its own pattern buffer on the compute queue
+  ID3D12Resource* patternBuffer() const { return m_patternBuffers[m_computeQueue ? m_backBufferIndex : 0].Get(); }
+  void generatePattern(ID3D12GraphicsCommandList* commandList);
+  // Records and executes the compute work of the frame, the direct queue waits for its pattern
+  void submitCompute();
+  void drawLines(ID3D12GraphicsCommandList* commandList, uint32_t eye = 0);
+  void drawSyncIndicator(ID3D12GraphicsCommandList* commandList);
+  // False if the back buffer is too small for the marker or it is turned off
+  bool drawFrameMarker(ID3D12GraphicsCommandList* commandList);
+  std::uint32_t frameMarkerId() const { return m_config.m_frameMarkerId + m_config.m_windowIndex; }
+  void drawGui(ID3D12GraphicsCommandList* commandList);
+
+  bool collectGui();
+  void kickGui();
+  void discardGui();
+  void guiWorkerLoop();
+  bool recordGui(GuiSnapshot const& snapshot, UINT target);
 };
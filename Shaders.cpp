@@ -0,0 +1,74 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <Shaders.h>
+
+// Generated by the shader compiler into the build directory, every header defines a byte array g_<name>
+#include <shaders/gui_ps.h>
+#include <shaders/gui_ps_vi.h>
+#include <shaders/gui_vs.h>
+#include <shaders/gui_vs_vi.h>
+#include <shaders/indicator_vs.h>
+#include <shaders/indicator_vs_vi.h>
+#include <shaders/line_horizontal_vs.h>
+#include <shaders/line_horizontal_vs_vi.h>
+#include <shaders/line_vertical_vs.h>
+#include <shaders/line_vertical_vs_vi.h>
+#include <shaders/load_cs.h>
+#include <shaders/load_ps.h>
+#include <shaders/marker_ps.h>
+#include <shaders/pattern_cs.h>
+#include <shaders/pattern_vs.h>
+#include <shaders/pattern_vs_vi.h>
+#include <shaders/ps.h>
+#include <shaders/ps_vi.h>
+
+namespace {
+struct EmbeddedShader
+{
+  void const* m_data;
+  SIZE_T      m_size;
+  char const* m_name;
+};
+
+#define EMBEDDED_SHADER(name)                                                                                          \
+  {                                                                                                                    \
+    g_##name, sizeof(g_##name), #name                                                                                  \
+  }
+
+// In the order of Shader
+const EmbeddedShader EMBEDDED_SHADERS[] = {
+    EMBEDDED_SHADER(line_vertical_vs),
+    EMBEDDED_SHADER(line_horizontal_vs),
+    EMBEDDED_SHADER(indicator_vs),
+    EMBEDDED_SHADER(ps),
+    EMBEDDED_SHADER(gui_vs),
+    EMBEDDED_SHADER(gui_ps),
+    EMBEDDED_SHADER(load_ps),
+    EMBEDDED_SHADER(pattern_vs),
+    EMBEDDED_SHADER(pattern_cs),
+    EMBEDDED_SHADER(load_cs),
+    EMBEDDED_SHADER(marker_ps),
+    EMBEDDED_SHADER(line_vertical_vs_vi),
+    EMBEDDED_SHADER(line_horizontal_vs_vi),
+    EMBEDDED_SHADER(indicator_vs_vi),
+    EMBEDDED_SHADER(ps_vi),
+    EMBEDDED_SHADER(gui_vs_vi),
+    EMBEDDED_SHADER(gui_ps_vi),
+    EMBEDDED_SHADER(pattern_vs_vi),
+};
+static_assert(ARRAYSIZE(EMBEDDED_SHADERS) == static_cast<std::uint32_t>(Shader::COUNT), "Shader table is incomplete");
+
+#undef EMBEDDED_SHADER
+}  // namespace
+
+D3D12_SHADER_BYTECODE shaderBytecode(Shader shader)
+{
+  EmbeddedShader const& embedded = EMBEDDED_SHADERS[static_cast<std::uint32_t>(shader)];
+  return {embedded.m_data, embedded.m_size};
+}
+
+char const* shaderName(Shader shader)
+{
+  return EMBEDDED_SHADERS[static_cast<std::uint32_t>(shader)].m_name;
+}
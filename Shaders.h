@@ -0,0 +1,35 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <cstdint>
+#include <d3dx12.h>
+
+// Shader binaries embedded into the executable at build time, one per file in shaders/
+enum class Shader : std::uint32_t
+{
+  LINE_VERTICAL_VS,
+  LINE_HORIZONTAL_VS,
+  INDICATOR_VS,
+  PS,
+  GUI_VS,  // carries the serialized root signature of root_signature.hlsli
+  GUI_PS,
+  LOAD_PS,
+  PATTERN_VS,
+  PATTERN_CS,
+  LOAD_CS,
+  MARKER_PS,
+  // Shader model 6.1 variants for view instancing
+  LINE_VERTICAL_VS_VI,
+  LINE_HORIZONTAL_VS_VI,
+  INDICATOR_VS_VI,
+  PS_VI,
+  GUI_VS_VI,
+  GUI_PS_VI,
+  PATTERN_VS_VI,
+  COUNT,
+};
+
+D3D12_SHADER_BYTECODE shaderBytecode(Shader shader);
+char const*           shaderName(Shader shader);
@@ -0,0 +1,236 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <SoakMonitor.h>
+#include <Timing.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <psapi.h>
+#include <nvh/nvprint.hpp>
+
+namespace {
+char const* const TREND_NAMES[] = {"frame_time", "missed_refreshes", "gpu_memory", "handles", "working_set"};
+
+constexpr double BYTES_PER_MEGABYTE = 1024.0 * 1024.0;
+}  // namespace
+
+bool SoakTrend::update(double value, double tolerance)
+{
+  const bool wasRising = rising();
+  if(!m_valid)
+  {
+    m_valid = true;
+    m_max   = value;
+    return false;
+  }
+  if(value > m_max + tolerance)
+  {
+    ++m_risingSummaries;
+  }
+  else
+  {
+    m_risingSummaries = 0;
+  }
+  m_max = std::max(m_max, value);
+  return rising() && !wasRising;
+}
+
+bool SoakMonitor::open(std::string const& path, std::uint32_t intervalSeconds, std::uint64_t maxFileBytes,
+                       IDXGIAdapter3* adapter)
+{
+  close();
+  if(intervalSeconds == 0)
+  {
+    LOGE("Soak summary interval must be greater than 0.\n");
+    return false;
+  }
+  m_file.open(path, std::ios::out | std::ios::trunc);
+  if(!m_file.is_open())
+  {
+    LOGE("Could not open soak summary file '%s'.\n", path.c_str());
+    return false;
+  }
+
+  m_path         = path;
+  m_adapter      = adapter;
+  m_interval     = static_cast<std::int64_t>(intervalSeconds) * qpcFrequency();
+  m_maxFileBytes = maxFileBytes;
+  m_lastPresent  = 0;
+  m_dropped      = 0;
+  m_last         = {};
+  m_current      = {};
+  m_total        = {};
+  std::fill(std::begin(m_trends), std::end(m_trends), SoakTrend());
+  m_current.m_begin = qpcNow();
+  m_total.m_begin   = m_current.m_begin;
+  writeHeader();
+
+  m_stop   = false;
+  m_thread = std::thread([this]() { monitorLoop(); });
+  return true;
+}
+
+void SoakMonitor::close()
+{
+  if(!m_thread.joinable())
+  {
+    return;
+  }
+  m_stop = true;
+  m_thread.join();
+  m_file.close();
+  m_adapter.Reset();
+}
+
+void SoakMonitor::record(SoakSample const& sample)
+{
+  if(!m_samples.push(sample))
+  {
+    ++m_dropped;
+  }
+}
+
+void SoakMonitor::monitorLoop()
+{
+  for(;;)
+  {
+    // Everything recorded before the stop request still counts
+    const bool stop = m_stop;
+    SoakSample sample;
+    while(m_samples.pop(sample))
+    {
+      add(sample);
+    }
+    const std::int64_t now = qpcNow();
+    if(now - m_current.m_begin >= m_interval)
+    {
+      writeSummary("interval", m_current, now, true);
+      m_current         = {};
+      m_current.m_begin = now;
+    }
+    if(stop)
+    {
+      if(m_current.m_frames != 0)
+      {
+        writeSummary("interval", m_current, now, false);
+      }
+      writeSummary("total", m_total, now, false);
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+}
+
+void SoakMonitor::add(SoakSample const& sample)
+{
+  FrameRecord const& record      = sample.m_record;
+  Summary* const     summaries[] = {&m_current, &m_total};
+  m_last                         = sample;
+  if(record.m_flags & FRAME_RECORD_WAIT_TIMEOUT)
+  {
+    for(Summary* summary : summaries)
+    {
+      ++summary->m_timeouts;
+    }
+    return;
+  }
+
+  for(Summary* summary : summaries)
+  {
+    if(m_lastPresent != 0)
+    {
+      const double frameMillis = qpcToMillis(record.m_presentBegin - m_lastPresent);
+      summary->m_frameTimes.add(frameMillis);
+      summary->m_frameTimeSum += frameMillis;
+      summary->m_frameTimeMax = std::max(summary->m_frameTimeMax, frameMillis);
+      ++summary->m_frames;
+    }
+    if((record.m_flags & FRAME_RECORD_VSYNC) && (record.m_vsync.m_flags & VSYNC_SAMPLE_VBLANK))
+    {
+      summary->m_presentMargins.add(qpcToMillis(record.m_vsync.m_vblankTime - record.m_presentBegin));
+    }
+    summary->m_fenceWaits.add(record.m_fenceWaitEnd - record.m_fenceWaitBegin);
+  }
+  m_lastPresent = record.m_presentBegin;
+}
+
+void SoakMonitor::writeHeader()
+{
+  m_file << std::fixed << std::setprecision(2);
+  m_file << "scope,seconds,frames,timeouts,dropped_samples,frame_ms_mean,frame_ms_p50,frame_ms_p99,frame_ms_max,"
+            "margin_ms_p1,fence_wait_us_p50,fence_wait_us_p99,sync_loss_events,presents_out_of_sync,missed_refreshes,"
+            "swap_resizes,display_mode_changes,gpu_usage_mb,gpu_budget_mb,handles,gdi_objects,working_set_mb,drift\n";
+}
+
+void SoakMonitor::writeSummary(char const* scope, Summary const& summary, std::int64_t end, bool updateTrends)
+{
+  // Resource usage of the whole process, a leak shows up as a value that keeps growing between summaries
+  DXGI_QUERY_VIDEO_MEMORY_INFO videoMemory = {};
+  if(m_adapter)
+  {
+    m_adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &videoMemory);
+  }
+  const HANDLE            process = GetCurrentProcess();
+  DWORD                   handles = 0;
+  PROCESS_MEMORY_COUNTERS memory  = {};
+  GetProcessHandleCount(process, &handles);
+  GetProcessMemoryInfo(process, &memory, sizeof(memory));
+  const DWORD  gdiObjects    = GetGuiResources(process, GR_GDIOBJECTS);
+  const double gpuUsageMB    = videoMemory.CurrentUsage / BYTES_PER_MEGABYTE;
+  const double workingSetMB  = memory.WorkingSetSize / BYTES_PER_MEGABYTE;
+  const double frameTimeMean = summary.m_frames != 0 ? summary.m_frameTimeSum / summary.m_frames : 0.0;
+
+  std::string drift;
+  if(updateTrends && summary.m_frames != 0)
+  {
+    const double tolerances[TREND_COUNT] = {frameTimeMean * 0.01, 0.0, 1.0, 0.0, 1.0};
+    const double values[TREND_COUNT]     = {frameTimeMean, static_cast<double>(m_last.m_missedRefreshes), gpuUsageMB,
+                                            static_cast<double>(handles), workingSetMB};
+    for(std::uint32_t i = 0; i < TREND_COUNT; ++i)
+    {
+      if(m_trends[i].update(values[i], tolerances[i]))
+      {
+        LOGW("Soak: %s rose in %u summaries in a row, now %.2f.\n", TREND_NAMES[i], SOAK_TREND_SUMMARIES, values[i]);
+      }
+    }
+  }
+  for(std::uint32_t i = 0; i < TREND_COUNT; ++i)
+  {
+    if(m_trends[i].rising())
+    {
+      drift += drift.empty() ? TREND_NAMES[i] : std::string("|") + TREND_NAMES[i];
+    }
+  }
+
+  const double seconds = qpcToMillis(end - summary.m_begin) / 1000.0;
+  m_file << scope << ',' << seconds << ',' << summary.m_frames << ',' << summary.m_timeouts << ','
+         << m_dropped.load() << ',' << frameTimeMean << ',' << summary.m_frameTimes.percentile(0.5f) << ','
+         << summary.m_frameTimes.percentile(0.99f) << ',' << summary.m_frameTimeMax << ','
+         << summary.m_presentMargins.percentile(0.01f) << ',' << summary.m_fenceWaits.percentileMicros(0.5f) << ','
+         << summary.m_fenceWaits.percentileMicros(0.99f) << ',' << m_last.m_syncLossEvents << ','
+         << m_last.m_presentsOutOfSync << ',' << m_last.m_missedRefreshes << ',' << m_last.m_swapResizes << ','
+         << m_last.m_displayModeChanges << ',' << gpuUsageMB << ',' << videoMemory.Budget / BYTES_PER_MEGABYTE << ','
+         << handles << ',' << gdiObjects << ',' << workingSetMB << ',' << drift << '\n';
+  m_file.flush();
+
+  LOGI("Soak %s %.0f s: %llu frames, %.2f ms mean, p99 %.1f ms, %llu sync losses, %llu missed refreshes, GPU %.0f MB, "
+       "%lu handles%s%s\n",
+       scope, seconds, static_cast<unsigned long long>(summary.m_frames), frameTimeMean,
+       summary.m_frameTimes.percentile(0.99f), static_cast<unsigned long long>(m_last.m_syncLossEvents),
+       static_cast<unsigned long long>(m_last.m_missedRefreshes), gpuUsageMB, handles, drift.empty() ? "" : ", drift: ",
+       drift.c_str());
+
+  if(m_maxFileBytes != 0 && static_cast<std::uint64_t>(m_file.tellp()) >= m_maxFileBytes)
+  {
+    if(rotateFile(m_file, m_path, std::ios::out))
+    {
+      writeHeader();
+    }
+    else
+    {
+      m_maxFileBytes = 0;
+    }
+  }
+}
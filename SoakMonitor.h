@@ -0,0 +1,107 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <ClusterTelemetry.h>
+#include <ControlPlane.h>
+#include <FenceWaiter.h>
+#include <FrameRecorder.h>
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <dxgi1_4.h>
+#include <wrl/client.h>
+using Microsoft::WRL::ComPtr;
+
+// Soak runs leave nodes presenting for days. Frame records are aggregated into fixed-size histograms on a background
+// thread and written as one summary line every interval, together with GPU memory and process handle counts, so
+// memory stays bounded and slow drifts and leaks show up in a file that is small enough to read.
+
+// Summaries in a row a value has to rise in before it is reported as drifting
+constexpr std::uint32_t SOAK_TREND_SUMMARIES = 3;
+
+// A frame record and the render thread's state when it was recorded
+struct SoakSample
+{
+  FrameRecord   m_record;
+  std::uint64_t m_syncLossEvents     = 0;  // counters since start, see SyncMetrics
+  std::uint64_t m_presentsOutOfSync  = 0;
+  std::uint64_t m_missedRefreshes    = 0;  // RefreshCount minus PresentCount over all joined intervals
+  std::uint32_t m_swapResizes        = 0;
+  std::uint32_t m_displayModeChanges = 0;
+};
+
+// Detects a value that reaches a new maximum, by more than a tolerance, in several consecutive summaries
+class SoakTrend
+{
+public:
+  // True the first time the value rose SOAK_TREND_SUMMARIES summaries in a row
+  bool update(double value, double tolerance);
+  bool rising() const { return m_risingSummaries >= SOAK_TREND_SUMMARIES; }
+
+private:
+  double        m_max             = 0.0;
+  bool          m_valid           = false;
+  std::uint32_t m_risingSummaries = 0;
+};
+
+class SoakMonitor
+{
+public:
+  ~SoakMonitor() { close(); }
+
+  // Without an adapter no GPU memory is reported, a maxFileBytes of 0 never rotates the summary file
+  bool open(std::string const& path, std::uint32_t intervalSeconds, std::uint64_t maxFileBytes, IDXGIAdapter3* adapter);
+  // Writes the last, partial interval and a summary of the whole run
+  void close();
+  bool isOpen() const { return m_thread.joinable(); }
+
+  // Render thread only, never blocks; samples are dropped when the monitor thread falls behind
+  void record(SoakSample const& sample);
+
+private:
+  struct Summary
+  {
+    FrameTimeHistogram   m_frameTimes;
+    FrameTimeHistogram   m_presentMargins;  // present to the predicted vblank, only with -vsyncprobe
+    WakeLatencyHistogram m_fenceWaits;
+    std::uint64_t        m_frames       = 0;  // with a frame time, the first frame after open has none
+    std::uint64_t        m_timeouts     = 0;
+    double               m_frameTimeSum = 0.0;
+    double               m_frameTimeMax = 0.0;
+    std::int64_t         m_begin        = 0;
+  };
+  enum Trend
+  {
+    TREND_FRAME_TIME,
+    TREND_MISSED_REFRESHES,
+    TREND_GPU_MEMORY,
+    TREND_HANDLES,
+    TREND_WORKING_SET,
+    TREND_COUNT
+  };
+
+  SpscQueue<SoakSample, 256> m_samples;
+  std::atomic<std::uint64_t> m_dropped = 0;
+  std::atomic<bool>          m_stop    = false;
+  std::thread                m_thread;
+  std::ofstream              m_file;
+  std::string                m_path;
+  ComPtr<IDXGIAdapter3>      m_adapter;
+  std::int64_t               m_interval       = 0;  // in QPC ticks
+  std::uint64_t              m_maxFileBytes   = 0;
+  std::int64_t               m_lastPresent    = 0;
+  SoakSample                 m_last;  // most recent sample, for the counters since start
+  Summary                    m_current;
+  Summary                    m_total;
+  SoakTrend                  m_trends[TREND_COUNT];
+
+  void monitorLoop();
+  void add(SoakSample const& sample);
+  void writeHeader();
+  void writeSummary(char const* scope, Summary const& summary, std::int64_t end, bool updateTrends);
+};
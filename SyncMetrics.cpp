@@ -0,0 +1,115 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <SyncMetrics.h>
+
+int presentBarrierSyncLevel(NvU32 syncMode)
+{
+  switch(syncMode)
+  {
+    case PRESENT_BARRIER_SYNC_CLIENT:
+      return 1;
+    case PRESENT_BARRIER_SYNC_SYSTEM:
+      return 2;
+    case PRESENT_BARRIER_SYNC_CLUSTER:
+      return 3;
+    default:
+      return 0;
+  }
+}
+
+char const* presentBarrierSyncModeName(NvU32 syncMode)
+{
+  switch(syncMode)
+  {
+    case PRESENT_BARRIER_NOT_JOINED:
+      return "NOT_JOINED";
+    case PRESENT_BARRIER_SYNC_CLIENT:
+      return "SYNC_CLIENT";
+    case PRESENT_BARRIER_SYNC_SYSTEM:
+      return "SYNC_SYSTEM";
+    case PRESENT_BARRIER_SYNC_CLUSTER:
+      return "SYNC_CLUSTER";
+    default:
+      return "UNKNOWN";
+  }
+}
+
+void SyncMetrics::update(std::uint64_t                              frameIndex,
+                         bool                                       presentBarrierJoined,
+                         NV_PRESENT_BARRIER_FRAME_STATISTICS const& stats)
+{
+  const NvU32 syncMode = presentBarrierJoined ? stats.SyncMode : PRESENT_BARRIER_NOT_JOINED;
+  if(syncMode != m_syncMode)
+  {
+    // Leaving the present barrier on purpose is not a loss of sync
+    if(presentBarrierJoined && m_joined && presentBarrierSyncLevel(syncMode) < presentBarrierSyncLevel(m_syncMode))
+    {
+      ++m_syncLossEvents;
+    }
+    addTransition(frameIndex, syncMode);
+  }
+  m_joined = presentBarrierJoined;
+
+  if(!presentBarrierJoined)
+  {
+    m_valid = false;
+    return;
+  }
+
+  // The counters restart when the present barrier is joined again
+  if(!m_valid || stats.PresentCount < m_previous.PresentCount || stats.RefreshCount < m_previous.RefreshCount)
+  {
+    m_valid         = true;
+    m_previous      = stats;
+    m_intervalStart = stats;
+    m_intervalFrame = 0;
+    return;
+  }
+
+  const NvU32 presents       = stats.PresentCount - m_previous.PresentCount;
+  const NvU32 presentsInSync = stats.PresentInSyncCount - m_previous.PresentInSyncCount;
+  if(presentsInSync < presents)
+  {
+    m_presentsOutOfSync += presents - presentsInSync;
+  }
+  m_previous = stats;
+
+  if(++m_intervalFrame >= m_intervalFrames)
+  {
+    finishInterval(stats);
+    m_intervalStart = stats;
+    m_intervalFrame = 0;
+  }
+}
+
+void SyncMetrics::addTransition(std::uint64_t frameIndex, NvU32 syncMode)
+{
+  m_transitions[m_transitionCount % TRANSITIONS_SIZE] = {frameIndex, m_syncMode, syncMode};
+  ++m_transitionCount;
+  m_syncMode = syncMode;
+}
+
+void SyncMetrics::finishInterval(NV_PRESENT_BARRIER_FRAME_STATISTICS const& stats)
+{
+  const NvU32 presents       = stats.PresentCount - m_intervalStart.PresentCount;
+  const NvU32 refreshes      = stats.RefreshCount - m_intervalStart.RefreshCount;
+  const NvU32 presentsInSync = stats.PresentInSyncCount - m_intervalStart.PresentInSyncCount;
+  const NvU32 flipsInSync    = stats.FlipInSyncCount - m_intervalStart.FlipInSyncCount;
+
+  const float presentInSyncRatio = presents != 0 ? static_cast<float>(presentsInSync) / presents : 0.0f;
+  const float flipInSyncRatio    = presents != 0 ? static_cast<float>(flipsInSync) / presents : 0.0f;
+  // Every refresh without a new present showed the previous frame again
+  const NvU32 missedRefreshes = refreshes > presents ? refreshes - presents : 0;
+
+  m_presentInSyncRatios[m_historyIndex] = presentInSyncRatio;
+  m_flipInSyncRatios[m_historyIndex]    = flipInSyncRatio;
+  m_missedRefreshes[m_historyIndex]     = static_cast<float>(missedRefreshes);
+  m_historyIndex                        = (m_historyIndex + 1) % HISTORY_SIZE;
+
+  m_totalMissedRefreshes += missedRefreshes;
+  if(presentInSyncRatio < 1.0f || flipInSyncRatio < 1.0f || missedRefreshes != 0)
+  {
+    ++m_degradedIntervals;
+  }
+}
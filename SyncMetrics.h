@@ -0,0 +1,83 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <cstdint>
+
+#include <nvapi.h>
+
+// Readable name of a present barrier sync mode, "UNKNOWN" for unexpected values
+char const* presentBarrierSyncModeName(NvU32 syncMode);
+// Higher values mean tighter synchronization, 0 if not joined
+int presentBarrierSyncLevel(NvU32 syncMode);
+
+// Derives sync quality metrics from the cumulative present barrier frame statistics. Per-interval deltas are kept in
+// a rolling window of fixed size so they can be plotted directly.
+class SyncMetrics
+{
+public:
+  static constexpr std::uint32_t HISTORY_SIZE     = 120;
+  static constexpr std::uint32_t TRANSITIONS_SIZE = 8;
+
+  struct Transition
+  {
+    std::uint64_t m_frameIndex = 0;
+    NvU32         m_from       = PRESENT_BARRIER_NOT_JOINED;
+    NvU32         m_to         = PRESENT_BARRIER_NOT_JOINED;
+  };
+
+  void setInterval(std::uint32_t frames) { m_intervalFrames = frames != 0 ? frames : 1; }
+
+  // Called once per presented frame
+  void update(std::uint64_t frameIndex, bool presentBarrierJoined, NV_PRESENT_BARRIER_FRAME_STATISTICS const& stats);
+
+  // Rolling windows, oldest value at historyOffset()
+  float const*  presentInSyncRatios() const { return m_presentInSyncRatios; }
+  float const*  flipInSyncRatios() const { return m_flipInSyncRatios; }
+  float const*  missedRefreshes() const { return m_missedRefreshes; }
+  std::uint32_t historyOffset() const { return m_historyIndex; }
+
+  // Most recent sync mode transitions, newest first
+  std::uint32_t transitionCount() const
+  {
+    return static_cast<std::uint32_t>(m_transitionCount < TRANSITIONS_SIZE ? m_transitionCount : TRANSITIONS_SIZE);
+  }
+  Transition const& transition(std::uint32_t i) const
+  {
+    return m_transitions[(m_transitionCount - 1 - i) % TRANSITIONS_SIZE];
+  }
+
+  // Counters since start
+  std::uint64_t syncLossEvents() const { return m_syncLossEvents; }
+  std::uint64_t presentsOutOfSync() const { return m_presentsOutOfSync; }
+  std::uint64_t totalMissedRefreshes() const { return m_totalMissedRefreshes; }
+  std::uint64_t degradedIntervals() const { return m_degradedIntervals; }
+
+private:
+  std::uint32_t m_intervalFrames = 60;
+
+  // Statistics at the previous frame and at the beginning of the current interval
+  bool                                m_valid         = false;
+  bool                                m_joined        = false;
+  NV_PRESENT_BARRIER_FRAME_STATISTICS m_previous      = {};
+  NV_PRESENT_BARRIER_FRAME_STATISTICS m_intervalStart = {};
+  std::uint32_t                       m_intervalFrame = 0;
+  NvU32                               m_syncMode      = PRESENT_BARRIER_NOT_JOINED;
+
+  float         m_presentInSyncRatios[HISTORY_SIZE] = {};
+  float         m_flipInSyncRatios[HISTORY_SIZE]    = {};
+  float         m_missedRefreshes[HISTORY_SIZE]     = {};
+  std::uint32_t m_historyIndex                      = 0;
+
+  Transition    m_transitions[TRANSITIONS_SIZE] = {};
+  std::uint64_t m_transitionCount               = 0;
+
+  std::uint64_t m_syncLossEvents       = 0;
+  std::uint64_t m_presentsOutOfSync    = 0;
+  std::uint64_t m_totalMissedRefreshes = 0;
+  std::uint64_t m_degradedIntervals    = 0;
+
+  void addTransition(std::uint64_t frameIndex, NvU32 syncMode);
+  void finishInterval(NV_PRESENT_BARRIER_FRAME_STATISTICS const& stats);
+};
@@ -0,0 +1,169 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <SyncSampler.h>
+#include <Timing.h>
+
+#include <algorithm>
+#include <nvh/nvprint.hpp>
+
+NvU32 SyncSample::frameCountAt(std::int64_t time) const
+{
+  if(!m_quadroSyncValid || m_framePeriod == 0 || time <= m_frameCountTime)
+  {
+    return m_quadroSyncFrameCount;
+  }
+  return m_quadroSyncFrameCount + static_cast<NvU32>((time - m_frameCountTime) / m_framePeriod);
+}
+
+NvU32 SyncSampler::frameCountAt(std::int64_t time)
+{
+  SyncSample const& sample = m_samples.front();
+  const NvU32       count  = sample.frameCountAt(time);
+  m_lastFrameCount         = sample.m_frameCountEpoch == m_lastFrameEpoch ? std::max(m_lastFrameCount, count) : count;
+  m_lastFrameEpoch         = sample.m_frameCountEpoch;
+  return m_lastFrameCount;
+}
+
+bool SyncSampler::start(IUnknown* device, std::uint32_t intervalMicros)
+{
+  stop();
+  if(intervalMicros == 0)
+  {
+    return false;
+  }
+  m_lastFrameCount    = 0;
+  m_lastFrameEpoch    = 0;
+  bool highResolution = false;
+  m_timer             = createPreciseTimer(highResolution);
+  if(m_timer == NULL)
+  {
+    LOGE("Could not create the timer of the sync sampler, error %u.\n", GetLastError());
+    return false;
+  }
+
+  m_device          = device;
+  m_interval        = static_cast<std::int64_t>(intervalMicros) * qpcFrequency() / 1000000;
+  m_stop            = false;
+  m_resetFrameCount = false;
+  m_samples.reset(SyncSample());
+  m_thread = std::thread([this]() { sampleLoop(); });
+  return true;
+}
+
+void SyncSampler::stop()
+{
+  if(m_thread.joinable())
+  {
+    m_stop = true;
+    m_thread.join();
+  }
+  if(m_timer != NULL)
+  {
+    CloseHandle(m_timer);
+    m_timer = NULL;
+  }
+  m_device = nullptr;
+  std::lock_guard guard(m_clientMutex);
+  m_client = nullptr;
+}
+
+void SyncSampler::setPresentBarrierClient(NvPresentBarrierClientHandle client)
+{
+  std::lock_guard guard(m_clientMutex);
+  m_client = client;
+}
+
+void SyncSampler::sampleLoop()
+{
+  // Below the render thread, a late poll only makes the next sample a little older
+  SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+
+  SyncSample   sample;
+  bool         countValid      = false;
+  NvU32        previousCount   = 0;
+  std::int64_t previousTime    = 0;
+  NvU32        lastChangeCount = 0;
+  std::int64_t lastChangeTime  = 0;
+  std::int64_t nextPoll        = qpcNow();
+  while(!m_stop)
+  {
+    const std::int64_t begin = qpcNow();
+    {
+      std::lock_guard guard(m_clientMutex);
+      sample.m_presentBarrierStatsValid = false;
+      if(m_client != nullptr)
+      {
+        sample.m_presentBarrierStats.dwVersion = NV_PRESENT_BARRIER_FRAME_STATICS_VER1;
+        sample.m_presentBarrierStatsValid =
+            NvAPI_QueryPresentBarrierFrameStatistics(m_client, &sample.m_presentBarrierStats) == NVAPI_OK;
+      }
+    }
+
+    sample.m_quadroSyncValid = false;
+    if(m_quadroSync)
+    {
+      if(m_resetFrameCount.exchange(false))
+      {
+        NvAPI_D3D1x_ResetFrameCount(m_device);
+        countValid = false;
+      }
+      const std::int64_t queryBegin = qpcNow();
+      NvU32              count      = 0;
+      if(NvAPI_D3D1x_QueryFrameCount(m_device, &count) == NVAPI_OK)
+      {
+        const std::int64_t now = (queryBegin + qpcNow()) / 2;
+        if(!countValid || count < previousCount)
+        {
+          // First poll or the counter was reset, the period is measured again
+          sample.m_framePeriod = 0;
+          lastChangeTime       = 0;
+          ++sample.m_frameCountEpoch;
+        }
+        else if(count != previousCount)
+        {
+          // The count changed some time between the two polls
+          const std::int64_t changeTime = (previousTime + now) / 2;
+          if(lastChangeTime != 0)
+          {
+            const std::int64_t period = (changeTime - lastChangeTime) / (count - lastChangeCount);
+            sample.m_framePeriod =
+                sample.m_framePeriod == 0 ? period : sample.m_framePeriod + (period - sample.m_framePeriod) / 8;
+          }
+          lastChangeCount         = count;
+          lastChangeTime          = changeTime;
+          sample.m_frameCountTime = changeTime;
+        }
+        countValid                    = true;
+        previousCount                 = count;
+        previousTime                  = now;
+        sample.m_quadroSyncFrameCount = count;
+        // Until a change was observed, the count is only extrapolated once the period is known
+        sample.m_quadroSyncValid = true;
+      }
+      else
+      {
+        countValid = false;
+      }
+    }
+
+    sample.m_time = (begin + qpcNow()) / 2;
+    ++sample.m_sequence;
+    m_samples.publish(sample);
+
+    // Polls that are late are not caught up with
+    nextPoll += m_interval;
+    const std::int64_t remaining = nextPoll - qpcNow();
+    if(remaining <= 0)
+    {
+      nextPoll = qpcNow();
+      continue;
+    }
+    LARGE_INTEGER dueTime;
+    dueTime.QuadPart = -(remaining * 10000000 / qpcFrequency());  // relative, in 100 ns units
+    if(SetWaitableTimerEx(m_timer, &dueTime, 0, nullptr, nullptr, nullptr, 0))
+    {
+      WaitForSingleObject(m_timer, INFINITE);
+    }
+  }
+}
@@ -0,0 +1,78 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <windows.h>
+
+#include <nvapi.h>
+
+#include <ControlPlane.h>
+
+// One poll of the sampler thread, timestamps are raw QueryPerformanceCounter values
+struct SyncSample
+{
+  std::uint64_t                       m_sequence                 = 0;  // 0 until the first poll
+  std::int64_t                        m_time                     = 0;  // middle of the queries
+  bool                                m_presentBarrierStatsValid = false;
+  bool                                m_quadroSyncValid          = false;
+  NV_PRESENT_BARRIER_FRAME_STATISTICS m_presentBarrierStats      = {};
+  NvU32                               m_quadroSyncFrameCount     = 0;
+  std::int64_t                        m_frameCountTime           = 0;  // estimated time of the change to this count
+  std::int64_t                        m_framePeriod              = 0;  // between count changes, 0 until known
+  std::uint32_t                       m_frameCountEpoch          = 0;  // incremented whenever the count restarts
+
+  // The Quadro Sync frame count at the given time, extrapolated from the last observed change
+  NvU32 frameCountAt(std::int64_t time) const;
+};
+
+// Polls the present barrier statistics and the Quadro Sync frame counter at a fixed rate on a low priority thread,
+// so these driver calls are off the render thread's critical path. Samples are handed over in a triple buffer, the
+// render thread never waits for the sampler.
+class SyncSampler
+{
+public:
+  ~SyncSampler() { stop(); }
+
+  // The device is only used for the Quadro Sync frame counter
+  bool start(IUnknown* device, std::uint32_t intervalMicros);
+  void stop();
+  bool isRunning() const { return m_thread.joinable(); }
+
+  // Render thread. Waits for a poll in flight, so the client can be left or destroyed right after; only called when
+  // the present barrier is joined or left.
+  void setPresentBarrierClient(NvPresentBarrierClientHandle client);
+  void setQuadroSync(bool enabled) { m_quadroSync = enabled; }
+  // Executed with the next poll
+  void requestResetFrameCount() { m_resetFrameCount = true; }
+
+  // Render thread only, never blocks
+  SyncSample const& latest()
+  {
+    m_samples.fetch();
+    return m_samples.front();
+  }
+  // Render thread only, frameCountAt() of the latest sample. An extrapolation that ran ahead of the next measured
+  // count never makes the count go back, unless the counter restarted in between.
+  NvU32 frameCountAt(std::int64_t time);
+
+private:
+  TripleBuffer<SyncSample>     m_samples;
+  std::thread                  m_thread;
+  std::atomic<bool>            m_stop            = false;
+  std::atomic<bool>            m_quadroSync      = false;
+  std::atomic<bool>            m_resetFrameCount = false;
+  std::mutex                   m_clientMutex;
+  NvPresentBarrierClientHandle m_client          = nullptr;  // guarded by m_clientMutex
+  IUnknown*                    m_device          = nullptr;
+  HANDLE                       m_timer           = NULL;
+  std::int64_t                 m_interval        = 0;
+  NvU32                        m_lastFrameCount  = 0;  // render thread only
+  std::uint32_t                m_lastFrameEpoch  = 0;  // render thread only
+
+  void sampleLoop();
+};
@@ -0,0 +1,190 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <ThreadScheduling.h>
+#include <Timing.h>
+
+#include <avrt.h>
+#include <timeapi.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <nvh/nvprint.hpp>
+
+bool parseThreadPriority(std::string const& name, int& priority)
+{
+  if(name == "n" || name == "normal")
+  {
+    priority = THREAD_PRIORITY_NORMAL;
+  }
+  else if(name == "a" || name == "abovenormal")
+  {
+    priority = THREAD_PRIORITY_ABOVE_NORMAL;
+  }
+  else if(name == "h" || name == "highest")
+  {
+    priority = THREAD_PRIORITY_HIGHEST;
+  }
+  else if(name == "t" || name == "timecritical")
+  {
+    priority = THREAD_PRIORITY_TIME_CRITICAL;
+  }
+  else
+  {
+    return false;
+  }
+  return true;
+}
+
+char const* threadPriorityName(int priority)
+{
+  switch(priority)
+  {
+    case THREAD_PRIORITY_NORMAL:
+      return "normal";
+    case THREAD_PRIORITY_ABOVE_NORMAL:
+      return "above normal";
+    case THREAD_PRIORITY_HIGHEST:
+      return "highest";
+    case THREAD_PRIORITY_TIME_CRITICAL:
+      return "time critical";
+    default:
+      return "other";
+  }
+}
+
+bool parseAffinityMask(std::string const& text, std::uint64_t& mask)
+{
+  if(text.empty())
+  {
+    mask = 0;
+    return true;
+  }
+  char*              end   = nullptr;
+  unsigned long long value = std::strtoull(text.c_str(), &end, 16);
+  if(end == text.c_str() || *end != '\0')
+  {
+    return false;
+  }
+  mask = value;
+  return true;
+}
+
+void ThreadScheduling::apply(ThreadSchedulingSettings const& settings)
+{
+  revert();
+  m_applied     = {};
+  HANDLE thread = GetCurrentThread();
+
+  if(settings.m_affinityMask != 0)
+  {
+    m_priorAffinityMask = SetThreadAffinityMask(thread, static_cast<DWORD_PTR>(settings.m_affinityMask));
+    if(m_priorAffinityMask != 0)
+    {
+      m_applied.m_affinityMask = settings.m_affinityMask;
+    }
+    else
+    {
+      LOGW("Could not set the thread affinity mask to 0x%llx, error %u.\n",
+           static_cast<unsigned long long>(settings.m_affinityMask), GetLastError());
+    }
+  }
+
+  if(settings.m_priority != THREAD_PRIORITY_NORMAL)
+  {
+    const int priorPriority = GetThreadPriority(thread);
+    if(SetThreadPriority(thread, settings.m_priority))
+    {
+      m_applied.m_priority = settings.m_priority;
+      m_priorPriority      = priorPriority;
+    }
+    else
+    {
+      LOGW("Could not set the thread priority to %s, error %u.\n", threadPriorityName(settings.m_priority),
+           GetLastError());
+    }
+  }
+
+  // MMCSS boosts the thread into the realtime priority range for the share of CPU time the task is configured for
+  if(!settings.m_mmcssTask.empty())
+  {
+    DWORD taskIndex = 0;
+    m_mmcssHandle   = AvSetMmThreadCharacteristicsA(settings.m_mmcssTask.c_str(), &taskIndex);
+    if(m_mmcssHandle != NULL)
+    {
+      m_applied.m_mmcssTask = settings.m_mmcssTask;
+    }
+    else
+    {
+      LOGW("Could not register the thread with MMCSS task '%s', error %u.\n", settings.m_mmcssTask.c_str(),
+           GetLastError());
+    }
+  }
+
+  if(settings.m_timerResolutionMillis != 0)
+  {
+    TIMECAPS caps = {};
+    if(timeGetDevCaps(&caps, sizeof(caps)) == MMSYSERR_NOERROR)
+    {
+      const UINT resolution = std::clamp<UINT>(settings.m_timerResolutionMillis, caps.wPeriodMin, caps.wPeriodMax);
+      if(timeBeginPeriod(resolution) == TIMERR_NOERROR)
+      {
+        m_applied.m_timerResolutionMillis = resolution;
+      }
+    }
+    if(m_applied.m_timerResolutionMillis == 0)
+    {
+      LOGW("Could not set the timer resolution to %u ms.\n", settings.m_timerResolutionMillis);
+    }
+  }
+}
+
+void ThreadScheduling::revert()
+{
+  HANDLE thread = GetCurrentThread();
+  if(m_mmcssHandle != NULL)
+  {
+    AvRevertMmThreadCharacteristics(m_mmcssHandle);
+    m_mmcssHandle         = NULL;
+    m_applied.m_mmcssTask = "";
+  }
+  if(m_applied.m_timerResolutionMillis != 0)
+  {
+    timeEndPeriod(m_applied.m_timerResolutionMillis);
+    m_applied.m_timerResolutionMillis = 0;
+  }
+  if(m_priorPriority != THREAD_PRIORITY_ERROR_RETURN)
+  {
+    SetThreadPriority(thread, m_priorPriority);
+    m_priorPriority      = THREAD_PRIORITY_ERROR_RETURN;
+    m_applied.m_priority = THREAD_PRIORITY_NORMAL;
+  }
+  if(m_priorAffinityMask != 0)
+  {
+    SetThreadAffinityMask(thread, m_priorAffinityMask);
+    m_priorAffinityMask      = 0;
+    m_applied.m_affinityMask = 0;
+  }
+}
+
+void WakeLatency::add(std::int64_t ticks)
+{
+  m_sum += ticks;
+  m_max = std::max(m_max, ticks);
+  ++m_count;
+
+  const std::int64_t now = qpcNow();
+  if(m_windowStart == 0)
+  {
+    m_windowStart = now;
+  }
+  else if(now - m_windowStart >= qpcFrequency())
+  {
+    m_meanMicros  = static_cast<float>(qpcToMillis(m_sum) * 1000.0 / m_count);
+    m_maxMicros   = static_cast<float>(qpcToMillis(m_max) * 1000.0);
+    m_windowStart = now;
+    m_sum         = 0;
+    m_max         = 0;
+    m_count       = 0;
+  }
+}
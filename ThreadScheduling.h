@@ -0,0 +1,62 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <windows.h>
+
+struct ThreadSchedulingSettings
+{
+  std::uint64_t m_affinityMask          = 0;  // logical processors of the thread's processor group, 0 keeps the default
+  int           m_priority              = THREAD_PRIORITY_NORMAL;
+  std::string   m_mmcssTask             = "";  // e.g. "Games" or "Pro Audio", empty to not register with MMCSS
+  std::uint32_t m_timerResolutionMillis = 0;   // system timer resolution, 0 keeps the default
+};
+
+bool        parseThreadPriority(std::string const& name, int& priority);
+char const* threadPriorityName(int priority);
+// Accepts hexadecimal masks with or without 0x prefix, an empty string is the default mask 0
+bool parseAffinityMask(std::string const& text, std::uint64_t& mask);
+
+// Applies scheduling settings to the calling thread. revert() restores the previous affinity mask and priority and
+// undoes the MMCSS registration and the timer resolution, it has to be called from the same thread.
+class ThreadScheduling
+{
+public:
+  ~ThreadScheduling() { revert(); }
+
+  // Failures are logged and leave the respective setting at its default
+  void apply(ThreadSchedulingSettings const& settings);
+  void revert();
+
+  // What was actually applied
+  ThreadSchedulingSettings const& applied() const { return m_applied; }
+
+private:
+  ThreadSchedulingSettings m_applied;
+  HANDLE                   m_mmcssHandle       = NULL;
+  DWORD_PTR                m_priorAffinityMask = 0;  // 0 while the affinity mask was not changed
+  int                      m_priorPriority     = THREAD_PRIORITY_ERROR_RETURN;  // while the priority was not changed
+};
+
+// How late a thread runs after the event it waited for became ready: the due time of a timer or Sleep(), or the GPU
+// completion of a fence. Samples are aggregated over windows of about a second, the reported values are those of the
+// last complete window.
+class WakeLatency
+{
+public:
+  void add(std::int64_t ticks);
+
+  float meanMicros() const { return m_meanMicros; }
+  float maxMicros() const { return m_maxMicros; }
+
+private:
+  std::int64_t  m_windowStart = 0;
+  std::int64_t  m_sum         = 0;
+  std::int64_t  m_max         = 0;
+  std::uint32_t m_count       = 0;
+  float         m_meanMicros  = 0.0f;
+  float         m_maxMicros   = 0.0f;
+};
@@ -0,0 +1,58 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <cstdint>
+#include <windows.h>
+
+// Raw QueryPerformanceCounter ticks are used for all CPU side timestamps so they can be correlated with DXGI and
+// D3D12 clock calibration values.
+inline std::int64_t qpcNow()
+{
+  LARGE_INTEGER counter;
+  QueryPerformanceCounter(&counter);
+  return counter.QuadPart;
+}
+
+inline std::int64_t qpcFrequency()
+{
+  static const std::int64_t frequency = []() {
+    LARGE_INTEGER f;
+    QueryPerformanceFrequency(&f);
+    return f.QuadPart;
+  }();
+  return frequency;
+}
+
+inline double qpcToMillis(std::int64_t ticks)
+{
+  return static_cast<double>(ticks) * 1000.0 / static_cast<double>(qpcFrequency());
+}
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+// Waitable timer for relative due times. High resolution timers are only available since Windows 10 1803, regular
+// ones may fire up to a scheduler quantum late. NULL if no timer could be created, see GetLastError().
+inline HANDLE createPreciseTimer(bool& highResolution)
+{
+  HANDLE timer   = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+  highResolution = timer != NULL;
+  if(timer == NULL)
+  {
+    timer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+  }
+  return timer;
+}
+
+// UTC wall clock in 100 ns units (FILETIME), only comparable between nodes whose clocks are synchronized, e.g. with PTP
+constexpr std::int64_t SYSTEM_TIME_FREQUENCY = 10000000;
+
+inline std::uint64_t systemTimeNow()
+{
+  FILETIME now;
+  GetSystemTimePreciseAsFileTime(&now);
+  return (static_cast<std::uint64_t>(now.dwHighDateTime) << 32) | now.dwLowDateTime;
+}
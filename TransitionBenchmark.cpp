@@ -0,0 +1,216 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <Benchmark.h>
+#include <SyncMetrics.h>
+#include <Timing.h>
+#include <TransitionBenchmark.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <nvh/nvprint.hpp>
+
+char const* transitionKindName(TransitionKind kind)
+{
+  switch(kind)
+  {
+    case TransitionKind::FULLSCREEN:
+      return "fullscreen";
+    case TransitionKind::BORDERLESS:
+      return "borderless";
+    case TransitionKind::WIN_KEY:
+      return "winkey";
+    case TransitionKind::STEREO:
+      return "stereo";
+    case TransitionKind::PRESENT_BARRIER:
+      return "presentbarrier";
+    default:
+      return "unknown";
+  }
+}
+
+bool parseTransitionKinds(std::string const& letters, std::vector<TransitionKind>& kinds)
+{
+  kinds.clear();
+  for(char letter : letters)
+  {
+    switch(letter)
+    {
+      case 'f':
+        kinds.push_back(TransitionKind::FULLSCREEN);
+        break;
+      case 'b':
+        kinds.push_back(TransitionKind::BORDERLESS);
+        break;
+      case 'w':
+        kinds.push_back(TransitionKind::WIN_KEY);
+        break;
+      case 's':
+        kinds.push_back(TransitionKind::STEREO);
+        break;
+      case 'p':
+        kinds.push_back(TransitionKind::PRESENT_BARRIER);
+        break;
+      default:
+        return false;
+    }
+  }
+  return !kinds.empty();
+}
+
+bool TransitionBenchmark::init(std::vector<TransitionKind> const& kinds, std::uint32_t trialsPerKind,
+                               std::uint32_t settleFrames, std::string const& reportPath)
+{
+  if(kinds.empty() || trialsPerKind == 0 || reportPath.empty())
+  {
+    return false;
+  }
+  m_kinds        = kinds;
+  m_trials       = trialsPerKind;
+  m_settleFrames = std::max<std::uint32_t>(settleFrames, 1);
+  m_reportPath   = reportPath;
+  m_trial        = 0;
+  m_running      = true;
+  m_finished     = false;
+  for(auto& samples : m_samples)
+  {
+    samples.clear();
+  }
+  enterPhase(Phase::SETTLE);
+  LOGI("Transition benchmark: %u trials of %zu kinds.\n", m_trials, m_kinds.size());
+  return true;
+}
+
+std::optional<TransitionBenchmark::Step> TransitionBenchmark::update(NvU32 syncMode, bool transitionIdle)
+{
+  if(!m_running)
+  {
+    return {};
+  }
+
+  ++m_phaseFrames;
+  if(syncMode != m_lastSyncMode || !transitionIdle)
+  {
+    m_stableFrames = 0;
+    m_lastSyncMode = syncMode;
+  }
+  else
+  {
+    ++m_stableFrames;
+  }
+  const double phaseMillis = qpcToMillis(qpcNow() - m_phaseStart);
+  const bool   settled     = m_stableFrames >= m_settleFrames || phaseMillis > BENCHMARK_PHASE_TIMEOUT_MILLIS;
+  const Step   step        = {m_kinds[m_trial % m_kinds.size()], false};
+
+  switch(m_phase)
+  {
+    case Phase::SETTLE:
+      if(!settled)
+      {
+        return {};
+      }
+      if(m_trial == m_trials * m_kinds.size())
+      {
+        finish();
+        return {};
+      }
+      m_priorSyncMode = syncMode;
+      enterPhase(Phase::OUT);
+      return step;
+    case Phase::OUT:
+      if(!settled)
+      {
+        return {};
+      }
+      enterPhase(Phase::MEASURE);
+      return Step{step.m_kind, true};
+    case Phase::MEASURE:
+    {
+      const bool resynced = presentBarrierSyncLevel(syncMode) >= presentBarrierSyncLevel(m_priorSyncMode);
+      if(!resynced && phaseMillis <= BENCHMARK_PHASE_TIMEOUT_MILLIS)
+      {
+        return {};
+      }
+      const Sample sample = {static_cast<float>(phaseMillis), m_phaseFrames, resynced};
+      m_samples[static_cast<std::uint32_t>(step.m_kind)].push_back(sample);
+      if(!resynced)
+      {
+        LOGW("Transition benchmark: %s trial %u did not return to %s.\n", transitionKindName(step.m_kind),
+             m_trial / static_cast<std::uint32_t>(m_kinds.size()), presentBarrierSyncModeName(m_priorSyncMode));
+      }
+      ++m_trial;
+      enterPhase(Phase::SETTLE);
+      return {};
+    }
+  }
+  return {};
+}
+
+void TransitionBenchmark::enterPhase(Phase phase)
+{
+  m_phase        = phase;
+  m_phaseStart   = qpcNow();
+  m_phaseFrames  = 0;
+  m_stableFrames = 0;
+}
+
+void TransitionBenchmark::finish()
+{
+  m_running  = false;
+  m_finished = true;
+  if(writeReport())
+  {
+    LOGI("Transition benchmark report written to %s.\n", m_reportPath.c_str());
+  }
+  else
+  {
+    LOGE("Could not write the transition benchmark report to %s.\n", m_reportPath.c_str());
+  }
+}
+
+bool TransitionBenchmark::writeReport() const
+{
+  std::ofstream file(m_reportPath, std::ios::out | std::ios::trunc);
+  if(!file)
+  {
+    return false;
+  }
+
+  // Statistics only cover the trials that resynced, the others are counted separately
+  file << std::fixed << std::setprecision(3);
+  file << "{\n  \"trialsPerKind\": " << m_trials << ",\n  \"settleFrames\": " << m_settleFrames
+       << ",\n  \"transitions\": [";
+  char const* separator = "";
+  for(std::uint32_t k = 0; k < static_cast<std::uint32_t>(TransitionKind::COUNT); ++k)
+  {
+    std::vector<Sample> const& samples = m_samples[k];
+    if(samples.empty())
+    {
+      continue;
+    }
+    std::vector<float>         millis;
+    std::vector<std::uint32_t> frames;
+    for(Sample const& sample : samples)
+    {
+      if(sample.m_resynced)
+      {
+        millis.push_back(sample.m_millis);
+        frames.push_back(sample.m_frames);
+      }
+    }
+    char const* name = transitionKindName(static_cast<TransitionKind>(k));
+    file << separator << "\n    {\"kind\": \"" << name << "\", \"trials\": " << samples.size()
+         << ", \"resynced\": " << millis.size() << ", \"millis\": {\"min\": " << percentile(millis, 0.0f)
+         << ", \"median\": " << percentile(millis, 0.5f) << ", \"p99\": " << percentile(millis, 0.99f)
+         << "}, \"frames\": {\"min\": " << percentile(frames, 0.0f) << ", \"median\": " << percentile(frames, 0.5f)
+         << ", \"p99\": " << percentile(frames, 0.99f) << "}}";
+    separator = ",";
+
+    LOGI("%-16s %zu/%zu resynced, ms min %.1f median %.1f p99 %.1f, frames min %u median %u p99 %u\n", name,
+         millis.size(), samples.size(), percentile(millis, 0.0f), percentile(millis, 0.5f), percentile(millis, 0.99f),
+         percentile(frames, 0.0f), percentile(frames, 0.5f), percentile(frames, 0.99f));
+  }
+  file << "\n  ]\n}\n";
+  return static_cast<bool>(file);
+}
@@ -0,0 +1,80 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <nvapi.h>
+
+enum class TransitionKind : std::uint32_t
+{
+  FULLSCREEN,       // to fullscreen and back, or to windowed and back if started in fullscreen
+  BORDERLESS,       // to borderless and back, or to windowed and back if started borderless
+  WIN_KEY,          // Windows key presses that open and close the start menu over the window
+  STEREO,           // stereo toggles
+  PRESENT_BARRIER,  // present barrier leave and re-join
+  COUNT,
+};
+
+char const* transitionKindName(TransitionKind kind);
+// A string of kind letters: (f)ullscreen, (b)orderless, (w)indows key, (s)tereo, (p)resent barrier
+bool parseTransitionKinds(std::string const& letters, std::vector<TransitionKind>& kinds);
+
+// Scripted transitions for qualifying drivers. Every trial goes to another mode, waits until the sync mode settled and
+// goes back. It measures the time and frames from the request to go back until the present barrier sync mode is at
+// least at the level it had before the trial. Runs on the render thread, which executes the requested steps.
+class TransitionBenchmark
+{
+public:
+  struct Step
+  {
+    TransitionKind m_kind = TransitionKind::FULLSCREEN;
+    bool           m_back = false;  // return to the mode the trial started in
+  };
+
+  bool init(std::vector<TransitionKind> const& kinds, std::uint32_t trialsPerKind, std::uint32_t settleFrames,
+            std::string const& reportPath);
+  bool isRunning() const { return m_running; }
+  bool isFinished() const { return m_finished; }
+
+  // Once per presented frame, returns the step to execute with this frame if there is one
+  std::optional<Step> update(NvU32 syncMode, bool transitionIdle);
+
+private:
+  enum class Phase
+  {
+    SETTLE,   // before a trial
+    OUT,      // in the other mode
+    MEASURE,  // going back
+  };
+  struct Sample
+  {
+    float         m_millis   = 0.0f;
+    std::uint32_t m_frames   = 0;
+    bool          m_resynced = false;  // false if the sync level was not reached within the timeout
+  };
+
+  std::vector<TransitionKind> m_kinds;
+  std::vector<Sample>         m_samples[static_cast<std::uint32_t>(TransitionKind::COUNT)];
+  std::uint32_t               m_trials       = 0;
+  std::uint32_t               m_settleFrames = 120;
+  std::string                 m_reportPath;
+  bool                        m_running  = false;
+  bool                        m_finished = false;
+
+  Phase         m_phase         = Phase::SETTLE;
+  std::uint32_t m_trial         = 0;
+  std::int64_t  m_phaseStart    = 0;
+  std::uint32_t m_phaseFrames   = 0;
+  std::uint32_t m_stableFrames  = 0;
+  NvU32         m_lastSyncMode  = PRESENT_BARRIER_NOT_JOINED;
+  NvU32         m_priorSyncMode = PRESENT_BARRIER_NOT_JOINED;
+
+  void enterPhase(Phase phase);
+  void finish();
+  bool writeReport() const;
+};
@@ -0,0 +1,45 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <UdpSocket.h>
+
+#include <nvh/nvprint.hpp>
+
+bool startupWinsock()
+{
+  WSADATA wsaData;
+  int     result = WSAStartup(MAKEWORD(2, 2), &wsaData);
+  if(result != 0)
+  {
+    LOGE("WSAStartup() failed with error %d.\n", result);
+    return false;
+  }
+  return true;
+}
+
+bool openUdpSocket(std::uintptr_t& udpSocket)
+{
+  if(!startupWinsock())
+  {
+    return false;
+  }
+  SOCKET newSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if(newSocket == INVALID_SOCKET)
+  {
+    LOGE("Could not create UDP socket, error %d.\n", WSAGetLastError());
+    WSACleanup();
+    return false;
+  }
+  udpSocket = newSocket;
+  return true;
+}
+
+void closeSocket(std::uintptr_t& udpSocket)
+{
+  if(udpSocket != INVALID_SOCKET)
+  {
+    closesocket(static_cast<SOCKET>(udpSocket));
+    udpSocket = INVALID_SOCKET;
+    WSACleanup();
+  }
+}
@@ -0,0 +1,18 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+// Winsock helpers of the telemetry and flash trigger sockets. Has to be included before windows.h, which must not
+// pull in the old winsock.h first.
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+#include <cstdint>
+
+// Every successful call has to be balanced by WSACleanup(), closeSocket() does that for an open socket
+bool startupWinsock();
+// Creates a UDP socket after starting Winsock, Winsock is cleaned up again if that fails
+bool openUdpSocket(std::uintptr_t& udpSocket);
+// Closes the socket and cleans up its Winsock reference, nothing happens for INVALID_SOCKET
+void closeSocket(std::uintptr_t& udpSocket);
@@ -0,0 +1,73 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <UploadRing.h>
+
+#include <cstring>
+#include <nvdx12/error_dx12.hpp>
+#include <nvh/nvprint.hpp>
+
+bool UploadRing::init(ID3D12Device* device, UINT frameSlots, UINT64 bytesPerSlot)
+{
+  deinit();
+  if(frameSlots == 0 || bytesPerSlot == 0)
+  {
+    return false;
+  }
+
+  // Slots start at constant buffer alignment, so the first allocation of every slot is aligned as well
+  const UINT64 alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
+  m_bytesPerSlot         = (bytesPerSlot + alignment - 1) & ~(alignment - 1);
+
+  CD3DX12_HEAP_PROPERTIES uploadHeapProps(D3D12_HEAP_TYPE_UPLOAD);
+  CD3DX12_RESOURCE_DESC   bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(m_bytesPerSlot * frameSlots);
+  HR_CHECK(device->CreateCommittedResource(&uploadHeapProps, D3D12_HEAP_FLAG_NONE, &bufferDesc,
+                                           D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&m_buffer)));
+  m_buffer->SetName(L"upload_ring");
+
+  // Upload heaps are write-combined, mapped once and only ever written sequentially by the CPU
+  const CD3DX12_RANGE noRead(0, 0);
+  void*               mapped = nullptr;
+  HR_CHECK(m_buffer->Map(0, &noRead, &mapped));
+  m_mapped     = static_cast<std::uint8_t*>(mapped);
+  m_gpuAddress = m_buffer->GetGPUVirtualAddress();
+  m_slotBegin  = 0;
+  m_offset     = 0;
+  m_overflowed = false;
+  return true;
+}
+
+void UploadRing::deinit()
+{
+  if(m_buffer && m_mapped)
+  {
+    m_buffer->Unmap(0, nullptr);
+  }
+  m_mapped     = nullptr;
+  m_gpuAddress = 0;
+  m_buffer.Reset();
+}
+
+void UploadRing::beginFrame(UINT frameSlot)
+{
+  m_slotBegin = frameSlot * m_bytesPerSlot;
+  m_offset    = 0;
+}
+
+D3D12_GPU_VIRTUAL_ADDRESS UploadRing::push(void const* data, UINT64 size, UINT64 alignment)
+{
+  const UINT64 offset = (m_offset + alignment - 1) & ~(alignment - 1);
+  if(offset + size > m_bytesPerSlot)
+  {
+    // Sized for the worst case at init, so this is a bug; the draws read stale constants instead of faulting
+    if(!m_overflowed)
+    {
+      LOGE("Upload ring slot of %llu bytes is full.\n", static_cast<unsigned long long>(m_bytesPerSlot));
+      m_overflowed = true;
+    }
+    return m_gpuAddress + m_slotBegin;
+  }
+  std::memcpy(m_mapped + m_slotBegin + offset, data, size);
+  m_offset = offset + size;
+  return m_gpuAddress + m_slotBegin + offset;
+}
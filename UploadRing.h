@@ -0,0 +1,44 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <cstdint>
+#include <d3dx12.h>
+#include <wrl/client.h>
+using Microsoft::WRL::ComPtr;
+
+// Per-frame constants and instance data in one persistently mapped upload buffer. Every frame slot (one per back
+// buffer) owns a fixed range that is suballocated by bumping an offset, so the hot path neither allocates nor maps.
+// A slot is only reset once the GPU finished the frame that last used it, which the caller guarantees by waiting for
+// the slot's command allocator first.
+class UploadRing
+{
+public:
+  ~UploadRing() { deinit(); }
+
+  bool init(ID3D12Device* device, UINT frameSlots, UINT64 bytesPerSlot);
+  void deinit();
+
+  // Starts suballocating the slot's range again, the previous frame in this slot must be complete
+  void beginFrame(UINT frameSlot);
+
+  // Copies the data into the current slot and returns its GPU address, aligned for root constant buffer views by
+  // default. Returns the start of the slot when it is full.
+  D3D12_GPU_VIRTUAL_ADDRESS push(void const* data, UINT64 size,
+                                 UINT64 alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+  template <typename T>
+  D3D12_GPU_VIRTUAL_ADDRESS push(T const& value)
+  {
+    return push(&value, sizeof(T));
+  }
+
+private:
+  ComPtr<ID3D12Resource>    m_buffer;
+  std::uint8_t*             m_mapped       = nullptr;
+  D3D12_GPU_VIRTUAL_ADDRESS m_gpuAddress   = 0;
+  UINT64                    m_bytesPerSlot = 0;
+  UINT64                    m_slotBegin    = 0;
+  UINT64                    m_offset       = 0;  // relative to the slot
+  bool                      m_overflowed   = false;
+};
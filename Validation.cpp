@@ -0,0 +1,137 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <SyncMetrics.h>
+#include <Timing.h>
+#include <Validation.h>
+
+#include <cmath>
+#include <nvh/nvprint.hpp>
+
+bool parseMinimalContent(std::string const& name, MinimalContent& content)
+{
+  if(name.empty())
+  {
+    content = MinimalContent::NONE;
+  }
+  else if(name == "c" || name == "cleared")
+  {
+    content = MinimalContent::CLEARED;
+  }
+  else if(name == "i" || name == "indicator")
+  {
+    content = MinimalContent::INDICATOR;
+  }
+  else
+  {
+    return false;
+  }
+  return true;
+}
+
+bool parseSyncMode(std::string const& name, NvU32& syncMode)
+{
+  if(name == "client")
+  {
+    syncMode = PRESENT_BARRIER_SYNC_CLIENT;
+  }
+  else if(name == "system")
+  {
+    syncMode = PRESENT_BARRIER_SYNC_SYSTEM;
+  }
+  else if(name == "cluster")
+  {
+    syncMode = PRESENT_BARRIER_SYNC_CLUSTER;
+  }
+  else
+  {
+    return false;
+  }
+  return true;
+}
+
+bool ValidationRun::init(std::uint32_t frames, float seconds, NvU32 requiredSyncMode)
+{
+  if(frames == 0 && seconds <= 0.0f)
+  {
+    return false;
+  }
+  m_frameLimit       = frames;
+  m_timeLimit        = seconds > 0.0f ? static_cast<std::int64_t>(std::ceil(seconds * qpcFrequency())) : 0;
+  m_requiredSyncMode = requiredSyncMode;
+  m_running          = true;
+  m_finished         = false;
+  m_exitCode         = VALIDATION_PASSED;
+  m_start            = 0;
+  m_frames           = 0;
+  m_syncedFrames     = 0;
+  m_reachedFrame     = 0;
+  m_reachedTime      = 0;
+  m_lastSyncMode     = PRESENT_BARRIER_NOT_JOINED;
+  return true;
+}
+
+void ValidationRun::update(NvU32 syncMode, SyncMetrics const& metrics)
+{
+  if(!m_running)
+  {
+    return;
+  }
+
+  // The run starts with the first presented frame, not with the startup
+  const std::int64_t now = qpcNow();
+  if(m_start == 0)
+  {
+    m_start = now;
+  }
+  ++m_frames;
+  m_lastSyncMode = syncMode;
+  if(presentBarrierSyncLevel(syncMode) >= presentBarrierSyncLevel(m_requiredSyncMode))
+  {
+    ++m_syncedFrames;
+    if(m_reachedTime == 0)
+    {
+      m_reachedTime  = now;
+      m_reachedFrame = m_frames;
+    }
+  }
+
+  if((m_frameLimit != 0 && m_frames >= m_frameLimit) || (m_timeLimit != 0 && now - m_start >= m_timeLimit))
+  {
+    finish(metrics);
+  }
+}
+
+void ValidationRun::finish(SyncMetrics const& metrics)
+{
+  if(!m_running)
+  {
+    return;
+  }
+  m_running  = false;
+  m_finished = true;
+
+  const bool reached = m_reachedTime != 0;
+  const bool inSync  = presentBarrierSyncLevel(m_lastSyncMode) >= presentBarrierSyncLevel(m_requiredSyncMode);
+  m_exitCode         = !reached ? VALIDATION_NOT_REACHED : (inSync ? VALIDATION_PASSED : VALIDATION_NOT_IN_SYNC_END);
+
+  const double seconds = m_start != 0 ? qpcToMillis(qpcNow() - m_start) / 1000.0 : 0.0;
+  const char*  result  = m_exitCode == VALIDATION_PASSED ? "passed" : "FAILED";
+  LOGI("Validation %s: %u frames in %.1f s, final sync mode %s\n", result, m_frames, seconds,
+       presentBarrierSyncModeName(m_lastSyncMode));
+  if(reached)
+  {
+    const std::uint32_t sinceReached = m_frames - m_reachedFrame + 1;
+    LOGI("  %s reached after %.1f ms (frame %u), %.1f%% of the frames since at or above it\n",
+         presentBarrierSyncModeName(m_requiredSyncMode), qpcToMillis(m_reachedTime - m_start), m_reachedFrame,
+         100.0 * m_syncedFrames / sinceReached);
+  }
+  else
+  {
+    LOGI("  %s never reached\n", presentBarrierSyncModeName(m_requiredSyncMode));
+  }
+  LOGI("  %llu sync losses, %llu presents out of sync, %llu missed refreshes\n",
+       static_cast<unsigned long long>(metrics.syncLossEvents()),
+       static_cast<unsigned long long>(metrics.presentsOutOfSync()),
+       static_cast<unsigned long long>(metrics.totalMissedRefreshes()));
+}
@@ -0,0 +1,62 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <nvapi.h>
+
+class SyncMetrics;
+
+// What a minimal run renders instead of the lines and the gui
+enum class MinimalContent
+{
+  NONE,       // everything as usual
+  CLEARED,    // cleared back buffers only
+  INDICATOR,  // the present barrier indicator bar only
+};
+
+// (c)leared or (i)ndicator, an empty name is NONE
+bool parseMinimalContent(std::string const& name, MinimalContent& content);
+// client, system, or cluster
+bool parseSyncMode(std::string const& name, NvU32& syncMode);
+
+// Exit codes of a validation run, initialization failures exit with EXIT_FAILURE
+constexpr int VALIDATION_PASSED          = 0;
+constexpr int VALIDATION_NOT_REACHED     = 2;  // the required sync mode was never reached
+constexpr int VALIDATION_NOT_IN_SYNC_END = 3;  // reached, but not held until the end of the run
+
+// Scripted validation for cluster bring-up: runs for a number of frames or seconds, checks that the present barrier
+// reaches a required sync mode, logs a summary and tells the window to close. Runs on the render thread.
+class ValidationRun
+{
+public:
+  // Either limit may be zero, the run ends with whichever is reached first
+  bool init(std::uint32_t frames, float seconds, NvU32 requiredSyncMode);
+  bool isRunning() const { return m_running; }
+  bool isFinished() const { return m_finished; }
+
+  // Once per presented frame
+  void update(NvU32 syncMode, SyncMetrics const& metrics);
+  // Ends a run that is interrupted before its limit, e.g. by closing the window
+  void finish(SyncMetrics const& metrics);
+
+  int exitCode() const { return m_exitCode; }
+
+private:
+  std::uint32_t m_frameLimit       = 0;
+  std::int64_t  m_timeLimit        = 0;
+  NvU32         m_requiredSyncMode = PRESENT_BARRIER_SYNC_CLUSTER;
+  bool          m_running          = false;
+  bool          m_finished         = false;
+  int           m_exitCode         = VALIDATION_PASSED;
+
+  std::int64_t  m_start        = 0;
+  std::uint32_t m_frames       = 0;
+  std::uint32_t m_syncedFrames = 0;  // at or above the required sync mode
+  std::uint32_t m_reachedFrame = 0;
+  std::int64_t  m_reachedTime  = 0;  // 0 until the required sync mode was reached
+  NvU32         m_lastSyncMode = PRESENT_BARRIER_NOT_JOINED;
+};
@@ -0,0 +1,206 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <Timing.h>
+#include <VsyncProbe.h>
+
+#include <algorithm>
+#include <cwchar>
+#include <winternl.h>
+#include <d3dkmthk.h>
+#include <nvh/nvprint.hpp>
+
+namespace {
+constexpr NTSTATUS KMT_SUCCESS = 0;
+}  // namespace
+
+bool VsyncProbe::open(IDXGIOutput* output)
+{
+  close();
+  if(output == nullptr)
+  {
+    return false;
+  }
+  m_output = output;
+
+  // The scanline is queried from the adapter and video present source that scan out the output
+  DXGI_OUTPUT_DESC desc;
+  if(SUCCEEDED(output->GetDesc(&desc)))
+  {
+    D3DKMT_OPENADAPTERFROMGDIDISPLAYNAME openAdapter = {};
+    wcsncpy_s(openAdapter.DeviceName, desc.DeviceName, _TRUNCATE);
+    if(D3DKMTOpenAdapterFromGdiDisplayName(&openAdapter) == KMT_SUCCESS)
+    {
+      m_adapter       = openAdapter.hAdapter;
+      m_vidPnSourceId = openAdapter.VidPnSourceId;
+    }
+    else
+    {
+      LOGW("Could not open the adapter of %ls, scanlines are not recorded.\n", desc.DeviceName);
+    }
+  }
+
+  for(Present& present : m_presents)
+  {
+    present = {};
+  }
+  m_lastVblank           = 0;
+  m_refreshPeriod        = 0;
+  m_windowStart          = 0;
+  m_marginSum            = 0;
+  m_marginMin            = 0;
+  m_marginCount          = 0;
+  m_marginMeanMillis     = 0.0f;
+  m_marginMinMillis      = 0.0f;
+  m_displayLatencyMillis = 0.0f;
+  m_statsPresentCount    = 0;
+  m_stop                 = false;
+  m_thread               = std::thread([this]() { vblankLoop(); });
+  return true;
+}
+
+void VsyncProbe::close()
+{
+  if(m_thread.joinable())
+  {
+    // WaitForVBlank returns within a refresh period
+    m_stop = true;
+    m_thread.join();
+  }
+  if(m_adapter != 0)
+  {
+    D3DKMT_CLOSEADAPTER closeAdapter = {};
+    closeAdapter.hAdapter            = m_adapter;
+    D3DKMTCloseAdapter(&closeAdapter);
+    m_adapter = 0;
+  }
+  m_output.Reset();
+}
+
+void VsyncProbe::queryScanLine(VsyncSample& sample) const
+{
+  if(m_adapter == 0)
+  {
+    return;
+  }
+  D3DKMT_GETSCANLINE scanLine = {};
+  scanLine.hAdapter           = m_adapter;
+  scanLine.VidPnSourceId      = m_vidPnSourceId;
+  if(D3DKMTGetScanLine(&scanLine) == KMT_SUCCESS)
+  {
+    sample.m_scanLine = scanLine.ScanLine;
+    sample.m_flags |= VSYNC_SAMPLE_SCANLINE | (scanLine.InVerticalBlank ? VSYNC_SAMPLE_IN_VERTICAL_BLANK : 0);
+  }
+}
+
+void VsyncProbe::presented(IDXGISwapChain* swapChain, std::int64_t presentTime, VsyncSample& sample)
+{
+  m_scanLine          = sample.m_scanLine;
+  sample.m_vblankTime = nextVblank(presentTime);
+  if(sample.m_vblankTime != 0)
+  {
+    sample.m_flags |= VSYNC_SAMPLE_VBLANK;
+    addMargin(sample.m_vblankTime - presentTime);
+  }
+
+  UINT presentCount = 0;
+  if(SUCCEEDED(swapChain->GetLastPresentCount(&presentCount)))
+  {
+    sample.m_lastPresentCount                  = presentCount;
+    m_presents[presentCount % PRESENT_HISTORY] = {presentCount, presentTime};
+  }
+
+  // Fails with DXGI_ERROR_FRAME_STATISTICS_DISJOINT after display mode changes until the next flip
+  DXGI_FRAME_STATISTICS stats = {};
+  if(FAILED(swapChain->GetFrameStatistics(&stats)))
+  {
+    return;
+  }
+  sample.m_syncQpcTime         = stats.SyncQPCTime.QuadPart;
+  sample.m_presentCount        = stats.PresentCount;
+  sample.m_presentRefreshCount = stats.PresentRefreshCount;
+  sample.m_syncRefreshCount    = stats.SyncRefreshCount;
+  sample.m_flags |= VSYNC_SAMPLE_FRAME_STATISTICS;
+
+  // The statistics only change when another present was displayed
+  Present const& displayed = m_presents[stats.PresentCount % PRESENT_HISTORY];
+  if(stats.PresentCount != m_statsPresentCount && displayed.m_presentCount == stats.PresentCount
+     && displayed.m_presentTime != 0 && stats.SyncQPCTime.QuadPart > displayed.m_presentTime)
+  {
+    constexpr float SMOOTHING = 0.05f;
+    const float     latency   = static_cast<float>(qpcToMillis(stats.SyncQPCTime.QuadPart - displayed.m_presentTime));
+    m_displayLatencyMillis += SMOOTHING * (latency - m_displayLatencyMillis);
+  }
+  m_statsPresentCount = stats.PresentCount;
+}
+
+std::int64_t VsyncProbe::nextVblank(std::int64_t time) const
+{
+  const std::int64_t period = m_refreshPeriod;
+  const std::int64_t last   = m_lastVblank;
+  if(period == 0 || last == 0)
+  {
+    return 0;
+  }
+  const std::int64_t elapsed   = time - last;
+  const std::int64_t refreshes = elapsed >= 0 ? elapsed / period + 1 : -(-elapsed / period);
+  return last + refreshes * period;
+}
+
+void VsyncProbe::vblankLoop()
+{
+  // The timestamps are only as precise as the thread's wake-ups
+  SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+  std::int64_t last = 0;
+  while(!m_stop)
+  {
+    if(FAILED(m_output->WaitForVBlank()))
+    {
+      // e.g. the output was disconnected, the probe is re-opened by the next display mode transition
+      Sleep(10);
+      last = 0;
+      continue;
+    }
+    const std::int64_t now = qpcNow();
+    if(last != 0)
+    {
+      // Vblanks missed by the thread show up as multiples of the period
+      std::int64_t       period = m_refreshPeriod;
+      const std::int64_t delta  = now - last;
+      if(period == 0)
+      {
+        period = delta;
+      }
+      else
+      {
+        const std::int64_t refreshes = std::max<std::int64_t>((delta + period / 2) / period, 1);
+        period += (delta / refreshes - period) / 16;
+      }
+      m_refreshPeriod = period;
+    }
+    m_lastVblank = now;
+    last         = now;
+  }
+}
+
+void VsyncProbe::addMargin(std::int64_t ticks)
+{
+  m_marginSum += ticks;
+  m_marginMin = m_marginCount == 0 ? ticks : std::min(m_marginMin, ticks);
+  ++m_marginCount;
+
+  const std::int64_t now = qpcNow();
+  if(m_windowStart == 0)
+  {
+    m_windowStart = now;
+  }
+  else if(now - m_windowStart >= qpcFrequency())
+  {
+    m_marginMeanMillis = static_cast<float>(qpcToMillis(m_marginSum) / m_marginCount);
+    m_marginMinMillis  = static_cast<float>(qpcToMillis(m_marginMin));
+    m_windowStart      = now;
+    m_marginSum        = 0;
+    m_marginMin        = 0;
+    m_marginCount      = 0;
+  }
+}
@@ -0,0 +1,94 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <dxgi1_4.h>
+#include <wrl/client.h>
+using Microsoft::WRL::ComPtr;
+
+enum VsyncSampleFlags : std::uint32_t
+{
+  VSYNC_SAMPLE_VBLANK            = 0x1,  // m_vblankTime is valid
+  VSYNC_SAMPLE_SCANLINE          = 0x2,  // m_scanLine is valid
+  VSYNC_SAMPLE_IN_VERTICAL_BLANK = 0x4,  // Present was called during the vertical blank
+  VSYNC_SAMPLE_FRAME_STATISTICS  = 0x8,  // the DXGI frame statistics are valid
+};
+
+// Vblank timing of a single present, timestamps are raw QueryPerformanceCounter values. The DXGI frame statistics
+// are queried after the present and describe the most recent present that was displayed, usually an earlier one.
+struct VsyncSample
+{
+  std::int64_t  m_vblankTime          = 0;  // predicted first vblank after the present
+  std::int64_t  m_syncQpcTime         = 0;  // vblank the present m_presentCount was displayed with
+  std::uint32_t m_lastPresentCount    = 0;  // DXGI present count of this present
+  std::uint32_t m_presentCount        = 0;
+  std::uint32_t m_presentRefreshCount = 0;
+  std::uint32_t m_syncRefreshCount    = 0;
+  std::uint32_t m_scanLine            = 0;  // when Present was called
+  std::uint32_t m_flags               = 0;  // VsyncSampleFlags
+};
+
+// Correlates presents with the vblanks of the swap chain's output. A time critical thread timestamps every vblank
+// with IDXGIOutput::WaitForVBlank and measures the refresh period, the render thread predicts the next vblank from
+// them, reads the scanline with D3DKMTGetScanLine before Present and the DXGI frame statistics after it. The vblank
+// timestamps are late by the wake-up latency of the thread, typically a few microseconds.
+class VsyncProbe
+{
+public:
+  ~VsyncProbe() { close(); }
+
+  // Has to be re-opened whenever the swap chain may have moved to another output
+  bool open(IDXGIOutput* output);
+  void close();
+  bool isOpen() const { return m_thread.joinable(); }
+
+  // Render thread only, right before Present and right after it returned
+  void queryScanLine(VsyncSample& sample) const;
+  void presented(IDXGISwapChain* swapChain, std::int64_t presentTime, VsyncSample& sample);
+
+  // First vblank after the given time, 0 until the refresh period is known
+  std::int64_t nextVblank(std::int64_t time) const;
+  std::int64_t refreshPeriod() const { return m_refreshPeriod; }
+
+  // Present to predicted vblank over the last complete window of about a second, in milliseconds
+  float         marginMeanMillis() const { return m_marginMeanMillis; }
+  float         marginMinMillis() const { return m_marginMinMillis; }
+  // Exponentially smoothed time from Present to the vblank the present was displayed with
+  float         displayLatencyMillis() const { return m_displayLatencyMillis; }
+  std::uint32_t scanLine() const { return m_scanLine; }
+
+private:
+  // DXGI present counts and times of the recent presents, to find the present the frame statistics refer to
+  static constexpr std::uint32_t PRESENT_HISTORY = 16;
+  struct Present
+  {
+    std::uint32_t m_presentCount = 0;
+    std::int64_t  m_presentTime  = 0;
+  };
+
+  ComPtr<IDXGIOutput>       m_output;
+  std::thread               m_thread;
+  std::atomic<bool>         m_stop          = false;
+  std::atomic<std::int64_t> m_lastVblank    = 0;
+  std::atomic<std::int64_t> m_refreshPeriod = 0;
+  std::uint32_t             m_adapter       = 0;  // D3DKMT_HANDLE
+  std::uint32_t             m_vidPnSourceId = 0;
+
+  Present       m_presents[PRESENT_HISTORY];
+  std::int64_t  m_windowStart          = 0;
+  std::int64_t  m_marginSum            = 0;
+  std::int64_t  m_marginMin            = 0;
+  std::uint32_t m_marginCount          = 0;
+  float         m_marginMeanMillis     = 0.0f;
+  float         m_marginMinMillis      = 0.0f;
+  float         m_displayLatencyMillis = 0.0f;
+  std::uint32_t m_scanLine             = 0;
+  std::uint32_t m_statsPresentCount    = 0;  // of the last frame statistics
+
+  void vblankLoop();
+  void addMargin(std::int64_t ticks);
+};
@@ -8,11 +8,69 @@
 #define GLFW_EXPOSE_NATIVE_WIN32
 #include <GLFW/glfw3native.h>
 
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <memory>
 #include <optional>
 
 #define STRINGIFY(_x) #_x
 
-class Sample : public nvh::AppWindowProfiler, private WindowCallback
+// Hardware adapters supporting D3D12, enumerated the same way as the compatible adapters of nvdx12::Context so the
+// indices match -adapter
+static std::vector<std::string> compatibleAdapterNames()
+{
+  std::vector<std::string> names;
+  ComPtr<IDXGIFactory1>    factory;
+  if(FAILED(CreateDXGIFactory1(IID_PPV_ARGS(&factory))))
+  {
+    return names;
+  }
+  ComPtr<IDXGIAdapter1> adapter;
+  for(UINT i = 0; factory->EnumAdapters1(i, &adapter) != DXGI_ERROR_NOT_FOUND; ++i)
+  {
+    DXGI_ADAPTER_DESC1 desc;
+    adapter->GetDesc1(&desc);
+    if((desc.Flags & DXGI_ADAPTER_FLAG_SOFTWARE) == 0
+       && SUCCEEDED(D3D12CreateDevice(adapter.Get(), D3D_FEATURE_LEVEL_11_0, __uuidof(ID3D12Device), nullptr)))
+    {
+      char name[128] = {};
+      WideCharToMultiByte(CP_UTF8, 0, desc.Description, -1, name, sizeof(name), nullptr, nullptr);
+      names.push_back(name);
+    }
+  }
+  return names;
+}
+
+// Window attribute changes requested by a render thread, applied by the window thread in Sample::think
+class SampleWindow : public WindowCallback
+{
+public:
+  explicit SampleWindow(GLFWwindow* window)
+      : m_window(window)
+  {
+  }
+
+  void applyPendingChanges();
+
+  HWND        getWindowHandle() override { return glfwGetWin32Window(m_window); }
+  GLFWwindow* getGlfwWindow() override { return m_window; }
+  void        setDecorated(bool decorated) override;
+  void        setPosAndSize(int x, int y, int width, int height) override;
+
+private:
+  struct PosAndSize
+  {
+    int x, y, width, height;
+  };
+
+  GLFWwindow*               m_window = nullptr;
+  std::mutex                m_mutex;
+  std::optional<bool>       m_windowDecorated;
+  std::optional<PosAndSize> m_windowPosAndSize;
+};
+
+class Sample : public nvh::AppWindowProfiler
 {
 public:
   Sample();
@@ -30,23 +88,29 @@ public:
 
   void swapVsync(bool state) override;
 
+  // The worst validation result of all windows, valid after end()
+  int exitCode() const { return m_exitCode; }
+
 private:
-  struct PosAndSize
+  // The first window is the one of the AppWindowProfiler, additional windows render without a gui on the first
+  // window's device
+  struct ExtraWindow
   {
-    int x, y, width, height;
+    GLFWwindow*                   m_glfwWindow = nullptr;
+    std::unique_ptr<SampleWindow> m_window;
+    std::unique_ptr<RenderThread> m_renderThread;
   };
 
-  RenderThread              m_renderThread;
-  Configuration             m_initialConfig;
-  bool                      m_showCursor = true;
-  std::mutex                m_mutex;
-  std::optional<bool>       m_windowDecorated;
-  std::optional<PosAndSize> m_windowPosAndSize;
+  RenderThread                  m_renderThread;
+  std::unique_ptr<SampleWindow> m_window;
+  std::vector<ExtraWindow>      m_extraWindows;
+  PresentSkewMonitor            m_presentSkew;
+  Configuration                 m_initialConfig;
+  bool                          m_showCursor  = true;
+  bool                          m_allAdapters = false;
+  int                           m_exitCode    = EXIT_SUCCESS;
 
-  HWND        getWindowHandle() override { return glfwGetWin32Window(m_internal); }
-  GLFWwindow* getGlfwWindow() override { return m_internal; }
-  void        setDecorated(bool decorated) override;
-  void        setPosAndSize(int x, int y, int width, int height) override;
+  void forEachRenderThread(std::function<void(RenderThread&)> const& function);
 };
 
 Sample::Sample()
@@ -61,10 +125,31 @@ Sample::Sample()
   m_parameterList.add("adapter|Adapter index to render on", &m_renderThread.contextInfo().compatibleAdapterIndex);
   m_parameterList.add("a|Same as -adapter", &m_renderThread.contextInfo().compatibleAdapterIndex);
   m_parameterList.add("listadapters|Print available adapters", &m_renderThread.contextInfo().verboseCompatibleAdapters);
+  m_parameterList.add("alladapters|Render on all compatible adapters, each with its own device, render thread, and "
+                      "present barrier client, starting on its first output (or -output)",
+                      &m_allAdapters);
   m_parameterList.add("dpb|Disable present barrier", &m_initialConfig.m_disablePresentBarrier);
   m_parameterList.add("stereo|Stereoscopic rendering", &m_initialConfig.m_stereo);
+  m_parameterList.add("windows|Number of windows, each with its own swap chain and present barrier client on a shared "
+                      "device. With -output every window starts on the next output, default: 1",
+                      &m_initialConfig.m_windowCount);
+  m_parameterList.add("noviewinstancing|Render stereo eyes in separate passes even if view instancing is supported",
+                      &m_initialConfig.m_disableViewInstancing);
+  m_parameterList.add("pipelinecache|Directory of the pipeline library that keeps compiled pipelines between starts, "
+                      "default: the executable's directory",
+                      &m_initialConfig.m_pipelineCacheDirectory);
+  m_parameterList.add("nopipelinecache|Compile all pipelines on every start", &m_initialConfig.m_disablePipelineCache);
+  m_parameterList.add("nogui|Do not render or composite the statistics gui, e.g. on wall nodes nobody looks at",
+                      &m_initialConfig.m_disableGui);
+  m_parameterList.add("guiinterval|Minimum time in milliseconds between updates of the statistics gui, default: 0",
+                      &m_initialConfig.m_guiUpdateIntervalMillis);
 
   m_parameterList.add("lines|Set number of scrolling lines to show", &m_initialConfig.m_numLines);
+  m_parameterList.add("pattern|Test pattern: (l)ines, (g)rid, (d)iagonal sweep, (c)heckerboard, or per-display "
+                      "(m)arkers. All but lines are generated on the GPU, default: l",
+                      &m_initialConfig.m_linePattern);
+  m_parameterList.add("patternelements|Maximum number of lines or cells of GPU generated patterns, default: 4096",
+                      &m_initialConfig.m_patternElements);
   m_parameterList.add("linesize|Size of the scrolling lines in pixels (first value is main size, second for variation)",
                       m_initialConfig.m_lineSizeInPixels, nullptr, 2);
   m_parameterList.add("linespeed|Speed of the scrolling lines in pixels per frame", &m_initialConfig.m_lineSpeedInPixels);
@@ -74,6 +159,38 @@ Sample::Sample()
   m_parameterList.add("cursor|Show or hide mouse cursor of the operating system", &m_showCursor);
   m_parameterList.add("sleepinterval|Specifies a sleep interval in milliseconds that is added between present calls",
                       &m_initialConfig.m_sleepIntervalInMilliseconds);
+  m_parameterList.add("framepacing|Frame pacing: (s)leep (default), (w)aitable swap chain, (t)imed waitable swap "
+                      "chain with a target present period, or (j)ust-in-time: frames start as late as possible to "
+                      "present a margin before the next vblank",
+                      &m_initialConfig.m_framePacing);
+  m_parameterList.add("presentperiod|Target period between presents in microseconds for -framepacing t",
+                      &m_initialConfig.m_presentPeriodMicros);
+  m_parameterList.add("jitmargin|Time in microseconds between Present and the next vblank for -framepacing j, "
+                      "default: 1000",
+                      &m_initialConfig.m_justInTimeMarginMicros);
+  m_parameterList.add("fencewait|How the render thread waits for the GPU: (e)vent (default), (s)pin on the fence "
+                      "value, or (h)ybrid: block until -fencespin before the expected completion, then spin",
+                      &m_initialConfig.m_fenceWait);
+  m_parameterList.add("fencespin|Spin window in microseconds around the expected completion for -fencewait h, "
+                      "default: 200",
+                      &m_initialConfig.m_fenceSpinMicros);
+  m_parameterList.add("vsyncprobe|Correlate presents with the vblanks of the output: record the present to vblank "
+                      "margin, the scanline at present and the DXGI frame statistics, implied by -framepacing j",
+                      &m_initialConfig.m_vsyncProbe);
+  m_parameterList.add("threadaffinity|Hexadecimal mask of the logical processors the render threads run on, replaces "
+                      "the NUMA node placement of -alladapters",
+                      &m_initialConfig.m_threadAffinity);
+  m_parameterList.add("threadpriority|Render thread priority: (n)ormal (default), (a)bove normal, (h)ighest, or (t)ime "
+                      "critical",
+                      &m_initialConfig.m_threadPriority);
+  m_parameterList.add("mmcss|Register the render threads with this MMCSS task, e.g. \"Games\" or \"Pro Audio\"",
+                      &m_initialConfig.m_mmcssTask);
+  m_parameterList.add("timerresolution|System timer resolution in milliseconds while running, default: system default",
+                      &m_initialConfig.m_timerResolutionMillis);
+  m_parameterList.add("buffers|Number of swap chain back buffers, default: 3", &m_initialConfig.m_backBufferCount);
+  m_parameterList.add("maxlatency|Maximum number of frames queued for presentation, requires a waitable swap chain, "
+                      "default: DXGI default",
+                      &m_initialConfig.m_maxFrameLatency);
   m_parameterList.add(
       "synctimeout|Specifies a sync timeout in milliseconds that is used when waiting for all gpu work to finish (e.g. "
       "when transitioning display modes or toggling present barrier, default: 1000",
@@ -85,8 +202,116 @@ Sample::Sample()
       &m_initialConfig.m_testMode);
   m_parameterList.add("t|Same as -testmode", &m_initialConfig.m_testMode);
   m_parameterList.add("testmodeinterval|The framecount interval for -testmode, default: 120", &m_initialConfig.m_testModeInterval);
-  m_parameterList.add("framecounterfile|Frame counters of the Quadro Sync device will be logged into this file.",
-                      &m_initialConfig.m_frameCounterFilePath);
+  m_parameterList.add("transitionbench|Run this many trials of every transition kind, measure the time until the "
+                      "present barrier is back in sync, write a report and exit",
+                      &m_initialConfig.m_transitionBenchmarkTrials);
+  m_parameterList.add("transitionbenchkinds|Transition kinds of -transitionbench: any of (f)ullscreen, (b)orderless, "
+                      "(w)indows key, (s)tereo, (p)resent barrier, default: fbwsp",
+                      &m_initialConfig.m_transitionBenchmarkKinds);
+  m_parameterList.add("transitionbenchfile|JSON report of -transitionbench, default: transition_benchmark.json",
+                      &m_initialConfig.m_transitionBenchmarkFile);
+  m_parameterList.add("transitionbenchsettle|Frames the sync mode has to be stable before and between the steps of a "
+                      "trial and before every -benchmark case is measured, default: 120",
+                      &m_initialConfig.m_transitionBenchmarkSettle);
+  m_parameterList.add("benchmark|Run the regression matrix of window modes, vsync on and off, sleep intervals and GPU "
+                      "loads, write CPU and GPU frame times, present margins, in-sync ratios and resync times of "
+                      "every case to this JSON report and exit (implies -vsyncprobe)",
+                      &m_initialConfig.m_benchmarkFile);
+  m_parameterList.add("benchmarkbaseline|JSON report of an earlier -benchmark run, exit with 4 if any case regressed",
+                      &m_initialConfig.m_benchmarkBaseline);
+  m_parameterList.add("benchmarkthreshold|Percentage a metric may be worse than the baseline, default: 10",
+                      &m_initialConfig.m_benchmarkThresholdPercent);
+  m_parameterList.add("benchmarkframes|Frames measured per -benchmark case, default: 300",
+                      &m_initialConfig.m_benchmarkFrames);
+  m_parameterList.add("benchmarkmodes|Window modes of -benchmark: any of (w)indowed, (b)orderless, (f)ullscreen, "
+                      "default: wbf",
+                      &m_initialConfig.m_benchmarkModes);
+  m_parameterList.add("benchmarkstereo|Measure every -benchmark case in mono and stereo, needs a stereo display",
+                      &m_initialConfig.m_benchmarkStereo);
+  m_parameterList.add("benchmarksleep|Comma-separated sleep intervals in milliseconds of -benchmark, default: 0",
+                      &m_initialConfig.m_benchmarkSleep);
+  m_parameterList.add("benchmarkload|Comma-separated GPU load targets in milliseconds of -benchmark, 0 for the "
+                      "minimum amount of work, default: 0",
+                      &m_initialConfig.m_benchmarkLoad);
+  m_parameterList.add("minimal|Minimal content for cluster bring-up: (c)leared back buffers only or the present "
+                      "barrier (i)ndicator only, no lines and no gui",
+                      &m_initialConfig.m_minimalContent);
+  m_parameterList.add("validateframes|Validate that the present barrier reaches -validatesyncmode within this many "
+                      "frames, log a summary and exit with 0 (passed), 2 (never reached), or 3 (not in sync at the "
+                      "end)",
+                      &m_initialConfig.m_validateFrames);
+  m_parameterList.add("validateseconds|Same as -validateframes with a duration in seconds, the run ends with whichever "
+                      "limit is reached first",
+                      &m_initialConfig.m_validateSeconds);
+  m_parameterList.add("latencyflash|L flashes the sync indicator white in the next recorded frame, the log shows the "
+                      "record, present and vblank times relative to the key press",
+                      &m_initialConfig.m_latencyFlash);
+  m_parameterList.add("flashbroadcast|Send L presses as flash triggers to host:port, e.g. a broadcast address, all "
+                      "listening nodes flash at the same system time (implies -latencyflash)",
+                      &m_initialConfig.m_flashBroadcastAddress);
+  m_parameterList.add("flashport|Listen for flash triggers on this UDP port (implies -latencyflash)",
+                      &m_initialConfig.m_flashPort);
+  m_parameterList.add("flashlead|Milliseconds between sending a flash trigger and the flash, default: 100",
+                      &m_initialConfig.m_flashLeadMillis);
+  m_parameterList.add("validatesyncmode|Sync mode a validation run requires: client, system, or cluster (default)",
+                      &m_initialConfig.m_validateSyncMode);
+  m_parameterList.add("gpuload|Target GPU time in milliseconds of a synthetic load pass, the amount of work is "
+                      "adjusted every frame to hold it",
+                      &m_initialConfig.m_gpuLoadTargetMillis);
+  m_parameterList.add("gpuloadmode|Kind of synthetic GPU load: (a)lu (default), (f)ill rate, or (b)andwidth",
+                      &m_initialConfig.m_gpuLoadMode);
+  m_parameterList.add("gpuloadwork|Fixed amount of synthetic GPU work (iterations, layers, or texture loads) when no "
+                      "-gpuload target is set, initial amount otherwise",
+                      &m_initialConfig.m_gpuLoadWork);
+  m_parameterList.add("asynccompute|Run line pattern generation and the ALU GPU load on a compute queue and the gui on "
+                      "a second direct queue, alongside the frame on the presenting queue",
+                      &m_initialConfig.m_asyncCompute);
+  m_parameterList.add("framemarker|Draw the frame count and -framemarkerid as black and white cells into the top left "
+                      "corner, read them back and publish them in the telemetry for frame skew detection",
+                      &m_initialConfig.m_frameMarker);
+  m_parameterList.add("framemarkerid|Node id in the frame marker, the window index is added, default: 0",
+                      &m_initialConfig.m_frameMarkerId);
+  m_parameterList.add(
+      "framecounterfile|Present barrier present counts will be logged into this file, one per line (same as "
+      "-recordfile with -recordformat f)",
+      &m_initialConfig.m_frameCounterFilePath);
+  m_parameterList.add("recordfile|Per-frame timings and present barrier statistics will be recorded into this file",
+                      &m_initialConfig.m_recordFilePath);
+  m_parameterList.add("recordformat|Format of the -recordfile: (b)inary (default), (c)sv, or (f)ramecounter",
+                      &m_initialConfig.m_recordFormat);
+  m_parameterList.add("recordcapacity|Number of frames buffered by the frame recorder before records are dropped, "
+                      "default: 4096",
+                      &m_initialConfig.m_recordCapacity);
+  m_parameterList.add("recordmaxmb|Rotate the -recordfile and the -soakfile to <path>.1 when they exceed this many "
+                      "megabytes, default: unlimited, 256 with -soak",
+                      &m_initialConfig.m_recordMaxMegabytes);
+  m_parameterList.add("soak|Soak run: write a summary of frame times, present margins, fence waits, sync losses, GPU "
+                      "memory and handle counts every this many minutes and report values that keep rising",
+                      &m_initialConfig.m_soakIntervalMinutes);
+  m_parameterList.add("soakfile|File of the -soak summaries, default: soak.csv", &m_initialConfig.m_soakFilePath);
+  m_parameterList.add("metricsinterval|Number of frames per interval of the sync metrics plots, default: 60",
+                      &m_initialConfig.m_syncMetricsInterval);
+  m_parameterList.add("syncsampleinterval|Poll the present barrier statistics and the Quadro Sync frame counter every "
+                      "n microseconds on a low priority thread instead of after every present, default: 0 (after "
+                      "every present)",
+                      &m_initialConfig.m_syncSampleIntervalMicros);
+  m_parameterList.add("telemetry|Publish present barrier statistics via UDP to host:port (may be a broadcast address)",
+                      &m_initialConfig.m_telemetryAddress);
+  m_parameterList.add("telemetryinterval|Interval in milliseconds between telemetry packets, default: 100",
+                      &m_initialConfig.m_telemetryIntervalMillis);
+  m_parameterList.add("nodename|Name of this node in the telemetry, default: computer name",
+                      &m_initialConfig.m_nodeName);
+  m_parameterList.add(
+      "telemetrycollect|Aggregate telemetry of all nodes received on this UDP port and show it in the GUI. Use "
+      "-collector <port> as the first argument to run a headless collector instead, only followed by "
+      "-mininsyncratio and -maxpresentdrift.",
+      &m_initialConfig.m_telemetryCollectorPort);
+  m_parameterList.add("mininsyncratio|Nodes with fewer presents in sync are flagged by the collector, default: 0.99",
+                      &m_initialConfig.m_minInSyncRatio);
+  m_parameterList.add(
+      "maxpresentdrift|Nodes presenting this many frames per second less than the cluster median are flagged by the "
+      "collector, default: 0.5",
+      &m_initialConfig.m_maxPresentDriftPerSecond);
 }
 
 bool Sample::begin()
@@ -126,30 +351,157 @@ bool Sample::begin()
       VERSION_MAJOR, VERSION_MINOR, BUILD_UNCOMMITTED_CHANGES ? " (modified)" : "");
   m_initialConfig.m_winSize[0] = m_windowState.m_winSize[0];
   m_initialConfig.m_winSize[1] = m_windowState.m_winSize[1];
-  return m_renderThread.start(m_initialConfig, this);
+  // With -alladapters every compatible adapter gets its own device, -windows applies per adapter
+  std::uint32_t adapterCount = 1;
+  if(m_allAdapters)
+  {
+    const std::vector<std::string> adapters = compatibleAdapterNames();
+    for(size_t i = 0; i < adapters.size(); ++i)
+    {
+      LOGI("Adapter %zu: %s\n", i, adapters[i].c_str());
+    }
+    if(adapters.empty())
+    {
+      LOGE("No compatible adapter found.\n");
+      return false;
+    }
+    adapterCount                                        = static_cast<std::uint32_t>(adapters.size());
+    m_renderThread.contextInfo().compatibleAdapterIndex = 0;
+  }
+  const std::uint32_t windowCount = adapterCount * m_initialConfig.m_windowCount;
+  if(m_initialConfig.m_windowCount < 1 || windowCount > PresentSkewMonitor::MAX_WINDOWS)
+  {
+    LOGE("Number of windows must be between 1 and %u.\n", PresentSkewMonitor::MAX_WINDOWS);
+    return false;
+  }
+  m_presentSkew.init(windowCount);
+
+  // There is no portable way to query the NUMA node of an adapter, so adapters are assumed to be spread evenly across
+  // the NUMA nodes in enumeration order
+  ULONG highestNumaNode = 0;
+  GetNumaHighestNodeNumber(&highestNumaNode);
+  const std::uint32_t numaNodes = static_cast<std::uint32_t>(highestNumaNode) + 1;
+
+  RenderThread* adapterRenderThread = &m_renderThread;
+  for(std::uint32_t i = 0; i < windowCount; ++i)
+  {
+    const std::uint32_t adapter       = i / m_initialConfig.m_windowCount;
+    const std::uint32_t adapterWindow = i % m_initialConfig.m_windowCount;
+    m_presentSkew.setAdapter(i, adapter);
+
+    Configuration config = m_initialConfig;
+    config.m_windowIndex = i;
+    config.m_disableGui  = config.m_disableGui || i != 0;
+    if(m_allAdapters)
+    {
+      // Output indices are relative to the adapter
+      config.m_outputIndex = std::max(config.m_outputIndex, 0) + static_cast<std::int32_t>(adapterWindow);
+      if(adapterCount > 1 && numaNodes > 1)
+      {
+        config.m_numaNode = static_cast<std::int32_t>(adapter * numaNodes / adapterCount);
+      }
+    }
+    else if(config.m_outputIndex >= 0)
+    {
+      config.m_outputIndex += static_cast<std::int32_t>(i);
+    }
+
+    if(i == 0)
+    {
+      m_window = std::make_unique<SampleWindow>(m_internal);
+      if(!m_renderThread.start(config, m_window.get(), nullptr, &m_presentSkew))
+      {
+        return false;
+      }
+      continue;
+    }
+
+    // Outputs of every window go to their own files and telemetry nodes, only the first window collects telemetry
+    auto suffixed = [i](std::string const& path) {
+      return path.empty() ? path : path + "." + std::to_string(i);
+    };
+    config.m_recordFilePath         = suffixed(config.m_recordFilePath);
+    config.m_frameCounterFilePath   = suffixed(config.m_frameCounterFilePath);
+    config.m_soakFilePath           = suffixed(config.m_soakFilePath);
+    config.m_nodeName               = suffixed(config.m_nodeName.empty() ? defaultNodeName() : config.m_nodeName);
+    config.m_telemetryCollectorPort = 0;
+    config.m_flashBroadcastAddress  = "";  // the first window sends the triggers of the node
+
+    // Scripted transitions only run in the first window
+    config.m_transitionBenchmarkTrials = 0;
+    config.m_benchmarkFile             = "";
+
+    const std::string title = std::string(PROJECT_NAME) + " " + std::to_string(i);
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+    ExtraWindow extraWindow;
+    extraWindow.m_glfwWindow =
+        glfwCreateWindow(config.m_winSize[0], config.m_winSize[1], title.c_str(), nullptr, nullptr);
+    if(!extraWindow.m_glfwWindow)
+    {
+      LOGE("Could not create window %u.\n", i);
+      return false;
+    }
+    extraWindow.m_window       = std::make_unique<SampleWindow>(extraWindow.m_glfwWindow);
+    extraWindow.m_renderThread = std::make_unique<RenderThread>();
+    m_extraWindows.push_back(std::move(extraWindow));
+
+    // The first window of every adapter creates the adapter's device, all further windows of the adapter share it
+    ExtraWindow&     window        = m_extraWindows.back();
+    nvdx12::Context* sharedContext = nullptr;
+    if(adapterWindow == 0)
+    {
+      window.m_renderThread->contextInfo()                        = m_renderThread.contextInfo();
+      window.m_renderThread->contextInfo().compatibleAdapterIndex = adapter;
+      adapterRenderThread                                         = window.m_renderThread.get();
+    }
+    else
+    {
+      sharedContext = adapterRenderThread->context();
+    }
+    if(!window.m_renderThread->start(config, window.m_window.get(), sharedContext, &m_presentSkew))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+void Sample::forEachRenderThread(std::function<void(RenderThread&)> const& function)
+{
+  function(m_renderThread);
+  for(ExtraWindow& window : m_extraWindows)
+  {
+    function(*window.m_renderThread);
+  }
 }
 
 void Sample::think(double time)
 {
+  if(m_renderThread.runFinished())
+  {
+    glfwSetWindowShouldClose(m_internal, GLFW_TRUE);
+  }
+
   // Handle keyboard shortcuts that affect state
+  // Keyboard input of the first window applies to all windows
   if(m_windowState.onPress(KEY_W))
   {
     if(m_windowState.m_keyPressed[KEY_LEFT_ALT])
     {
-      m_renderThread.setSleepInterval(0);
+      forEachRenderThread([](RenderThread& renderThread) { renderThread.setSleepInterval(0); });
     }
     else if(m_windowState.m_keyPressed[KEY_LEFT_SHIFT])
     {
-      m_renderThread.changeSleepInterval(-1);
+      forEachRenderThread([](RenderThread& renderThread) { renderThread.changeSleepInterval(-1); });
     }
     else
     {
-      m_renderThread.changeSleepInterval(1);
+      forEachRenderThread([](RenderThread& renderThread) { renderThread.changeSleepInterval(1); });
     }
   }
   if(m_windowState.onPress(KEY_2))
   {
-    m_renderThread.toggleStereo();
+    forEachRenderThread([](RenderThread& renderThread) { renderThread.toggleStereo(); });
   }
 
   if(m_windowState.onPress(KEY_F))
@@ -158,44 +510,40 @@ void Sample::think(double time)
   }
   if(m_windowState.onPress(KEY_B))
   {
-    m_renderThread.requestBorderlessStateChange();
+    forEachRenderThread([](RenderThread& renderThread) { renderThread.requestBorderlessStateChange(); });
   }
   if(m_windowState.onPress(KEY_S))
   {
-    m_renderThread.togglePaused();
+    forEachRenderThread([](RenderThread& renderThread) { renderThread.togglePaused(); });
   }
   if(m_windowState.onPress(KEY_Q))
   {
-    m_renderThread.toggleQuadroSync();
+    forEachRenderThread([](RenderThread& renderThread) { renderThread.toggleQuadroSync(); });
   }
   if(m_windowState.onPress(KEY_R))
   {
-    m_renderThread.requestResetFrameCount();
+    forEachRenderThread([](RenderThread& renderThread) { renderThread.requestResetFrameCount(); });
   }
-  if(m_windowState.onPress(KEY_T) && !m_renderThread.requestPresentBarrierChange(1000))
+  if(m_windowState.onPress(KEY_L))
   {
-    m_renderThread.forcePresentBarrierChange();
+    forEachRenderThread([](RenderThread& renderThread) { renderThread.requestFlash(); });
   }
+  if(m_windowState.onPress(KEY_T))
   {
-    std::lock_guard guard(m_mutex);
-    if(m_windowDecorated.has_value())
-    {
-      glfwSetWindowAttrib(m_internal, GLFW_DECORATED, m_windowDecorated.value() ? 1 : 0);
-      m_windowDecorated.reset();
-    }
-    if(m_windowPosAndSize.has_value())
-    {
-      glfwSetWindowPos(m_internal, m_windowPosAndSize.value().x, m_windowPosAndSize.value().y);
-      glfwSetWindowSize(m_internal, m_windowPosAndSize.value().width, m_windowPosAndSize.value().height);
-      m_windowPosAndSize.reset();
-    }
+    // Transitions time out on the render thread, so the window thread never waits for them
+    forEachRenderThread([](RenderThread& renderThread) { renderThread.requestPresentBarrierChange(0); });
+  }
+  m_window->applyPendingChanges();
+  for(ExtraWindow& window : m_extraWindows)
+  {
+    window.m_window->applyPendingChanges();
   }
   //Sleep(100);
 }
 
 void Sample::swapVsync(bool state)
 {
-  m_renderThread.setVsync(state);
+  forEachRenderThread([state](RenderThread& renderThread) { renderThread.setVsync(state); });
 }
 
 void Sample::end()
@@ -205,16 +553,46 @@ void Sample::end()
   {
     ShowCursor(TRUE);
   }
+
+  // Windows share the device of the first window of their adapter, which is always created before them. Join in
+  // reverse so every context outlives the threads borrowing it, the first window owns its context and goes last.
+  for(auto window = m_extraWindows.rbegin(); window != m_extraWindows.rend(); ++window)
+  {
+    window->m_renderThread->interruptAndJoin();
+  }
   m_renderThread.interruptAndJoin();
+  forEachRenderThread(
+      [this](RenderThread& renderThread) { m_exitCode = std::max(m_exitCode, renderThread.exitCode()); });
+  for(ExtraWindow& window : m_extraWindows)
+  {
+    glfwDestroyWindow(window.m_glfwWindow);
+  }
+  m_extraWindows.clear();
 }
 
-void Sample::setDecorated(bool decorated)
+void SampleWindow::applyPendingChanges()
+{
+  std::lock_guard guard(m_mutex);
+  if(m_windowDecorated.has_value())
+  {
+    glfwSetWindowAttrib(m_window, GLFW_DECORATED, m_windowDecorated.value() ? 1 : 0);
+    m_windowDecorated.reset();
+  }
+  if(m_windowPosAndSize.has_value())
+  {
+    glfwSetWindowPos(m_window, m_windowPosAndSize.value().x, m_windowPosAndSize.value().y);
+    glfwSetWindowSize(m_window, m_windowPosAndSize.value().width, m_windowPosAndSize.value().height);
+    m_windowPosAndSize.reset();
+  }
+}
+
+void SampleWindow::setDecorated(bool decorated)
 {
   std::lock_guard guard(m_mutex);
   m_windowDecorated = decorated;
 }
 
-void Sample::setPosAndSize(int x, int y, int width, int height)
+void SampleWindow::setPosAndSize(int x, int y, int width, int height)
 {
   std::lock_guard guard(m_mutex);
   m_windowPosAndSize = {x, y, width, height};
@@ -224,6 +602,32 @@ int main(int argc, const char** argv)
 {
   NVPSystem system(PROJECT_NAME);
 
-  Sample sample;
-  return sample.run(PROJECT_NAME, argc, argv, 800, 600, false);
+  // Headless telemetry collector, does not open a window or touch the GPU
+  if(argc >= 3 && strcmp(argv[1], "-collector") == 0)
+  {
+    // Only the thresholds apply to the aggregated data, everything else configures a rendering instance
+    Configuration config;
+    for(int i = 3; i < argc; i += 2)
+    {
+      if(i + 1 < argc && strcmp(argv[i], "-mininsyncratio") == 0)
+      {
+        config.m_minInSyncRatio = static_cast<float>(atof(argv[i + 1]));
+      }
+      else if(i + 1 < argc && strcmp(argv[i], "-maxpresentdrift") == 0)
+      {
+        config.m_maxPresentDriftPerSecond = static_cast<float>(atof(argv[i + 1]));
+      }
+      else
+      {
+        LOGE("-collector <port> only takes -mininsyncratio <ratio> and -maxpresentdrift <frames> as well.\n");
+        return EXIT_FAILURE;
+      }
+    }
+    return runTelemetryCollector(static_cast<std::uint16_t>(atoi(argv[2])), config.m_minInSyncRatio,
+                                 config.m_maxPresentDriftPerSecond);
+  }
+
+  Sample    sample;
+  const int result = sample.run(PROJECT_NAME, argc, argv, 800, 600, false);
+  return result == EXIT_SUCCESS ? sample.exitCode() : result;
 }
\ No newline at end of file
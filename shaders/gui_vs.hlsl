@@ -1,6 +1,9 @@
 // Copyright 2020-2021 NVIDIA Corporation
 // SPDX-License-Identifier: Apache-2.0
 
+#include "root_signature.hlsli"
+
+[RootSignature(ROOT_SIGNATURE)]
 float4 main(uint vid
             : SV_VertexID)
     : SV_Position
@@ -1,10 +1,10 @@
 // Copyright 2020-2021 NVIDIA Corporation
 // SPDX-License-Identifier: Apache-2.0
 
-cbuffer LineConstants : register(b0)
+// Must match IndicatorConstants in RenderThread.h
+cbuffer IndicatorConstants : register(b0)
 {
     float3 color;
-    float unused[7];
 };
 
 static const float4 positions[] =
@@ -0,0 +1,82 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+// Permutations are selected at build time by the including file: HORIZONTAL for horizontal instead of vertical lines,
+// VIEW_INSTANCING to render both stereo eyes in one pass
+
+cbuffer LineConstants : register(b0)
+{
+  float verticalSizeA;
+  float verticalSizeB;
+  float horizontalSizeA;
+  float horizontalSizeB;
+  float verticalOffset;
+  float horizontalOffset;
+  float verticalSpacing;
+  float horizontalSpacing;
+  uint1 passEye;                 // eye of the pass, unused with view instancing
+  uint1 horizontalInstanceBase;  // vertical line count, horizontal lines continue the size pattern after them
+};
+
+#ifdef HORIZONTAL
+#define LINE_SIZE_A horizontalSizeA
+#define LINE_SIZE_B horizontalSizeB
+#define LINE_OFFSET horizontalOffset
+#define LINE_SPACING horizontalSpacing
+#else
+#define LINE_SIZE_A verticalSizeA
+#define LINE_SIZE_B verticalSizeB
+#define LINE_OFFSET verticalOffset
+#define LINE_SPACING verticalSpacing
+#endif
+
+#ifdef VIEW_INSTANCING
+// Both eyes are rendered in one pass, the view takes the place of passEye and the offsets don't include the eye
+void main(uint       idx : SV_VertexID,
+          uint       instance : SV_InstanceID,
+          uint       viewId : SV_ViewID,
+          out float4 position : SV_Position,
+          out float3 col : LINE_COLOR)
+{
+  const uint eye = viewId;
+#else
+void main(uint       idx : SV_VertexID,
+          uint       instance : SV_InstanceID,
+          out float4 position : SV_Position,
+          out float3 col : LINE_COLOR)
+{
+  const uint eye = passEye;
+#endif
+#ifdef HORIZONTAL
+  col = float3(eye, 1, 0);
+#else
+  col = float3(1, 0, eye);
+#endif
+
+  float offset = LINE_OFFSET;
+#ifdef VIEW_INSTANCING
+  offset += eye * LINE_SIZE_B;
+#endif
+  // Add an offset for every instance so lines have some spacing between them
+  offset += instance * LINE_SPACING;
+  // Wrap around at the screen borders, offsets are never negative
+  offset = frac(offset);
+
+  // Variate the line size every few lines break up the pattern, counted over the lines of both orientations
+#ifdef HORIZONTAL
+  const uint sizeInstance = horizontalInstanceBase + instance;
+#else
+  const uint sizeInstance = instance;
+#endif
+  const float size = (sizeInstance % 3) == 0 ? LINE_SIZE_B : LINE_SIZE_A;
+
+  // Generate vertices for a quad that stretches across the screen in one dimension and has a fixed size in the other
+  // dimension
+  const float a = (idx < 2 ? -1.0 : 1.0);
+  const float b = (idx % 2 ? -size : size) + (offset * 2 - 1);
+#ifdef HORIZONTAL
+  position = float4(a, b, 0.5, 1.0);
+#else
+  position = float4(b, a, 0.5, 1.0);
+#endif
+}
@@ -0,0 +1,5 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#define HORIZONTAL
+#include "line.hlsli"
@@ -0,0 +1,6 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+// Shader model 6.1 variant for single-pass stereo via view instancing
+#define VIEW_INSTANCING
+#include "line.hlsli"
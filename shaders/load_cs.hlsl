@@ -0,0 +1,28 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+cbuffer LoadConstants : register(b0)
+{
+  uint1 mode;  // see GpuLoadMode, only the ALU load runs on the compute queue
+  uint1 work;
+  uint1 seed;
+  float opacity;  // zero, but only known at runtime so the work can't be optimized away
+};
+
+RWStructuredBuffer<float> g_result : register(u0);
+
+// The ALU load of load_ps.hlsl with one thread per pixel and eye of the window, dispatched on the async compute queue
+[numthreads(8, 8, 1)]
+void main(uint3 threadId : SV_DispatchThreadID)
+{
+  float3 result = float3(threadId.xy * 0.001, 0.0);
+  // Dependent math so iterations can't be interleaved
+  for(uint i = 0; i < work; ++i)
+  {
+    result = frac(sin(result.yzx * 12.9898 + i) * 43758.5453);
+  }
+  if(opacity != 0.0)
+  {
+    g_result[(threadId.x + threadId.y * 8 + seed) % 64] = result.x + result.y + result.z;
+  }
+}
@@ -0,0 +1,38 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+cbuffer LoadConstants : register(b0)
+{
+  uint1 mode;  // see GpuLoadMode
+  uint1 work;
+  uint1 seed;
+  float opacity;  // zero, but only known at runtime so the work can't be optimized away
+};
+
+Texture2D<float4> g_loadTexture : register(t0);
+
+float4 main(float4 pos : SV_Position) : SV_Target
+{
+  float3 result = float3(pos.xy * 0.001, 0.0);
+  if(mode == 0)
+  {
+    // Dependent math so iterations can't be interleaved
+    for(uint i = 0; i < work; ++i)
+    {
+      result = frac(sin(result.yzx * 12.9898 + i) * 43758.5453);
+    }
+  }
+  else if(mode == 2)
+  {
+    // Scattered loads so most of them miss the caches
+    uint width, height;
+    g_loadTexture.GetDimensions(width, height);
+    uint2 coord = uint2(pos.xy) + seed;
+    for(uint i = 0; i < work; ++i)
+    {
+      coord = coord * 1664525 + 1013904223;
+      result += g_loadTexture.Load(int3(coord.x % width, coord.y % height, 0)).rgb;
+    }
+  }
+  return float4(result, opacity);
+}
@@ -0,0 +1,18 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+cbuffer MarkerConstants : register(b0)
+{
+  uint1 frame;
+  uint1 nodeAndCheck;
+  uint1 cellSize;
+  uint1 padding;
+};
+
+// One cell per bit from left to right, least significant bit first, drawn through a scissor rect around the cells
+float4 main(float4 pos : SV_Position) : SV_Target
+{
+  const uint bit  = uint(pos.x) / cellSize;
+  const uint word = bit < 32 ? frame : nodeAndCheck;
+  return ((word >> (bit % 32)) & 1) != 0 ? float4(1, 1, 1, 1) : float4(0, 0, 0, 1);
+}
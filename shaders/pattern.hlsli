@@ -0,0 +1,26 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+// Must match PatternConstants in RenderThread.h
+cbuffer PatternConstants : register(b0)
+{
+  uint1 pattern;  // see LinePattern
+  uint1 elementCount;
+  uint1 frame;
+  uint1 speed;  // in pixels per frame
+  float width;
+  float height;
+  float lineSize;  // in pixels
+  float cellSize;  // in pixels
+  uint1 display;   // index of the window, so every display shows its own markers
+  uint1 passEye;   // eye of the pass, unused with view instancing
+};
+
+// A line segment with a thickness in pixels, elements with zero thickness are not visible
+struct PatternElement
+{
+  float2 begin;
+  float2 end;
+  float  halfWidth;
+  float3 color;
+};
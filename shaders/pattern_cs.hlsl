@@ -0,0 +1,90 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "pattern.hlsli"
+
+RWStructuredBuffer<PatternElement> g_elements : register(u0);
+
+PatternElement segment(float2 begin, float2 end, float halfWidth, float3 color)
+{
+  PatternElement element;
+  element.begin     = begin;
+  element.end       = end;
+  element.halfWidth = halfWidth;
+  element.color     = color;
+  return element;
+}
+
+PatternElement square(float2 center, float halfSize, float3 color)
+{
+  return segment(center - float2(halfSize, 0), center + float2(halfSize, 0), halfSize, color);
+}
+
+// One element per thread, the offsets are integers so they don't lose precision when the frame count gets large
+[numthreads(64, 1, 1)]
+void main(uint3 threadId : SV_DispatchThreadID)
+{
+  const uint i = threadId.x;
+  if(i >= elementCount)
+  {
+    return;
+  }
+
+  const uint     scroll  = frame * speed;
+  PatternElement element = segment(0, 0, 0, 0);
+  switch(pattern)
+  {
+    case 1:
+    {
+      // Grid: even elements are vertical lines, odd elements horizontal lines, both evenly spaced and scrolling
+      const uint lines = (elementCount + 1) / 2;
+      const uint line  = i / 2;
+      if(i % 2 == 0)
+      {
+        const float x = (uint(line * width / lines) + scroll) % uint(width);
+        element       = segment(float2(x, 0), float2(x, height), lineSize * 0.5, float3(1, 0, 0));
+      }
+      else
+      {
+        const float y = (uint(line * height / lines) + scroll) % uint(height);
+        element       = segment(float2(0, y), float2(width, y), lineSize * 0.5, float3(0, 1, 0));
+      }
+      break;
+    }
+    case 2:
+    {
+      // Diagonal sweep: 45 degree lines moving to the right, they start up to a screen height left of the screen
+      const uint  span = uint(width + height);
+      const float x    = float((uint(i * float(span) / elementCount) + scroll) % span) - height;
+      element          = segment(float2(x, 0), float2(x + height, height), lineSize * 0.5, float3(1, 1, 0));
+      break;
+    }
+    case 3:
+    {
+      // Checkerboard: the cells flip every frame, a tear shows as a seam between flipped and not yet flipped cells
+      const uint columns = uint(ceil(width / cellSize));
+      const uint column  = i % columns;
+      const uint row     = i / columns;
+      if((column + row + frame) % 2 == 0 && row * cellSize < height)
+      {
+        element = square((float2(column, row) + 0.5) * cellSize, cellSize * 0.5, float3(1, 1, 1));
+      }
+      break;
+    }
+    case 4:
+    {
+      // Markers: a column of markers that moves one cell per frame, starting at another column on every display. A
+      // camera sees the frame as the marker column, and a tear as markers that are not in one column.
+      const uint columns = max(uint(width / cellSize), 1);
+      const uint rows    = uint(height / cellSize);
+      if(i < rows)
+      {
+        const uint   column = (frame + display * 7) % columns;
+        const float3 color  = float3(display % 2, (display / 2) % 2, 1 - (display / 4) % 2);
+        element             = square((float2(column, i) + 0.5) * cellSize, cellSize * 0.4, color);
+      }
+      break;
+    }
+  }
+  g_elements[i] = element;
+}
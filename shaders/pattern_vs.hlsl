@@ -0,0 +1,33 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "pattern.hlsli"
+
+StructuredBuffer<PatternElement> g_elements : register(t1);
+
+#ifdef VIEW_INSTANCING
+void main(uint       idx : SV_VertexID,
+          uint       instance : SV_InstanceID,
+          uint       viewId : SV_ViewID,
+          out float4 position : SV_Position,
+          out float3 col : LINE_COLOR)
+{
+  const uint eye = viewId;
+#else
+void main(uint       idx : SV_VertexID,
+          uint       instance : SV_InstanceID,
+          out float4 position : SV_Position,
+          out float3 col : LINE_COLOR)
+{
+  const uint eye = passEye;
+#endif
+  // Every instance is one element, the right eye has its colors rotated
+  const PatternElement element = g_elements[instance];
+  col = eye ? element.color.gbr : element.color;
+
+  // Generate the vertices of a quad around the segment, its thickness extends to both sides
+  const float2 direction = normalize(element.end - element.begin + float2(1e-6, 0));
+  const float2 normal    = float2(-direction.y, direction.x) * element.halfWidth;
+  const float2 pixel     = (idx < 2 ? element.begin : element.end) + (idx % 2 ? -normal : normal);
+  position               = float4(pixel.x / width * 2 - 1, 1 - pixel.y / height * 2, 0.5, 1.0);
+}
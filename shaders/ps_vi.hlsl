@@ -0,0 +1,5 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+// Shader model 6.1 variant, compiled like the other shaders of the view instanced pipelines
+#include "ps.hlsl"
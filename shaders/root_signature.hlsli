@@ -0,0 +1,13 @@
+// Copyright 2020-2021 NVIDIA Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+// Root signature shared by all pipelines, serialized at build time into gui_vs as version 1.1 (the compiler default)
+// and created from its embedded binary. Must match the root parameter indices used by RenderThread. Constants of
+// every pass are suballocated from the per-frame upload ring and bound as a root CBV, static while the draws execute.
+// The pattern buffer is written by a compute pass and read by the following draws of the same frame, so it is
+// volatile.
+#define ROOT_SIGNATURE                                                                                                 \
+  "CBV(b0, flags = DATA_STATIC_WHILE_SET_AT_EXECUTE),"                                                                 \
+  "DescriptorTable(SRV(t0), visibility = SHADER_VISIBILITY_PIXEL),"                                                    \
+  "UAV(u0, flags = DATA_VOLATILE),"                                                                                    \
+  "SRV(t1, flags = DATA_VOLATILE, visibility = SHADER_VISIBILITY_VERTEX)"